@@ -8,6 +8,7 @@
  */
 /*---------------------------------------------------------------------------*/
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <stddef.h>
 #include <string.h>
@@ -46,6 +47,8 @@ void Arguments_create( Arguments* args,
   args->argc = argc;
   args->argv_unconsumed = (char**) malloc( argc * sizeof( char* ) );
   args->argstring = 0;
+  args->nconsumed = 0;
+  args->consumed = NULL;
 
   for( i=0; i<argc; ++i )
   {
@@ -72,6 +75,8 @@ void Arguments_create_from_string( Arguments*  args,
 
   args->argv_unconsumed[0] = & args->argstring[len];
   args->argc = 1;
+  args->nconsumed = 0;
+  args->consumed = NULL;
 
   /*---Parse string, convert to args---*/
   Bool_t is_delim_prev = Bool_true;
@@ -92,6 +97,31 @@ void Arguments_create_from_string( Arguments*  args,
   }
 } /*---Arguments_create_from_string---*/
 
+/*===========================================================================*/
+/* Pseudo-constructor that copies the unconsumed entries of another---*/
+
+/*---NOTE: the copy refers to the argument strings of the source, which
+     must therefore outlive it---*/
+
+void Arguments_create_copy( Arguments*       args,
+                            const Arguments* args_source )
+{
+  Assert( args != NULL );
+  Assert( args_source != NULL );
+  int i = 0;
+
+  args->argc = args_source->argc;
+  args->argv_unconsumed = (char**) malloc( args->argc * sizeof( char* ) );
+  args->argstring = 0;
+  args->nconsumed = 0;
+  args->consumed = NULL;
+
+  for( i=0; i<args->argc; ++i )
+  {
+    args->argv_unconsumed[i] = args_source->argv_unconsumed[i];
+  }
+} /*---Arguments_create_copy---*/
+
 /*===========================================================================*/
 /* Pseudo-destructor for Arguments struct---*/
 
@@ -104,18 +134,56 @@ void Arguments_destroy( Arguments* args )
   {
     free( (void*) args->argstring );
   }
+
+  int i = 0;
+  for( i=0; i<2*args->nconsumed; ++i )
+  {
+    free( (void*) args->consumed[i] );
+  }
+  free( (void*) args->consumed );
+  args->nconsumed = 0;
+  args->consumed = NULL;
 } /*---Arguments_destroy---*/
 
 /*===========================================================================*/
-/* Determine whether an argument with a given name exists---*/
+/* Record an argument as consumed, with its value---*/
 
-Bool_t Arguments_exists( const Arguments*  args,
-                         const char* arg_name )
+static void Arguments_record_( Arguments*  args,
+                               const char* arg_name,
+                               const char* value )
 {
   Assert( args != NULL );
   Assert( arg_name != NULL );
 
-  Bool_t result = Bool_false;
+  args->consumed = (char**) realloc( (void*) args->consumed,
+                              2 * ( args->nconsumed + 1 ) * sizeof( char* ) );
+
+  char* name = (char*) malloc( ( strlen( arg_name ) + 1 ) * sizeof( char ) );
+  strcpy( name, arg_name );
+  args->consumed[ 2*args->nconsumed ] = name;
+
+  args->consumed[ 2*args->nconsumed + 1 ] = NULL;
+  if( value )
+  {
+    char* value_copy = (char*) malloc( ( strlen( value ) + 1 ) *
+                                                            sizeof( char ) );
+    strcpy( value_copy, value );
+    args->consumed[ 2*args->nconsumed + 1 ] = value_copy;
+  }
+
+  args->nconsumed++;
+}
+
+/*===========================================================================*/
+/* Consume the value of an argument if present, else return NULL---*/
+
+static const char* Arguments_consume_value_( Arguments*  args,
+                                             const char* arg_name )
+{
+  Assert( args != NULL );
+  Assert( arg_name != NULL );
+
+  const char* result = NULL;
   int i = 0;
 
   for( i=0; i<args->argc; ++i )
@@ -124,24 +192,29 @@ Bool_t Arguments_exists( const Arguments*  args,
     {
       continue;
     }
-    result = result || strcmp( args->argv_unconsumed[i], arg_name ) == 0;
+    if( strcmp( args->argv_unconsumed[i], arg_name ) == 0 )
+    {
+      args->argv_unconsumed[i] = NULL;
+      ++i;
+      Insist( i<args->argc ? "Missing value for argument." : 0 );
+      result = args->argv_unconsumed[i];
+      args->argv_unconsumed[i] = NULL;
+    }
   }
 
   return result;
 }
 
 /*===========================================================================*/
-/* Process an argument of type int, remove from list---*/
+/* Determine whether an argument with a given name exists---*/
 
-int Arguments_consume_int_( Arguments*  args,
-                            const char* arg_name )
+Bool_t Arguments_exists( const Arguments*  args,
+                         const char* arg_name )
 {
   Assert( args != NULL );
   Assert( arg_name != NULL );
 
-  int result = 0;
-  Bool_t found = Bool_false;
-  if( found ) {} /*---Remove unused var warning---*/
+  Bool_t result = Bool_false;
   int i = 0;
 
   for( i=0; i<args->argc; ++i )
@@ -150,21 +223,28 @@ int Arguments_consume_int_( Arguments*  args,
     {
       continue;
     }
-    if( strcmp( args->argv_unconsumed[i], arg_name ) == 0 )
-    {
-      found = Bool_true;
-      args->argv_unconsumed[i] = NULL;
-      ++i;
-      Insist( i<args->argc );
-      result = atoi( args->argv_unconsumed[i] );
-      args->argv_unconsumed[i] = NULL;
-    }
+    result = result || strcmp( args->argv_unconsumed[i], arg_name ) == 0;
   }
 
-  Insist( found ? "Invalid use of argument." : 0 );
   return result;
 }
 
+/*===========================================================================*/
+/* Process an argument of type int, remove from list---*/
+
+int Arguments_consume_int_( Arguments*  args,
+                            const char* arg_name )
+{
+  Assert( args != NULL );
+  Assert( arg_name != NULL );
+
+  const char* value = Arguments_consume_value_( args, arg_name );
+
+  Insist( value ? "Invalid use of argument." : 0 );
+  Arguments_record_( args, arg_name, value );
+  return atoi( value );
+}
+
 /*===========================================================================*/
 /* Consume an argument of type int, if not present then set to a default---*/
 
@@ -175,8 +255,56 @@ int Arguments_consume_int_or_default( Arguments*  args,
   Assert( args != NULL );
   Assert( arg_name != NULL );
 
-  return Arguments_exists( args, arg_name ) ?
-                     Arguments_consume_int_( args, arg_name ) : default_value;
+  if( Arguments_exists( args, arg_name ) )
+  {
+    return Arguments_consume_int_( args, arg_name );
+  }
+
+  char value[32];
+  sprintf( value, "%i", default_value );
+  Arguments_record_( args, arg_name, value );
+  return default_value;
+}
+
+/*===========================================================================*/
+/* Consume an argument of type string, if not present then set to a default---*/
+
+const char* Arguments_consume_string_or_default( Arguments*  args,
+                                                 const char* arg_name,
+                                                 const char* default_value )
+{
+  Assert( args != NULL );
+  Assert( arg_name != NULL );
+
+  const char* value = Arguments_consume_value_( args, arg_name );
+  const char* result = value ? value : default_value;
+
+  Arguments_record_( args, arg_name, result );
+  return result;
+}
+
+/*===========================================================================*/
+/* Consume an argument of type double, if not present then set to a default---*/
+
+double Arguments_consume_double_or_default( Arguments*  args,
+                                            const char* arg_name,
+                                            double      default_value )
+{
+  Assert( args != NULL );
+  Assert( arg_name != NULL );
+
+  const char* value = Arguments_consume_value_( args, arg_name );
+
+  if( value )
+  {
+    Arguments_record_( args, arg_name, value );
+    return atof( value );
+  }
+
+  char value_default[32];
+  sprintf( value_default, "%.17g", default_value );
+  Arguments_record_( args, arg_name, value_default );
+  return default_value;
 }
 
 /*===========================================================================*/
@@ -197,6 +325,37 @@ Bool_t Arguments_are_all_consumed( const Arguments* args )
   return result;
 }
 
+/*===========================================================================*/
+/* Number of arguments consumed, including those set to a default---*/
+
+int Arguments_nconsumed( const Arguments* args )
+{
+  Assert( args != NULL );
+
+  return args->nconsumed;
+}
+
+/*===========================================================================*/
+/* Name, value of a consumed argument; value is NULL if defaulted to NULL---*/
+
+const char* Arguments_consumed_name( const Arguments* args, int i )
+{
+  Assert( args != NULL );
+  Assert( i >= 0 && i < args->nconsumed );
+
+  return args->consumed[ 2*i ];
+}
+
+/*---------------------------------------------------------------------------*/
+
+const char* Arguments_consumed_value( const Arguments* args, int i )
+{
+  Assert( args != NULL );
+  Assert( i >= 0 && i < args->nconsumed );
+
+  return args->consumed[ 2*i + 1 ];
+}
+
 /*===========================================================================*/
   
 #ifdef __cplusplus_IGNORE
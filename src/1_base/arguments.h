@@ -40,6 +40,9 @@ typedef struct
   int    argc;
   char** argv_unconsumed; /*---Working copy of argument list---*/
   char*  argstring;
+  int    nconsumed;
+  char** consumed;        /*---Name, value of each consumed, or defaulted,
+                               argument, for reporting---*/
 } Arguments;
 
 /*===========================================================================*/
@@ -60,6 +63,12 @@ void Arguments_create( Arguments* args,
 void Arguments_create_from_string( Arguments*  args,
                                    const char* argstring );
 
+/*===========================================================================*/
+/* Pseudo-constructor that copies the unconsumed entries of another---*/
+
+void Arguments_create_copy( Arguments*       args,
+                            const Arguments* args_source );
+
 /*===========================================================================*/
 /* Pseudo-destructor for Arguments struct---*/
 
@@ -84,11 +93,37 @@ int Arguments_consume_int_or_default( Arguments*  args,
                                       const char* arg_name,
                                       int         default_value );
 
+/*===========================================================================*/
+/* Consume an argument of type string, if not present then set to a default---*/
+
+const char* Arguments_consume_string_or_default( Arguments*  args,
+                                                 const char* arg_name,
+                                                 const char* default_value );
+
+/*===========================================================================*/
+/* Consume an argument of type double, if not present then set to a default---*/
+
+double Arguments_consume_double_or_default( Arguments*  args,
+                                            const char* arg_name,
+                                            double      default_value );
+
 /*===========================================================================*/
 /* Determine whether all arguments have been consumed---*/
 
 Bool_t Arguments_are_all_consumed( const Arguments* args );
 
+/*===========================================================================*/
+/* Number of arguments consumed, including those set to a default---*/
+
+int Arguments_nconsumed( const Arguments* args );
+
+/*===========================================================================*/
+/* Name, value of a consumed argument; value is NULL if defaulted to NULL---*/
+
+const char* Arguments_consumed_name( const Arguments* args, int i );
+
+const char* Arguments_consumed_value( const Arguments* args, int i );
+
 /*===========================================================================*/
 
 #ifdef __cplusplus_IGNORE
@@ -0,0 +1,518 @@
+/*---------------------------------------------------------------------------*/
+/*!
+ * \file   counters.cpp
+ * \author agent
+ * \date   Mon Oct 19 03:33:22 UTC 2026
+ * \brief  Hardware performance counters via perf_event_open, definitions.
+ */
+/*---------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef USE_PERF_EVENT
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "types.h"
+#include "env.h"
+#include "env_openmp_kernels.h"
+#include "pointer.h"
+#include "profiler.h"
+
+#include "counters.h"
+
+#ifdef __cplusplus_IGNORE
+extern "C"
+{
+#endif
+
+/*===========================================================================*/
+/*---Counters of one thread, padded so threads do not share cache lines---*/
+
+enum{ COUNTERS_NTHREAD_MAX = 256 };
+
+/*---Entry COUNTERS_NEVENT of each count holds the elapsed time in ns---*/
+
+enum{ COUNTERS_NVALUE = COUNTERS_NEVENT + 1 };
+
+typedef struct
+{
+  int       is_open;
+  long      tid;                        /*---OS thread the group is on---*/
+  int       fd[COUNTERS_NEVENT];        /*---fd[0] leads the group---*/
+  int       slot[COUNTERS_NEVENT];      /*---Place in group read, or -1---*/
+  long long begin[COUNTERS_NREGION][COUNTERS_NVALUE];
+  long long count[COUNTERS_NREGION][COUNTERS_NVALUE];
+  long long ncall[COUNTERS_NREGION];
+  char      pad_[64];
+} Counters_Thread_;
+
+static Counters_Thread_ counters_thread_[COUNTERS_NTHREAD_MAX];
+
+static int       counters_level_      = 0;
+static long long counters_raw_config_ = 0;
+static int       counters_errno_      = 0;
+
+/*===========================================================================*/
+/*---Open the group of counters of the calling thread---*/
+/*---pseudo-private member function---*/
+
+static void Counters_open_( Counters_Thread_* thread )
+{
+  int e = 0;
+
+  for( e=0; e<COUNTERS_NEVENT; ++e )
+  {
+    thread->fd[e] = -1;
+    thread->slot[e] = -1;
+  }
+
+#ifdef USE_PERF_EVENT
+  int nslot = 0;
+
+  for( e=0; e<COUNTERS_NEVENT; ++e )
+  {
+    struct perf_event_attr attr;
+    memset( (void*)&attr, 0, sizeof(attr) );
+    attr.size           = sizeof(attr);
+    attr.read_format    = PERF_FORMAT_GROUP;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+
+    const unsigned long long cache_read_miss =
+      ( ( (unsigned long long) PERF_COUNT_HW_CACHE_OP_READ     ) <<  8 ) |
+      ( ( (unsigned long long) PERF_COUNT_HW_CACHE_RESULT_MISS ) << 16 );
+
+    switch( e )
+    {
+      case COUNTERS_CYCLES:
+        attr.type   = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+      case COUNTERS_INSTRUCTIONS:
+        attr.type   = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+      case COUNTERS_L1D_MISSES:
+        attr.type   = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_L1D | cache_read_miss;
+        break;
+      case COUNTERS_LLC_MISSES:
+        attr.type   = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_LL | cache_read_miss;
+        break;
+      default:
+        attr.type   = PERF_TYPE_RAW;
+        attr.config = counters_raw_config_;
+    }
+
+    if( e == COUNTERS_RAW && counters_raw_config_ == 0 )
+    {
+      continue;
+    }
+
+    /*---Without a leader no event is counted---*/
+
+    if( e != COUNTERS_CYCLES && thread->fd[COUNTERS_CYCLES] < 0 )
+    {
+      break;
+    }
+
+    thread->fd[e] = (int) syscall( __NR_perf_event_open, &attr, 0, -1,
+                                   thread->fd[COUNTERS_CYCLES], 0 );
+    if( thread->fd[e] < 0 )
+    {
+      counters_errno_ = errno;
+      continue;
+    }
+    thread->slot[e] = nslot++;
+  }
+
+  thread->tid = (long) syscall( SYS_gettid );
+#endif
+
+  thread->is_open = Bool_true;
+}
+
+/*===========================================================================*/
+/*---Close the group of counters of a thread---*/
+/*---pseudo-private member function---*/
+
+static void Counters_close_( Counters_Thread_* thread )
+{
+#ifdef USE_PERF_EVENT
+  int e = 0;
+
+  /*---Members before the leader---*/
+
+  for( e=COUNTERS_NEVENT-1; e>=0; --e )
+  {
+    if( thread->fd[e] >= 0 )
+    {
+      close( thread->fd[e] );
+    }
+    thread->fd[e] = -1;
+  }
+#endif
+
+  thread->is_open = Bool_false;
+}
+
+/*===========================================================================*/
+/*---Read counters and time of the calling thread---*/
+/*---pseudo-private member function---*/
+
+static void Counters_read_( Counters_Thread_* thread, long long* values )
+{
+  int e = 0;
+
+  for( e=0; e<COUNTERS_NEVENT; ++e )
+  {
+    values[e] = 0;
+  }
+
+#ifdef USE_PERF_EVENT
+  unsigned long long buf[ 1 + COUNTERS_NEVENT ];
+
+  if( thread->fd[COUNTERS_CYCLES] >= 0 &&
+      read( thread->fd[COUNTERS_CYCLES], buf, sizeof(buf) ) > 0 )
+  {
+    for( e=0; e<COUNTERS_NEVENT; ++e )
+    {
+      if( thread->slot[e] >= 0 && thread->slot[e] < (int) buf[0] )
+      {
+        values[e] = (long long) buf[ 1 + thread->slot[e] ];
+      }
+    }
+  }
+#endif
+
+  values[COUNTERS_NEVENT] = Profiler_time_ns();
+}
+
+/*===========================================================================*/
+/*---Start counting at a level---*/
+
+void Counters_start( int level, long long raw_config )
+{
+  Insist( IS_USING_PERF_EVENT ?
+          "Counters require a build with USE_PERF_EVENT." : 0 );
+  Insist( level >= 1 && level <= 2 ? "Invalid counters level supplied." : 0 );
+
+  memset( (void*)counters_thread_, 0, sizeof(counters_thread_) );
+
+  counters_level_      = level;
+  counters_raw_config_ = raw_config;
+  counters_errno_      = 0;
+}
+
+/*===========================================================================*/
+/*---Level counted, 0 if not counting---*/
+
+int Counters_level()
+{
+  return counters_level_;
+}
+
+/*===========================================================================*/
+/*---Zero all counts---*/
+
+void Counters_reset()
+{
+  int thread = 0;
+
+  for( thread=0; thread<COUNTERS_NTHREAD_MAX; ++thread )
+  {
+    memset( (void*)counters_thread_[thread].count, 0,
+            sizeof(counters_thread_[thread].count) );
+    memset( (void*)counters_thread_[thread].ncall, 0,
+            sizeof(counters_thread_[thread].ncall) );
+  }
+}
+
+/*===========================================================================*/
+/*---Begin counting a region on the calling thread---*/
+
+void Counters_begin( int region )
+{
+  Assert( region >= 0 && region < COUNTERS_NREGION );
+
+  if( counters_level_ < 1 )
+  {
+    return;
+  }
+
+  const int thread_num = Env_omp_thread();
+  Assert( thread_num >= 0 && thread_num < COUNTERS_NTHREAD_MAX );
+  Counters_Thread_* const thread = &counters_thread_[thread_num];
+
+  /*---Reopen if this thread number is now run by another OS thread---*/
+
+#ifdef USE_PERF_EVENT
+  if( thread->is_open && thread->tid != (long) syscall( SYS_gettid ) )
+  {
+    Counters_close_( thread );
+  }
+#endif
+  if( ! thread->is_open )
+  {
+    Counters_open_( thread );
+  }
+
+  Counters_read_( thread, thread->begin[region] );
+}
+
+/*===========================================================================*/
+/*---End counting a region on the calling thread---*/
+
+void Counters_end( int region )
+{
+  Assert( region >= 0 && region < COUNTERS_NREGION );
+
+  if( counters_level_ < 1 )
+  {
+    return;
+  }
+
+  const int thread_num = Env_omp_thread();
+  Counters_Thread_* const thread = &counters_thread_[thread_num];
+  Assert( thread->is_open );
+
+  long long values[COUNTERS_NVALUE];
+  int e = 0;
+
+  Counters_read_( thread, values );
+
+  for( e=0; e<COUNTERS_NVALUE; ++e )
+  {
+    thread->count[region][e] += values[e] - thread->begin[region][e];
+  }
+  ++thread->ncall[region];
+}
+
+/*===========================================================================*/
+/*---Pack the counts of this proc: region, thread, calls, values; events
+     not counted are given as -1---*/
+/*---pseudo-private member function---*/
+
+enum{ COUNTERS_NVALUE_PER_ROW = 3 + COUNTERS_NVALUE };
+
+static P* Counters_pack_( int* nrow_packed )
+{
+  P* const values = malloc_host_P( COUNTERS_NVALUE_PER_ROW *
+                                   ( 1 + COUNTERS_NTHREAD_MAX ) );
+  P* v = values;
+  int nrow = 0;
+  int thread_num = 0;
+  int e = 0;
+
+  /*---The sweep row is for the proc: the events of the calling thread
+       over the sweep plus those of the other threads over their block
+       sweeps, which the sweep encloses; the time is the sweep's---*/
+
+  const Counters_Thread_* const master = &counters_thread_[0];
+
+  if( master->ncall[COUNTERS_REGION_SWEEP] > 0 )
+  {
+    *(v++) = COUNTERS_REGION_SWEEP;
+    *(v++) = 0;
+    *(v++) = master->ncall[COUNTERS_REGION_SWEEP];
+    for( e=0; e<COUNTERS_NVALUE; ++e )
+    {
+      long long sum = master->count[COUNTERS_REGION_SWEEP][e];
+      Bool_t is_counted = e == COUNTERS_NEVENT || master->slot[e] >= 0;
+
+      for( thread_num=1; thread_num<COUNTERS_NTHREAD_MAX &&
+                         e<COUNTERS_NEVENT; ++thread_num )
+      {
+        const Counters_Thread_* const thread = &counters_thread_[thread_num];
+        if( thread->ncall[COUNTERS_REGION_BLOCK] > 0 )
+        {
+          sum += thread->count[COUNTERS_REGION_BLOCK][e];
+          is_counted = is_counted && thread->slot[e] >= 0;
+        }
+      }
+      *(v++) = is_counted ? sum : -1;
+    }
+    ++nrow;
+  }
+
+  /*---Block rows, by thread---*/
+
+  for( thread_num=0; thread_num<COUNTERS_NTHREAD_MAX &&
+                     counters_level_ >= 2; ++thread_num )
+  {
+    const Counters_Thread_* const thread = &counters_thread_[thread_num];
+
+    if( thread->ncall[COUNTERS_REGION_BLOCK] == 0 )
+    {
+      continue;
+    }
+
+    *(v++) = COUNTERS_REGION_BLOCK;
+    *(v++) = thread_num;
+    *(v++) = thread->ncall[COUNTERS_REGION_BLOCK];
+    for( e=0; e<COUNTERS_NVALUE; ++e )
+    {
+      *(v++) = e < COUNTERS_NEVENT && thread->slot[e] < 0 ? -1 :
+                                  thread->count[COUNTERS_REGION_BLOCK][e];
+    }
+    ++nrow;
+  }
+
+  *nrow_packed = nrow;
+  return values;
+}
+
+/*===========================================================================*/
+/*---Print one packed row---*/
+/*---pseudo-private member function---*/
+
+static void Counters_print_row_( int proc, const P* v )
+{
+  const int region = (int) v[0];
+  const P* const count = &v[3];
+  const double time = 1.e-9 * count[COUNTERS_NEVENT];
+  int e = 0;
+
+  if( region == COUNTERS_REGION_SWEEP )
+  {
+    printf( "  %5i %6s %-6s %8.0f", proc, "all", "sweep", (double) v[2] );
+  }
+  else
+  {
+    printf( "  %5i %6i %-6s %8.0f", proc, (int) v[1], "block", (double) v[2] );
+  }
+
+  for( e=0; e<COUNTERS_NEVENT; ++e )
+  {
+    if( count[e] < 0 )
+    {
+      printf( " %14s", "-" );
+    }
+    else
+    {
+      printf( " %14.0f", (double) count[e] );
+    }
+  }
+
+  /*---Instructions per cycle; DRAM traffic estimated from LLC misses---*/
+
+  if( count[COUNTERS_CYCLES] > 0 && count[COUNTERS_INSTRUCTIONS] >= 0 )
+  {
+    printf( " %5.2f", count[COUNTERS_INSTRUCTIONS] /
+                      (double) count[COUNTERS_CYCLES] );
+  }
+  else
+  {
+    printf( " %5s", "-" );
+  }
+
+  if( count[COUNTERS_LLC_MISSES] >= 0 && time > 0 )
+  {
+    printf( " %8.3f", count[COUNTERS_LLC_MISSES] * 64. / time / 1e9 );
+  }
+  else
+  {
+    printf( " %8s", "-" );
+  }
+
+  printf( "\n" );
+}
+
+/*===========================================================================*/
+/*---Print counts of all active procs---*/
+
+void Counters_print( Env* env )
+{
+  if( counters_level_ == 0 )
+  {
+    return;
+  }
+
+  const int nproc = Env_nproc( env );
+  const int proc_this = Env_proc_this( env );
+  const int tag = Env_tag( env );
+
+  int nrow = 0;
+  P* const values = Counters_pack_( &nrow );
+
+  /*---Counts are sent to the master, which prints them a proc at a time---*/
+
+  if( proc_this != 0 )
+  {
+    Env_send_i( env, &nrow, 1, 0, tag );
+    Env_send_P( env, values, nrow * COUNTERS_NVALUE_PER_ROW, 0, tag );
+  }
+  else
+  {
+    int proc = 0;
+    int row = 0;
+
+    if( counters_errno_ )
+    {
+      printf( "Counters: perf_event_open: %s; see "
+              "/proc/sys/kernel/perf_event_paranoid\n",
+              strerror( counters_errno_ ) );
+    }
+
+    printf( "Counters (user mode; GB/s estimated as 64 B per LLC miss" );
+    if( counters_raw_config_ )
+    {
+      printf( "; raw event 0x%llx", counters_raw_config_ );
+    }
+    printf( "):\n" );
+    printf( "  %5s %6s %-6s %8s %14s %14s %14s %14s %14s %5s %8s\n",
+            "rank", "thread", "region", "calls", "cycles", "instructions",
+            "L1D misses", "LLC misses", "raw", "IPC", "GB/s" );
+
+    for( proc=0; proc<nproc; ++proc )
+    {
+      int nrow_proc = nrow;
+      if( proc != 0 )
+      {
+        Env_recv_i( env, &nrow_proc, 1, proc, tag );
+        Env_recv_P( env, values, nrow_proc * COUNTERS_NVALUE_PER_ROW, proc,
+                    tag );
+      }
+      for( row=0; row<nrow_proc; ++row )
+      {
+        Counters_print_row_( proc, &values[ row * COUNTERS_NVALUE_PER_ROW ] );
+      }
+    }
+  }
+
+  free_host_P( values );
+
+  Env_increment_tag( env, 1 );
+}
+
+/*===========================================================================*/
+/*---Stop counting, close counters---*/
+
+void Counters_stop()
+{
+  int thread = 0;
+
+  for( thread=0; thread<COUNTERS_NTHREAD_MAX; ++thread )
+  {
+    if( counters_thread_[thread].is_open )
+    {
+      Counters_close_( &counters_thread_[thread] );
+    }
+  }
+
+  counters_level_ = 0;
+}
+
+/*===========================================================================*/
+
+#ifdef __cplusplus_IGNORE
+} /*---extern "C"---*/
+#endif
+
+/*---------------------------------------------------------------------------*/
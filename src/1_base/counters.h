@@ -0,0 +1,101 @@
+/*---------------------------------------------------------------------------*/
+/*!
+ * \file   counters.h
+ * \author agent
+ * \date   Mon Oct 19 03:33:22 UTC 2026
+ * \brief  Hardware performance counters via perf_event_open, header.
+ */
+/*---------------------------------------------------------------------------*/
+
+/*=============================================================================
+
+Counters are available if USE_PERF_EVENT is defined (Linux only).  Each
+thread opens its own group of counters the first time it counts a region,
+and counts are accumulated per region and per thread.  Regions are the
+whole sweep, counted on the calling thread, and each call of the block
+sweep, counted on every thread of it.  The sweep counts of a proc are
+those of the calling thread plus the block sweep counts of the other
+threads, so they cover all threads; block counts by thread are printed
+at level 2.
+
+=============================================================================*/
+
+#ifndef _counters_h_
+#define _counters_h_
+
+#include "types.h"
+#include "env.h"
+
+#ifdef __cplusplus_IGNORE
+extern "C"
+{
+#endif
+
+/*===========================================================================*/
+/*---Enums---*/
+
+#ifdef USE_PERF_EVENT
+enum{ IS_USING_PERF_EVENT = Bool_true };
+#else
+enum{ IS_USING_PERF_EVENT = Bool_false };
+#endif
+
+/*---Events counted; the last is a raw event chosen at run time---*/
+
+enum{ COUNTERS_CYCLES       = 0,
+      COUNTERS_INSTRUCTIONS = 1,
+      COUNTERS_L1D_MISSES   = 2,
+      COUNTERS_LLC_MISSES   = 3,
+      COUNTERS_RAW          = 4,
+      COUNTERS_NEVENT       = 5 };
+
+/*---Regions counted---*/
+
+enum{ COUNTERS_REGION_SWEEP = 0,
+      COUNTERS_REGION_BLOCK = 1,
+      COUNTERS_NREGION      = 2 };
+
+/*===========================================================================*/
+/*---Start counting at a level: 1 the sweep, 2 also printing each block
+     sweep by thread; raw_config, if nonzero, is a PERF_TYPE_RAW event
+     code---*/
+
+void Counters_start( int level, long long raw_config );
+
+/*===========================================================================*/
+/*---Level counted, 0 if not counting---*/
+
+int Counters_level(void);
+
+/*===========================================================================*/
+/*---Zero all counts---*/
+
+void Counters_reset(void);
+
+/*===========================================================================*/
+/*---Begin, end counting a region on the calling thread---*/
+
+void Counters_begin( int region );
+
+void Counters_end( int region );
+
+/*===========================================================================*/
+/*---Print counts of all active procs, and at level 2 of their threads;
+     must be called by all active procs---*/
+
+void Counters_print( Env* env );
+
+/*===========================================================================*/
+/*---Stop counting, close counters---*/
+
+void Counters_stop(void);
+
+/*===========================================================================*/
+
+#ifdef __cplusplus_IGNORE
+} /*---extern "C"---*/
+#endif
+
+#endif /*---_counters_h_---*/
+
+/*---------------------------------------------------------------------------*/
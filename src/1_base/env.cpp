@@ -13,6 +13,7 @@
 
 #include "arguments.h"
 #include "env.h"
+#include "pool.h"
 
 #ifdef __cplusplus_IGNORE
 extern "C"
@@ -45,6 +46,27 @@ void Env_set_values( Env *env, Arguments* args )
 {
   Env_mpi_set_values_(  env, args );
   Env_hip_set_values_( env, args );
+  Pool_set_values( args );
+}
+
+/*===========================================================================*/
+/*---Pseudo-constructor: an environment with the device settings of
+     another and its own decomposition---*/
+
+void Env_create_copy( Env* env, const Env* env_source, Arguments* args )
+{
+  /*---The communicators of the source are not shared---*/
+  *env = *env_source;
+  Env_mpi_nullify_values_( env );
+  Env_mpi_set_values_( env, args );
+}
+
+/*===========================================================================*/
+/*---Pseudo-destructor for such a copy---*/
+
+void Env_destroy_copy( Env* env )
+{
+  Env_mpi_finalize_values_( env );
 }
 
 /*===========================================================================*/
@@ -54,6 +76,7 @@ void Env_finalize( Env* env )
 {
   Env_hip_finalize_( env );
   Env_mpi_finalize_(  env );
+  Pool_release();
 }
 
 /*===========================================================================*/
@@ -55,6 +55,18 @@ void Env_initialize( Env *env, int argc, char** argv );
 
 void Env_set_values( Env *env, Arguments* args );
 
+/*===========================================================================*/
+/*---Pseudo-constructor: an environment with the device settings of
+     another and its own decomposition, set from args; the other is left
+     unchanged---*/
+
+void Env_create_copy( Env* env, const Env* env_source, Arguments* args );
+
+/*===========================================================================*/
+/*---Pseudo-destructor for such a copy---*/
+
+void Env_destroy_copy( Env* env );
+
 /*===========================================================================*/
 /*---Finalize execution---*/
 
@@ -16,6 +16,7 @@
 #include "env_assert.h"
 #include "arguments.h"
 #include "env_cuda.h"
+#include "pool.h"
 
 #ifdef __cplusplus_IGNORE
 extern "C"
@@ -104,14 +105,15 @@ Bool_t Env_hip_is_using_device( const Env* const env )
 }
 
 /*===========================================================================*/
-/*---Memory management, for CUDA and all platforms ex. MIC---*/
+/*---Memory management, for CUDA and all platforms ex. MIC; host memory is
+     drawn from the pool, except pinned memory for the GPU---*/
 
 #ifndef __MIC__
 
 int* malloc_host_int( size_t n )
 {
   Assert( n+1 >= 1 );
-  int* result = (int*)malloc( n * sizeof(int) );
+  int* result = (int*)Pool_allocate( n * sizeof(int) );
   Assert( result );
   return result;
 }
@@ -121,7 +123,7 @@ int* malloc_host_int( size_t n )
 P* malloc_host_P( size_t n )
 {
   Assert( n+1 >= 1 );
-  P* result = (P*)malloc( n * sizeof(P) );
+  P* result = (P*)Pool_allocate( n * sizeof(P) );
   Assert( result );
   return result;
 }
@@ -138,7 +140,7 @@ P* malloc_host_pinned_P( size_t n )
   hipHostMalloc( &result, n==0 ? ((size_t)1) : n*sizeof(P) );
   Assert( Env_hip_last_call_succeeded() );
 #else
-  result = (P*)malloc( n * sizeof(P) );
+  result = (P*)Pool_allocate( n * sizeof(P) );
 #endif
   Assert( result );
 
@@ -167,7 +169,7 @@ P* malloc_device_P( size_t n )
 void free_host_int( int* p )
 {
   Assert( p );
-  free( (void*) p );
+  Pool_free( (void*) p );
 }
 
 /*---------------------------------------------------------------------------*/
@@ -175,7 +177,7 @@ void free_host_int( int* p )
 void free_host_P( P* p )
 {
   Assert( p );
-  free( (void*) p );
+  Pool_free( (void*) p );
 }
 
 /*---------------------------------------------------------------------------*/
@@ -187,7 +189,7 @@ void free_host_pinned_P( P* p )
   hipHostFree( p );
   Assert( Env_hip_last_call_succeeded() );
 #else
-  free( (void*) p );
+  Pool_free( (void*) p );
 #endif
 }
 
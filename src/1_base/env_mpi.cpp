@@ -8,6 +8,7 @@
  */
 /*---------------------------------------------------------------------------*/
 
+#include <stdlib.h>
 #include <string.h>
 
 #ifdef USE_MPI
@@ -33,9 +34,16 @@ void Env_mpi_nullify_values_( Env *env )
   /*---Initialize MPI-related variables in env struct to null---*/
   env->nproc_x_ = 0;
   env->nproc_y_ = 0;
+  env->nproc_z_ = 0;
+  env->nproc_e_ = 0;
+  env->nproc_octant_ = 0;
   env->tag_ = 0;
   env->active_comm_ = 0;
+  env->node_comm_ = 0;
+  env->octant_comm_ = 0;
   env->is_proc_active_ = 0;
+  env->comm_peer_ = NULL;
+  memset( (void*)env->comm_hist_, 0, sizeof(env->comm_hist_) );
 #endif
 }
 
@@ -72,11 +80,16 @@ void Env_mpi_finalize_values_( Env* env )
 #ifdef USE_MPI
   if( Env_mpi_are_values_set_( env ) )
   {
+    int mpi_code = MPI_Comm_free( &env->node_comm_ );
+    Assert( mpi_code == MPI_SUCCESS );
+    mpi_code = MPI_Comm_free( &env->octant_comm_ );
+    Assert( mpi_code == MPI_SUCCESS );
     if( env->active_comm_ != MPI_COMM_WORLD )
     {
-      const int mpi_code = MPI_Comm_free( &env->active_comm_ );
+      mpi_code = MPI_Comm_free( &env->active_comm_ );
       Assert( mpi_code == MPI_SUCCESS );
     }
+    free( (void*) env->comm_peer_ );
   }
 #endif
     /*---Restore types to unset null state---*/
@@ -113,10 +126,21 @@ void Env_mpi_set_values_( Env *env, Arguments* args )
 
   env->nproc_x_ = Arguments_consume_int_or_default( args, "--nproc_x", 1 );
   env->nproc_y_ = Arguments_consume_int_or_default( args, "--nproc_y", 1 );
+  env->nproc_z_ = Arguments_consume_int_or_default( args, "--nproc_z", 1 );
+  env->nproc_e_ = Arguments_consume_int_or_default( args, "--nproc_e", 1 );
+  env->nproc_octant_ = Arguments_consume_int_or_default( args,
+                                                         "--nproc_octant", 1 );
   Insist( env->nproc_x_ > 0 ? "Invalid nproc_x supplied." : 0 );
   Insist( env->nproc_y_ > 0 ? "Invalid nproc_y supplied." : 0 );
-
-  const int nproc_requested = env->nproc_x_ * env->nproc_y_;
+  Insist( env->nproc_z_ > 0 ? "Invalid nproc_z supplied." : 0 );
+  Insist( env->nproc_e_ > 0 ? "Invalid nproc_e supplied." : 0 );
+  Insist( env->nproc_octant_ > 0 && env->nproc_octant_ <= 8 &&
+          ( env->nproc_octant_ & ( env->nproc_octant_ - 1 ) ) == 0
+                                    ? "Invalid nproc_octant supplied." : 0 );
+
+  const int nproc_group = env->nproc_x_ * env->nproc_y_ * env->nproc_z_
+                        * env->nproc_e_;
+  const int nproc_requested = nproc_group * env->nproc_octant_;
   int nproc_world = 0;
   mpi_code = MPI_Comm_size( MPI_COMM_WORLD, &nproc_world );
   Assert( mpi_code == MPI_SUCCESS );
@@ -135,7 +159,22 @@ void Env_mpi_set_values_( Env *env, Arguments* args )
                                                    rank, &env->active_comm_ );
   Assert( mpi_code == MPI_SUCCESS );
 
+  /*---Set up a communicator of the procs in use that share this node---*/
+  mpi_code = MPI_Comm_split_type( env->active_comm_, MPI_COMM_TYPE_SHARED,
+                                  rank, MPI_INFO_NULL, &env->node_comm_ );
+  Assert( mpi_code == MPI_SUCCESS );
+
+  /*---Set up a communicator of corresponding procs of all octant groups---*/
+  mpi_code = MPI_Comm_split( env->active_comm_, rank % nproc_group,
+                                                   rank, &env->octant_comm_ );
+  Assert( mpi_code == MPI_SUCCESS );
+
   env->tag_ = 0;
+
+  /*---Message counts, zero until a message is sent or received---*/
+  env->comm_peer_ = (double*) calloc( nproc_requested *
+                                 ENV_COMM_NVALUE_PER_PEER, sizeof( double ) );
+  memset( (void*)env->comm_hist_, 0, sizeof(env->comm_hist_) );
 #endif
 }
 
@@ -152,6 +191,30 @@ Comm_t Env_mpi_active_comm_( const Env* env )
 #endif
 }
 
+/*---------------------------------------------------------------------------*/
+
+Comm_t Env_mpi_octant_comm_( const Env* env )
+{
+  Assert( Env_mpi_are_values_set_( env ) );
+#ifdef USE_MPI
+  return env->octant_comm_;
+#else
+  return 0;
+#endif
+}
+
+/*---------------------------------------------------------------------------*/
+
+Comm_t Env_mpi_node_comm_( const Env* env )
+{
+  Assert( Env_mpi_are_values_set_( env ) );
+#ifdef USE_MPI
+  return env->node_comm_;
+#else
+  return 0;
+#endif
+}
+
 /*===========================================================================*/
 /*---Number of procs---*/
 
@@ -181,10 +244,50 @@ int Env_nproc_y( const Env* env )
 
 /*---------------------------------------------------------------------------*/
 
+int Env_nproc_z( const Env* env )
+{
+  Assert( Env_mpi_are_values_set_( env ) );
+  int result = 1;
+#ifdef USE_MPI
+  result = env->nproc_z_;
+#endif
+  Assert( result > 0 );
+  return result;
+}
+
+/*---------------------------------------------------------------------------*/
+
+int Env_nproc_e( const Env* env )
+{
+  Assert( Env_mpi_are_values_set_( env ) );
+  int result = 1;
+#ifdef USE_MPI
+  result = env->nproc_e_;
+#endif
+  Assert( result > 0 );
+  return result;
+}
+
+/*---------------------------------------------------------------------------*/
+
+int Env_nproc_octant( const Env* env )
+{
+  Assert( Env_mpi_are_values_set_( env ) );
+  int result = 1;
+#ifdef USE_MPI
+  result = env->nproc_octant_;
+#endif
+  Assert( result > 0 );
+  return result;
+}
+
+/*---------------------------------------------------------------------------*/
+
 int Env_nproc( const Env* env )
 {
   Assert( Env_mpi_are_values_set_( env ) );
-  return Env_nproc_x( env ) * Env_nproc_y( env );
+  return Env_nproc_x( env ) * Env_nproc_y( env ) * Env_nproc_z( env )
+                            * Env_nproc_e( env ) * Env_nproc_octant( env );
 }
 
 /*===========================================================================*/
@@ -229,18 +332,34 @@ void Env_increment_tag( Env* env, int value )
 /*===========================================================================*/
 /*---Proc number info---*/
 
-int Env_proc( const Env* env, int proc_x, int proc_y )
+int Env_proc_xyze( const Env* env, int proc_x, int proc_y, int proc_z,
+                                                                 int proc_e )
 {
   Assert( Env_mpi_are_values_set_( env ) );
   Assert( proc_x >= 0 && proc_x < Env_nproc_x( env ) );
   Assert( proc_y >= 0 && proc_y < Env_nproc_y( env ) );
-  int result = proc_x + Env_nproc_x( env ) * proc_y;
-  Assert( result >= 0 && result < Env_nproc_x( env ) * Env_nproc_y( env ) );
+  Assert( proc_z >= 0 && proc_z < Env_nproc_z( env ) );
+  Assert( proc_e >= 0 && proc_e < Env_nproc_e( env ) );
+  /*---Procs of the same octant group as this proc---*/
+  int result = proc_x + Env_nproc_x( env ) *
+             ( proc_y + Env_nproc_y( env ) *
+             ( proc_z + Env_nproc_z( env ) *
+             ( proc_e + Env_nproc_e( env ) * Env_proc_octant_this( env ) ) ) );
+  Assert( result >= 0 && result < Env_nproc( env ) );
   return result;
 }
 
 /*---------------------------------------------------------------------------*/
 
+int Env_proc( const Env* env, int proc_x, int proc_y, int proc_z )
+{
+  /*---Procs of the same energy group as this proc---*/
+  Assert( Env_mpi_are_values_set_( env ) );
+  return Env_proc_xyze( env, proc_x, proc_y, proc_z, Env_proc_e_this( env ) );
+}
+
+/*---------------------------------------------------------------------------*/
+
 int Env_proc_x( const Env* env, int proc )
 {
   Assert( Env_mpi_are_values_set_( env ) );
@@ -256,11 +375,75 @@ int Env_proc_y( const Env* env, int proc )
 {
   Assert( Env_mpi_are_values_set_( env ) );
   Assert( proc >= 0 && proc < Env_nproc( env ) );
-  int result = proc / Env_nproc_x( env );
+  int result = ( proc / Env_nproc_x( env ) ) % Env_nproc_y( env );
   Assert( result >= 0 && result < Env_nproc_y( env ) );
   return result;
 }
 
+/*---------------------------------------------------------------------------*/
+
+int Env_proc_z( const Env* env, int proc )
+{
+  Assert( Env_mpi_are_values_set_( env ) );
+  Assert( proc >= 0 && proc < Env_nproc( env ) );
+  int result = ( proc / ( Env_nproc_x( env ) * Env_nproc_y( env ) ) )
+                                                         % Env_nproc_z( env );
+  Assert( result >= 0 && result < Env_nproc_z( env ) );
+  return result;
+}
+
+/*---------------------------------------------------------------------------*/
+
+int Env_proc_e( const Env* env, int proc )
+{
+  Assert( Env_mpi_are_values_set_( env ) );
+  Assert( proc >= 0 && proc < Env_nproc( env ) );
+  int result = ( proc / ( Env_nproc_x( env ) * Env_nproc_y( env )
+                                             * Env_nproc_z( env ) ) )
+                                                         % Env_nproc_e( env );
+  Assert( result >= 0 && result < Env_nproc_e( env ) );
+  return result;
+}
+
+/*---------------------------------------------------------------------------*/
+
+int Env_proc_octant( const Env* env, int proc )
+{
+  Assert( Env_mpi_are_values_set_( env ) );
+  Assert( proc >= 0 && proc < Env_nproc( env ) );
+  int result = proc / ( Env_nproc_x( env ) * Env_nproc_y( env )
+                      * Env_nproc_z( env ) * Env_nproc_e( env ) );
+  Assert( result >= 0 && result < Env_nproc_octant( env ) );
+  return result;
+}
+
+/*---------------------------------------------------------------------------*/
+
+int Env_proc_node( const Env* env, int proc )
+{
+  /*---Rank of proc within the node communicator, or -1 if off-node---*/
+  Assert( Env_mpi_are_values_set_( env ) );
+  Assert( proc >= 0 && proc < Env_nproc( env ) );
+  int result = -1;
+#ifdef USE_MPI
+  MPI_Group group_active;
+  MPI_Group group_node;
+  int mpi_code = MPI_Comm_group( Env_mpi_active_comm_( env ), &group_active );
+  Assert( mpi_code == MPI_SUCCESS );
+  mpi_code = MPI_Comm_group( Env_mpi_node_comm_( env ), &group_node );
+  Assert( mpi_code == MPI_SUCCESS );
+  mpi_code = MPI_Group_translate_ranks( group_active, 1, &proc,
+                                        group_node, &result );
+  Assert( mpi_code == MPI_SUCCESS );
+  result = result == MPI_UNDEFINED ? -1 : result;
+  MPI_Group_free( &group_active );
+  MPI_Group_free( &group_node );
+#else
+  result = 0;
+#endif
+  return result;
+}
+
 /*===========================================================================*/
 /*---Proc number info for this proc---*/
 
@@ -292,6 +475,30 @@ int Env_proc_y_this( const Env* env )
   return Env_proc_y( env, Env_proc_this( env ) );
 }
 
+/*---------------------------------------------------------------------------*/
+
+int Env_proc_z_this( const Env* env )
+{
+  Assert( Env_mpi_are_values_set_( env ) );
+  return Env_proc_z( env, Env_proc_this( env ) );
+}
+
+/*---------------------------------------------------------------------------*/
+
+int Env_proc_e_this( const Env* env )
+{
+  Assert( Env_mpi_are_values_set_( env ) );
+  return Env_proc_e( env, Env_proc_this( env ) );
+}
+
+/*---------------------------------------------------------------------------*/
+
+int Env_proc_octant_this( const Env* env )
+{
+  Assert( Env_mpi_are_values_set_( env ) );
+  return Env_proc_octant( env, Env_proc_this( env ) );
+}
+
 /*===========================================================================*/
 /*---MPI functions: global MPI operations---*/
 
@@ -322,6 +529,52 @@ double Env_sum_d( Env* env, double value )
 
 /*---------------------------------------------------------------------------*/
 
+void Env_sum_d_vector( Env* env, double* values, int n )
+{
+  Assert( Env_mpi_are_values_set_( env ) );
+  Assert( values != NULL );
+  Assert( n >= 0 );
+#ifdef USE_MPI
+  const int mpi_code = MPI_Allreduce( MPI_IN_PLACE, values, n, MPI_DOUBLE,
+                                      MPI_SUM, Env_mpi_active_comm_( env ) );
+  Assert( mpi_code == MPI_SUCCESS );
+#endif
+}
+
+/*---------------------------------------------------------------------------*/
+
+double Env_min_d( Env* env, double value )
+{
+  Assert( Env_mpi_are_values_set_( env ) );
+  double result = 0;
+#ifdef USE_MPI
+  const int mpi_code = MPI_Allreduce( &value, &result, 1, MPI_DOUBLE, MPI_MIN,
+                                                Env_mpi_active_comm_( env ) );
+  Assert( mpi_code == MPI_SUCCESS );
+#else
+  result = value;
+#endif
+  return result;
+}
+
+/*---------------------------------------------------------------------------*/
+
+double Env_max_d( Env* env, double value )
+{
+  Assert( Env_mpi_are_values_set_( env ) );
+  double result = 0;
+#ifdef USE_MPI
+  const int mpi_code = MPI_Allreduce( &value, &result, 1, MPI_DOUBLE, MPI_MAX,
+                                                Env_mpi_active_comm_( env ) );
+  Assert( mpi_code == MPI_SUCCESS );
+#else
+  result = value;
+#endif
+  return result;
+}
+
+/*---------------------------------------------------------------------------*/
+
 P Env_sum_P( Env* env, P value )
 {
   Assert( Env_mpi_are_values_set_( env ) );
@@ -353,6 +606,143 @@ void Env_bcast_string( Env* env, char* data, int len, int root )
 #endif
 }
 
+/*===========================================================================*/
+/*---Message counts: count a message of n values of P to or from a proc---*/
+
+static void Env_comm_count_( Env* env, size_t n, int proc, Bool_t is_send )
+{
+#ifdef USE_MPI
+  const double bytes = n * (double)sizeof(P);
+  double* const values = &env->comm_peer_[ proc * ENV_COMM_NVALUE_PER_PEER ];
+
+  if( is_send )
+  {
+    values[ ENV_COMM_NMSG_SEND  ] += 1;
+    values[ ENV_COMM_BYTES_SEND ] += bytes;
+
+    /*---Bin i holds sizes from 2^i to 2^(i+1)-1 bytes, bin 0 also 0---*/
+    int bin = 0;
+    size_t size = n * sizeof(P);
+    while( size > 1 && bin < ENV_COMM_NBIN-1 )
+    {
+      size /= 2;
+      ++bin;
+    }
+    env->comm_hist_[bin] += 1;
+  }
+  else
+  {
+    values[ ENV_COMM_NMSG_RECV  ] += 1;
+    values[ ENV_COMM_BYTES_RECV ] += bytes;
+  }
+#endif
+}
+
+/*---------------------------------------------------------------------------*/
+
+void Env_comm_reset( Env* env )
+{
+  Assert( Env_mpi_are_values_set_( env ) );
+#ifdef USE_MPI
+  memset( (void*)env->comm_peer_, 0,
+          Env_nproc( env ) * ENV_COMM_NVALUE_PER_PEER * sizeof( double ) );
+  memset( (void*)env->comm_hist_, 0, sizeof(env->comm_hist_) );
+#endif
+}
+
+/*---------------------------------------------------------------------------*/
+/*---Axis along which a proc lies from this one, if a neighbor in the
+     same energy and octant group---*/
+
+#ifdef USE_MPI
+static int Env_comm_axis_( const Env* env, int proc )
+{
+  const int proc_this = Env_proc_this( env );
+
+  if( Env_proc_e( env, proc ) != Env_proc_e_this( env ) ||
+      Env_proc_octant( env, proc ) != Env_proc_octant_this( env ) )
+  {
+    return ENV_COMM_AXIS_OTHER;
+  }
+
+  const Bool_t is_same_x = Env_proc_x( env, proc ) == Env_proc_x_this( env );
+  const Bool_t is_same_y = Env_proc_y( env, proc ) == Env_proc_y_this( env );
+  const Bool_t is_same_z = Env_proc_z( env, proc ) == Env_proc_z_this( env );
+
+  return proc == proc_this              ? ENV_COMM_AXIS_OTHER :
+         is_same_y && is_same_z         ? ENV_COMM_AXIS_X :
+         is_same_x && is_same_z         ? ENV_COMM_AXIS_Y :
+         is_same_x && is_same_y         ? ENV_COMM_AXIS_Z :
+                                          ENV_COMM_AXIS_OTHER;
+}
+#endif
+
+/*---------------------------------------------------------------------------*/
+/*---Sum message counts of all procs onto the master proc---*/
+
+void Env_comm_summarize( Env* env, CommSummary* summary )
+{
+  Assert( Env_mpi_are_values_set_( env ) );
+  Assert( summary != NULL );
+
+  memset( (void*)summary, 0, sizeof(CommSummary) );
+
+#ifdef USE_MPI
+  const int nproc = Env_nproc( env );
+  double values[ 2 * ENV_COMM_NAXIS + ENV_COMM_NBIN ];
+  double sums[ 2 * ENV_COMM_NAXIS + ENV_COMM_NBIN ];
+  double bytes_peer_max = 0;
+  int peer_max = 0;
+  int proc = 0;
+  int i = 0;
+
+  memset( (void*)values, 0, sizeof(values) );
+
+  for( proc=0; proc<nproc; ++proc )
+  {
+    const double* const peer = &env->comm_peer_[
+                                          proc * ENV_COMM_NVALUE_PER_PEER ];
+    const int axis = Env_comm_axis_( env, proc );
+    values[ axis ]                  += peer[ ENV_COMM_NMSG_SEND ];
+    values[ ENV_COMM_NAXIS + axis ] += peer[ ENV_COMM_BYTES_SEND ];
+    if( peer[ ENV_COMM_BYTES_SEND ] > bytes_peer_max )
+    {
+      bytes_peer_max = peer[ ENV_COMM_BYTES_SEND ];
+      peer_max = proc;
+    }
+  }
+  for( i=0; i<ENV_COMM_NBIN; ++i )
+  {
+    values[ 2 * ENV_COMM_NAXIS + i ] = env->comm_hist_[i];
+  }
+
+  const int mpi_code = MPI_Reduce( values, sums,
+                                   2 * ENV_COMM_NAXIS + ENV_COMM_NBIN,
+                                   MPI_DOUBLE, MPI_SUM, 0,
+                                   Env_mpi_active_comm_( env ) );
+  Assert( mpi_code == MPI_SUCCESS );
+
+  for( i=0; i<ENV_COMM_NAXIS; ++i )
+  {
+    summary->nmsg_axis[i]  = sums[ i ];
+    summary->bytes_axis[i] = sums[ ENV_COMM_NAXIS + i ];
+  }
+  for( i=0; i<ENV_COMM_NBIN; ++i )
+  {
+    summary->nmsg_bin[i] = sums[ 2 * ENV_COMM_NAXIS + i ];
+  }
+
+  /*---Busiest pair of procs, the lowest numbered if tied---*/
+
+  summary->bytes_peer_max = Env_max_d( env, bytes_peer_max );
+  const Bool_t is_max = bytes_peer_max == summary->bytes_peer_max;
+  summary->proc_peer_max = (int)Env_min_d( env,
+                                    is_max ? Env_proc_this( env ) : nproc );
+  summary->peer_max = (int)Env_min_d( env,
+      Env_proc_this( env ) == summary->proc_peer_max ? peer_max : nproc );
+#endif
+}
+
 /*===========================================================================*/
 /*---MPI functions: point-to-point communication: synchronous---*/
 
@@ -400,6 +790,8 @@ void Env_send_P( Env* env, const P* data, size_t n, int proc, int tag )
   Assert( proc>=0 && proc<Env_nproc( env ) );
   Assert( tag>=0 );
 
+  Env_comm_count_( env, n, proc, Bool_true );
+
 #ifdef USE_MPI
   const int mpi_code = MPI_Send( (void*)data, n, MPI_DOUBLE, proc, tag,
                                                 Env_mpi_active_comm_( env ) );
@@ -418,6 +810,8 @@ void Env_recv_P( Env* env, P* data, size_t n, int proc, int tag )
   Assert( proc>=0 && proc<Env_nproc( env ) );
   Assert( tag>=0 );
 
+  Env_comm_count_( env, n, proc, Bool_false );
+
 #ifdef USE_MPI
   MPI_Status status;
   const int mpi_code = MPI_Recv( (void*)data, n, MPI_DOUBLE, proc, tag,
@@ -440,6 +834,8 @@ void Env_asend_P( Env* env, const P* data, size_t n, int proc, int tag,
   Assert( tag>=0 );
   Assert( request != NULL );
 
+  Env_comm_count_( env, n, proc, Bool_true );
+
 #ifdef USE_MPI
   const int mpi_code = MPI_Isend( (void*)data, n, MPI_DOUBLE, proc, tag,
                                        Env_mpi_active_comm_( env ), request );
@@ -460,6 +856,8 @@ void Env_arecv_P( Env* env, const P* data, size_t n, int proc, int tag,
   Assert( tag>=0 );
   Assert( request != NULL );
 
+  Env_comm_count_( env, n, proc, Bool_false );
+
 #ifdef USE_MPI
   const int mpi_code = MPI_Irecv( (void*)data, n, MPI_DOUBLE, proc, tag,
                                        Env_mpi_active_comm_( env ), request );
@@ -469,6 +867,24 @@ void Env_arecv_P( Env* env, const P* data, size_t n, int proc, int tag,
 
 /*---------------------------------------------------------------------------*/
 
+void Env_octant_asum_P( Env* env, P* data, size_t n, Request_t* request )
+{
+  /*---In-place sum across corresponding procs of all octant groups---*/
+  Assert( Env_mpi_are_values_set_( env ) );
+  Static_Assert( P_IS_DOUBLE );
+  Assert( data != NULL );
+  Assert( n+1 >= 1 );
+  Assert( request != NULL );
+
+#ifdef USE_MPI
+  const int mpi_code = MPI_Iallreduce( MPI_IN_PLACE, (void*)data, n,
+               MPI_DOUBLE, MPI_SUM, Env_mpi_octant_comm_( env ), request );
+  Assert( mpi_code == MPI_SUCCESS );
+#endif
+}
+
+/*---------------------------------------------------------------------------*/
+
 void Env_wait( Env* env, Request_t* request )
 {
 #ifdef USE_MPI
@@ -478,6 +894,105 @@ void Env_wait( Env* env, Request_t* request )
 #endif
 }
 
+/*===========================================================================*/
+/*---MPI functions: shared memory windows among procs on a node---*/
+
+void Env_win_allocate_shared( Env* env, size_t size, void* baseptr,
+                                                                 Win_t* win )
+{
+  Assert( Env_mpi_are_values_set_( env ) );
+  Assert( size+1 >= 1 );
+  Assert( baseptr != NULL );
+  Assert( win != NULL );
+
+#ifdef USE_MPI
+  int mpi_code = MPI_Win_allocate_shared( (MPI_Aint)size, 1, MPI_INFO_NULL,
+                                Env_mpi_node_comm_( env ), baseptr, win );
+  Assert( mpi_code == MPI_SUCCESS );
+
+  /*---Passive target epoch for the lifetime of the window---*/
+  mpi_code = MPI_Win_lock_all( MPI_MODE_NOCHECK, *win );
+  Assert( mpi_code == MPI_SUCCESS );
+#else
+  Insist( Bool_false ? "Shared memory windows require MPI." : 0 );
+#endif
+}
+
+/*---------------------------------------------------------------------------*/
+
+void* Env_win_shared_query( Env* env, Win_t* win, int proc_node )
+{
+  Assert( Env_mpi_are_values_set_( env ) );
+  Assert( win != NULL );
+  Assert( proc_node >= 0 );
+
+  void* result = NULL;
+#ifdef USE_MPI
+  MPI_Aint size = 0;
+  int disp_unit = 0;
+  const int mpi_code = MPI_Win_shared_query( *win, proc_node, &size,
+                                             &disp_unit, &result );
+  Assert( mpi_code == MPI_SUCCESS );
+#endif
+  return result;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void Env_win_free( Env* env, Win_t* win )
+{
+  Assert( Env_mpi_are_values_set_( env ) );
+  Assert( win != NULL );
+
+#ifdef USE_MPI
+  int mpi_code = MPI_Win_unlock_all( *win );
+  Assert( mpi_code == MPI_SUCCESS );
+  mpi_code = MPI_Win_free( win );
+  Assert( mpi_code == MPI_SUCCESS );
+#endif
+}
+
+/*---------------------------------------------------------------------------*/
+
+void Env_win_sync( Env* env, Win_t* win )
+{
+  /*---Memory barrier for loads/stores to the shared window---*/
+  Assert( win != NULL );
+
+#ifdef USE_MPI
+  const int mpi_code = MPI_Win_sync( *win );
+  Assert( mpi_code == MPI_SUCCESS );
+#endif
+}
+
+/*---------------------------------------------------------------------------*/
+
+void Env_win_wait_counter( Env* env, Win_t* win,
+                           const volatile long* counter, long value )
+{
+  /*---Spin until a counter in the shared window reaches the given value---*/
+  Assert( Env_mpi_are_values_set_( env ) );
+  Assert( win != NULL );
+  Assert( counter != NULL );
+
+#ifdef USE_MPI
+  while( Bool_true )
+  {
+    Env_win_sync( env, win );
+    if( *counter >= value )
+    {
+      break;
+    }
+    /*---Poke the progress engine so pending off-node messages advance---*/
+    int flag = 0;
+    const int mpi_code = MPI_Iprobe( MPI_ANY_SOURCE, MPI_ANY_TAG,
+               Env_mpi_active_comm_( env ), &flag, MPI_STATUS_IGNORE );
+    Assert( mpi_code == MPI_SUCCESS );
+  }
+  Env_win_sync( env, win );
+#endif
+}
+
 /*===========================================================================*/
 
 #ifdef __cplusplus_IGNORE
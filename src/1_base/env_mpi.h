@@ -70,8 +70,28 @@ int Env_nproc_y( const Env* env );
 
 /*---------------------------------------------------------------------------*/
 
+int Env_nproc_z( const Env* env );
+
+/*---------------------------------------------------------------------------*/
+
+int Env_nproc_e( const Env* env );
+
+/*---------------------------------------------------------------------------*/
+
+int Env_nproc_octant( const Env* env );
+
+/*---------------------------------------------------------------------------*/
+
 int Env_nproc( const Env* env );
 
+/*---------------------------------------------------------------------------*/
+
+Comm_t Env_mpi_node_comm_( const Env* env );
+
+/*---------------------------------------------------------------------------*/
+
+Comm_t Env_mpi_octant_comm_( const Env* env );
+
 /*===========================================================================*/
 /*---Is this proc within the subcommunicator of procs in use---*/
 
@@ -89,7 +109,12 @@ void Env_increment_tag( Env* env, int value );
 /*===========================================================================*/
 /*---Proc number info---*/
 
-int Env_proc( const Env* env, int proc_x, int proc_y );
+int Env_proc_xyze( const Env* env, int proc_x, int proc_y, int proc_z,
+                                                                int proc_e );
+
+/*---------------------------------------------------------------------------*/
+
+int Env_proc( const Env* env, int proc_x, int proc_y, int proc_z );
 
 /*---------------------------------------------------------------------------*/
 
@@ -99,6 +124,22 @@ int Env_proc_x( const Env* env, int proc );
 
 int Env_proc_y( const Env* env, int proc );
 
+/*---------------------------------------------------------------------------*/
+
+int Env_proc_z( const Env* env, int proc );
+
+/*---------------------------------------------------------------------------*/
+
+int Env_proc_e( const Env* env, int proc );
+
+/*---------------------------------------------------------------------------*/
+
+int Env_proc_octant( const Env* env, int proc );
+
+/*---------------------------------------------------------------------------*/
+
+int Env_proc_node( const Env* env, int proc );
+
 /*===========================================================================*/
 /*---Proc number info for this proc---*/
 
@@ -112,6 +153,18 @@ int Env_proc_x_this( const Env* env );
 
 int Env_proc_y_this( const Env* env );
 
+/*---------------------------------------------------------------------------*/
+
+int Env_proc_z_this( const Env* env );
+
+/*---------------------------------------------------------------------------*/
+
+int Env_proc_e_this( const Env* env );
+
+/*---------------------------------------------------------------------------*/
+
+int Env_proc_octant_this( const Env* env );
+
 /*===========================================================================*/
 /*---MPI functions: global MPI operations---*/
 
@@ -121,6 +174,19 @@ void Env_mpi_barrier( Env* env );
 
 double Env_sum_d( Env* env, double value );
 
+/*---------------------------------------------------------------------------*/
+/*---Elementwise sum, in place---*/
+
+void Env_sum_d_vector( Env* env, double* values, int n );
+
+/*---------------------------------------------------------------------------*/
+
+double Env_min_d( Env* env, double value );
+
+/*---------------------------------------------------------------------------*/
+
+double Env_max_d( Env* env, double value );
+
 /*---------------------------------------------------------------------------*/
 
 P Env_sum_P( Env* env, P value );
@@ -133,6 +199,15 @@ void Env_bcast_int( Env* env, int* data, int root );
 
 void Env_bcast_string( Env* env, char* data, int len, int root );
 
+/*===========================================================================*/
+/*---Message counts of the point-to-point functions for P values---*/
+
+void Env_comm_reset( Env* env );
+
+/*---------------------------------------------------------------------------*/
+
+void Env_comm_summarize( Env* env, CommSummary* summary );
+
 /*===========================================================================*/
 /*---MPI functions: point-to-point communication: synchronous---*/
 
@@ -163,8 +238,35 @@ void Env_arecv_P( Env* env, const P* data, size_t n, int proc, int tag,
 
 /*---------------------------------------------------------------------------*/
 
+void Env_octant_asum_P( Env* env, P* data, size_t n, Request_t* request );
+
+/*---------------------------------------------------------------------------*/
+
 void Env_wait( Env* env, Request_t* request );
 
+/*===========================================================================*/
+/*---MPI functions: shared memory windows among procs on a node---*/
+
+void Env_win_allocate_shared( Env* env, size_t size, void* baseptr,
+                                                                Win_t* win );
+
+/*---------------------------------------------------------------------------*/
+
+void* Env_win_shared_query( Env* env, Win_t* win, int proc_node );
+
+/*---------------------------------------------------------------------------*/
+
+void Env_win_free( Env* env, Win_t* win );
+
+/*---------------------------------------------------------------------------*/
+
+void Env_win_sync( Env* env, Win_t* win );
+
+/*---------------------------------------------------------------------------*/
+
+void Env_win_wait_counter( Env* env, Win_t* win,
+                           const volatile long* counter, long value );
+
 /*===========================================================================*/
 
 #ifdef __cplusplus_IGNORE
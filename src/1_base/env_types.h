@@ -37,9 +37,11 @@ extern "C"
 #ifdef USE_MPI
 typedef MPI_Comm    Comm_t;
 typedef MPI_Request Request_t;
+typedef MPI_Win     Win_t;
 #else
 typedef int Comm_t;
 typedef int Request_t;
+typedef int Win_t;
 #endif
 
 #ifdef USE_HIP
@@ -48,6 +50,24 @@ typedef hipStream_t Stream_t;
 typedef int Stream_t;
 #endif
 
+/*===========================================================================*/
+/*---Message counts: axes along which messages go, log2 size bins, and the
+     values kept per peer proc---*/
+
+enum{ ENV_COMM_AXIS_X     = 0,
+      ENV_COMM_AXIS_Y     = 1,
+      ENV_COMM_AXIS_Z     = 2,
+      ENV_COMM_AXIS_OTHER = 3,
+      ENV_COMM_NAXIS      = 4 };
+
+enum{ ENV_COMM_NBIN = 40 };
+
+enum{ ENV_COMM_NMSG_SEND  = 0,
+      ENV_COMM_BYTES_SEND = 1,
+      ENV_COMM_NMSG_RECV  = 2,
+      ENV_COMM_BYTES_RECV = 3,
+      ENV_COMM_NVALUE_PER_PEER = 4 };
+
 /*===========================================================================*/
 /*---Struct containing environment information---*/
 
@@ -56,9 +76,16 @@ typedef struct
 #ifdef USE_MPI
   int    nproc_x_;    /*---Number of procs along x axis---*/
   int    nproc_y_;    /*---Number of procs along y axis---*/
+  int    nproc_z_;    /*---Number of procs along z axis---*/
+  int    nproc_e_;    /*---Number of proc groups along energy axis---*/
+  int    nproc_octant_; /*---Number of proc groups dividing the octants---*/
   int    tag_;        /*---Next free message tag---*/
   Comm_t active_comm_;
+  Comm_t node_comm_;  /*---Procs of active_comm_ sharing this node---*/
+  Comm_t octant_comm_; /*---Procs of same location in all octant groups---*/
   Bool_t is_proc_active_;
+  double* comm_peer_; /*---Message counts for each peer proc---*/
+  double comm_hist_[ENV_COMM_NBIN]; /*---Messages sent, by log2 of bytes---*/
 #endif
 #ifdef USE_HIP
   Bool_t   is_using_device_;
@@ -68,6 +95,20 @@ typedef struct
 #endif
 } Env;
 
+/*===========================================================================*/
+/*---Summary of message counts over all procs---*/
+
+typedef struct
+{
+  double nmsg_axis[ENV_COMM_NAXIS];   /*---Messages sent along each axis---*/
+  double bytes_axis[ENV_COMM_NAXIS];
+  double nmsg_bin[ENV_COMM_NBIN];     /*---Messages sent of 2^i to 2^(i+1)-1
+                                           bytes---*/
+  double bytes_peer_max;              /*---Most bytes sent to one peer---*/
+  int    proc_peer_max;               /*---The proc sending these---*/
+  int    peer_max;                    /*---The proc receiving these---*/
+} CommSummary;
+
 /*===========================================================================*/
 
 #ifdef __cplusplus_IGNORE
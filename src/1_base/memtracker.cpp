@@ -0,0 +1,199 @@
+/*---------------------------------------------------------------------------*/
+/*!
+ * \file   memtracker.cpp
+ * \author agent
+ * \date   Mon Oct 19 04:04:43 UTC 2026
+ * \brief  Tracking of the bytes allocated by category, definitions.
+ */
+/*---------------------------------------------------------------------------*/
+
+#include <stddef.h>
+#include <stdio.h>
+#include <sys/resource.h>
+
+#include "types.h"
+#include "env.h"
+
+#include "memtracker.h"
+
+#ifdef __cplusplus_IGNORE
+extern "C"
+{
+#endif
+
+/*===========================================================================*/
+/*---Bytes now and peak, host then device; entry MEMTRACKER_NCATEGORY of
+     each is the total---*/
+
+static size_t memtracker_nbyte_[2][MEMTRACKER_NCATEGORY+1];
+static size_t memtracker_nbyte_peak_[2][MEMTRACKER_NCATEGORY+1];
+
+/*===========================================================================*/
+/*---Register an allocation---*/
+
+void MemTracker_allocate( int category, size_t nbyte, Bool_t is_device )
+{
+  Assert( category >= 0 && category < MEMTRACKER_NCATEGORY );
+
+  size_t* const now  = memtracker_nbyte_[ is_device ? 1 : 0 ];
+  size_t* const peak = memtracker_nbyte_peak_[ is_device ? 1 : 0 ];
+
+  now[category]             += nbyte;
+  now[MEMTRACKER_NCATEGORY] += nbyte;
+
+  if( now[category] > peak[category] )
+  {
+    peak[category] = now[category];
+  }
+  if( now[MEMTRACKER_NCATEGORY] > peak[MEMTRACKER_NCATEGORY] )
+  {
+    peak[MEMTRACKER_NCATEGORY] = now[MEMTRACKER_NCATEGORY];
+  }
+}
+
+/*===========================================================================*/
+/*---Register a free---*/
+
+void MemTracker_free( int category, size_t nbyte, Bool_t is_device )
+{
+  Assert( category >= 0 && category < MEMTRACKER_NCATEGORY );
+
+  size_t* const now = memtracker_nbyte_[ is_device ? 1 : 0 ];
+
+  Assert( now[category] >= nbyte );
+
+  now[category]             -= nbyte;
+  now[MEMTRACKER_NCATEGORY] -= nbyte;
+}
+
+/*===========================================================================*/
+/*---Bytes allocated now---*/
+
+size_t MemTracker_nbyte( int category, Bool_t is_device )
+{
+  Assert( category >= 0 && category <= MEMTRACKER_NCATEGORY );
+
+  return memtracker_nbyte_[ is_device ? 1 : 0 ][category];
+}
+
+/*===========================================================================*/
+/*---Peak bytes allocated---*/
+
+size_t MemTracker_nbyte_peak( int category, Bool_t is_device )
+{
+  Assert( category >= 0 && category <= MEMTRACKER_NCATEGORY );
+
+  return memtracker_nbyte_peak_[ is_device ? 1 : 0 ][category];
+}
+
+/*===========================================================================*/
+/*---Restart the peaks---*/
+
+void MemTracker_reset_peak()
+{
+  int i = 0;
+  int category = 0;
+
+  for( i=0; i<2; ++i )
+  {
+    for( category=0; category<=MEMTRACKER_NCATEGORY; ++category )
+    {
+      memtracker_nbyte_peak_[i][category] = memtracker_nbyte_[i][category];
+    }
+  }
+}
+
+/*===========================================================================*/
+/*---Print the peaks of all active procs---*/
+
+/*---Values per proc: host peak of each category and the total, device
+     total, peak resident set---*/
+
+enum{ MEMTRACKER_NVALUE = MEMTRACKER_NCATEGORY + 3 };
+
+void MemTracker_print( Env* env, Bool_t is_predicted )
+{
+  const int nproc = Env_nproc( env );
+  const int proc_this = Env_proc_this( env );
+  const int tag = Env_tag( env );
+  const int nvalue = is_predicted ? MEMTRACKER_NVALUE - 1 : MEMTRACKER_NVALUE;
+
+  P values[MEMTRACKER_NVALUE];
+  P values_max[MEMTRACKER_NVALUE];
+  int i = 0;
+
+  for( i=0; i<=MEMTRACKER_NCATEGORY; ++i )
+  {
+    values[i] = (P) MemTracker_nbyte_peak( i, Bool_false );
+  }
+  values[MEMTRACKER_NCATEGORY+1] = (P) MemTracker_nbyte_peak(
+                                       MEMTRACKER_NCATEGORY, Bool_true );
+
+  /*---ru_maxrss is in kilobytes on Linux---*/
+
+  struct rusage usage;
+  getrusage( RUSAGE_SELF, &usage );
+  values[MEMTRACKER_NCATEGORY+2] = (P) usage.ru_maxrss * (P) 1024;
+
+  /*---Values are sent to the master, which prints them a proc at a time---*/
+
+  if( proc_this != 0 )
+  {
+    Env_send_P( env, values, MEMTRACKER_NVALUE, 0, tag );
+  }
+  else
+  {
+    int proc = 0;
+
+    printf( "Memory %s, MB per proc; total is the peak of the sum:\n",
+            is_predicted ? "predicted" : "peak" );
+    printf( "  %5s %10s %10s %10s %10s %10s %10s %10s %10s", "rank",
+            "state", "faces", "face bufs", "angle", "scratch", "other",
+            "total", "device" );
+    if( ! is_predicted )
+    {
+      printf( " %10s", "resident" );
+    }
+    printf( "\n" );
+
+    for( i=0; i<MEMTRACKER_NVALUE; ++i )
+    {
+      values_max[i] = values[i];
+    }
+
+    for( proc=0; proc<nproc; ++proc )
+    {
+      if( proc != 0 )
+      {
+        Env_recv_P( env, values, MEMTRACKER_NVALUE, proc, tag );
+      }
+      printf( "  %5i", proc );
+      for( i=0; i<nvalue; ++i )
+      {
+        printf( " %10.3f", (double) values[i] * 1e-6 );
+        values_max[i] = values[i] > values_max[i] ? values[i] : values_max[i];
+      }
+      printf( "\n" );
+    }
+
+    if( nproc > 1 )
+    {
+      printf( "  %5s", "max" );
+      for( i=0; i<nvalue; ++i )
+      {
+        printf( " %10.3f", (double) values_max[i] * 1e-6 );
+      }
+      printf( "\n" );
+    }
+  }
+
+  Env_increment_tag( env, 1 );
+}
+
+/*===========================================================================*/
+
+#ifdef __cplusplus_IGNORE
+} /*---extern "C"---*/
+#endif
+
+/*---------------------------------------------------------------------------*/
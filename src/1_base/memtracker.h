@@ -0,0 +1,79 @@
+/*---------------------------------------------------------------------------*/
+/*!
+ * \file   memtracker.h
+ * \author agent
+ * \date   Mon Oct 19 04:04:43 UTC 2026
+ * \brief  Tracking of the bytes allocated by category, header.
+ */
+/*---------------------------------------------------------------------------*/
+
+/*=============================================================================
+
+The allocators of the major arrays register each allocation and free with
+its size and category.  The bytes currently allocated and their peak are
+kept per category and in total, for host and device memory separately.
+A footprint predicted without allocating is registered the same way.
+Calls are made outside threaded regions.
+
+=============================================================================*/
+
+#ifndef _memtracker_h_
+#define _memtracker_h_
+
+#include <stddef.h>
+
+#include "types.h"
+#include "env.h"
+
+#ifdef __cplusplus_IGNORE
+extern "C"
+{
+#endif
+
+/*===========================================================================*/
+/*---Enums---*/
+
+/*---Categories of arrays; entry MEMTRACKER_NCATEGORY is their total---*/
+
+enum{ MEMTRACKER_STATE     = 0,   /*---vi, vo---*/
+      MEMTRACKER_FACES     = 1,   /*---xy, xz, yz faces, all copies---*/
+      MEMTRACKER_FACE_BUFS = 2,   /*---Staging buffers for face messages---*/
+      MEMTRACKER_ANGLE     = 3,   /*---Moment-angle matrices---*/
+      MEMTRACKER_SCRATCH   = 4,   /*---Per-thread sweeper scratch---*/
+      MEMTRACKER_OTHER     = 5,
+      MEMTRACKER_NCATEGORY = 6 };
+
+/*===========================================================================*/
+/*---Register an allocation, a free---*/
+
+void MemTracker_allocate( int category, size_t nbyte, Bool_t is_device );
+
+void MemTracker_free( int category, size_t nbyte, Bool_t is_device );
+
+/*===========================================================================*/
+/*---Bytes allocated now, and their peak, of a category or the total---*/
+
+size_t MemTracker_nbyte( int category, Bool_t is_device );
+
+size_t MemTracker_nbyte_peak( int category, Bool_t is_device );
+
+/*===========================================================================*/
+/*---Restart the peaks from the bytes allocated now---*/
+
+void MemTracker_reset_peak(void);
+
+/*===========================================================================*/
+/*---Print the peaks of all active procs, with the peak resident set of
+     the process unless predicted; must be called by all active procs---*/
+
+void MemTracker_print( Env* env, Bool_t is_predicted );
+
+/*===========================================================================*/
+
+#ifdef __cplusplus_IGNORE
+} /*---extern "C"---*/
+#endif
+
+#endif /*---_memtracker_h_---*/
+
+/*---------------------------------------------------------------------------*/
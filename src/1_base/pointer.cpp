@@ -13,6 +13,7 @@
 
 #include "types.h"
 #include "env.h"
+#include "memtracker.h"
 #include "pointer.h"
 
 #ifdef __cplusplus_IGNORE
@@ -46,6 +47,7 @@ void Pointer_create( Pointer* p,
   p->is_using_device_ = is_using_device;
   p->is_pinned_ = Bool_false;
   p->is_alias_  = Bool_false;
+  p->category_  = MEMTRACKER_OTHER;
 }
 
 /*---------------------------------------------------------------------------*/
@@ -77,6 +79,27 @@ void Pointer_create_alias( Pointer* p,
   p->is_using_device_ = source->is_using_device_;
   p->is_pinned_       = source->is_pinned_;
   p->is_alias_        = Bool_true;
+  p->category_        = source->category_;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void Pointer_create_external( Pointer* p,
+                              P*       h,
+                              size_t   n )
+{
+  /*---Host-only view of memory owned elsewhere, e.g. an MPI window---*/
+  Assert( p );
+  Assert( h );
+  Assert( n+1 >= 1 );
+
+  p->h_               = h;
+  p->d_               = NULL;
+  p->n_               = n;
+  p->is_using_device_ = Bool_false;
+  p->is_pinned_       = Bool_false;
+  p->is_alias_        = Bool_true;
+  p->category_        = MEMTRACKER_OTHER;
 }
 
 /*---------------------------------------------------------------------------*/
@@ -92,6 +115,19 @@ void Pointer_set_pinned( Pointer* p,
   p->is_pinned_ = is_pinned;
 }
 
+/*---------------------------------------------------------------------------*/
+
+void Pointer_set_category( Pointer* p,
+                           int      category )
+{
+  Assert( p );
+  Assert( ! p->h_ && ! p->d_
+              ? "Currently cannot change category of allocated array" : 0 );
+  Assert( category >= 0 && category < MEMTRACKER_NCATEGORY );
+
+  p->category_ = category;
+}
+
 /*===========================================================================*/
 /*---Pseudo-destructor---*/
 
@@ -109,12 +145,14 @@ void Pointer_destroy( Pointer* p )
     {
       free_host_P( p->h_ );
     }
+    MemTracker_free( p->category_, p->n_ * sizeof(P), Bool_false );
   }
   p->h_ = NULL;
 
   if( p->d_ && ! p->is_alias_ )
   {
     free_device_P( p->d_ );
+    MemTracker_free( p->category_, p->n_ * sizeof(P), Bool_true );
   }
   p->d_ = NULL;
 
@@ -141,6 +179,8 @@ void Pointer_allocate_h_( Pointer* p )
     p->h_ = malloc_host_P( p->n_ );
   }
   Assert( p->h_ );
+
+  MemTracker_allocate( p->category_, p->n_ * sizeof(P), Bool_false );
 }
 
 /*---------------------------------------------------------------------------*/
@@ -156,6 +196,8 @@ void Pointer_allocate_d_( Pointer* p )
     p->d_ = malloc_device_P( p->n_ );
 
     Assert( p->d_ );
+
+    MemTracker_allocate( p->category_, p->n_ * sizeof(P), Bool_true );
   }
 }
 
@@ -187,6 +229,8 @@ void Pointer_deallocate_h_( Pointer* p )
     free_host_P( p->h_ );
   }
   p->h_ = NULL;
+
+  MemTracker_free( p->category_, p->n_ * sizeof(P), Bool_false );
 }
 
 /*---------------------------------------------------------------------------*/
@@ -203,6 +247,8 @@ void Pointer_deallocate_d_( Pointer* p )
     free_device_P( p->d_ );
 
     p->d_ = NULL;
+
+    MemTracker_free( p->category_, p->n_ * sizeof(P), Bool_true );
   }
 }
 
@@ -61,9 +61,20 @@ void Pointer_create_alias( Pointer* p,
 
 /*---------------------------------------------------------------------------*/
 
+void Pointer_create_external( Pointer* p,
+                              P*       h,
+                              size_t   n );
+
+/*---------------------------------------------------------------------------*/
+
 void Pointer_set_pinned( Pointer* p,
                          Bool_t   is_pinned );
 
+/*---------------------------------------------------------------------------*/
+
+void Pointer_set_category( Pointer* p,
+                           int      category );
+
 /*===========================================================================*/
 /*---Pseudo-destructor---*/
 
@@ -38,6 +38,7 @@ typedef struct
   Bool_t          is_using_device_;
   Bool_t          is_pinned_;
   Bool_t          is_alias_;
+  int             category_;   /*---For memory tracking---*/
 } Pointer;
 
 /*===========================================================================*/
@@ -0,0 +1,264 @@
+/*---------------------------------------------------------------------------*/
+/*!
+ * \file   pool.cpp
+ * \author agent
+ * \date   Mon Oct 19 04:14:47 UTC 2026
+ * \brief  Pool of aligned host memory blocks, definitions.
+ */
+/*---------------------------------------------------------------------------*/
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "types.h"
+#include "env_assert.h"
+#include "env_openmp.h"
+#include "arguments.h"
+
+#include "pool.h"
+
+#ifdef __cplusplus_IGNORE
+extern "C"
+{
+#endif
+
+/*===========================================================================*/
+/*---Header kept in the POOL_ALIGN bytes before each block---*/
+
+enum{ POOL_MAGIC = 0x506f6f6c };
+
+typedef struct
+{
+  void*  base;       /*---As returned by the system---*/
+  size_t nbyte;      /*---Capacity of the block---*/
+  size_t align;
+  int    magic;
+} Pool_Header;
+
+static Pool_Header* Pool_header_( void* p )
+{
+  return (Pool_Header*)( (char*)p - POOL_ALIGN );
+}
+
+/*===========================================================================*/
+/*---Settings and state---*/
+
+static size_t pool_nbyte_cache_max_ = ((size_t)1024) * 1024 * 1024;
+static Bool_t pool_is_using_huge_pages_ = Bool_false;
+
+/*---Freed blocks, oldest first---*/
+
+static void*  pool_cache_[POOL_NCACHE_MAX];
+static int    pool_ncache_ = 0;
+static size_t pool_nbyte_cached_ = 0;
+
+static size_t pool_nallocate_ = 0;
+static size_t pool_nreuse_ = 0;
+
+/*===========================================================================*/
+/*---Remove a block from the cache---*/
+
+static void Pool_uncache_( int i_cache )
+{
+  Assert( i_cache >= 0 && i_cache < pool_ncache_ );
+
+  pool_nbyte_cached_ -= Pool_header_( pool_cache_[i_cache] )->nbyte;
+  --pool_ncache_;
+
+  int i = 0;
+  for( i=i_cache; i<pool_ncache_; ++i )
+  {
+    pool_cache_[i] = pool_cache_[i+1];
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---Return the oldest cached block to the system---*/
+
+static void Pool_evict_oldest_()
+{
+  void* const p = pool_cache_[0];
+  Pool_uncache_( 0 );
+  free( Pool_header_( p )->base );
+}
+
+/*===========================================================================*/
+/*---Set values from args---*/
+
+void Pool_set_values( Arguments* args )
+{
+  const double cache_mb = Arguments_consume_double_or_default( args,
+                                                   "--pool_cache_mb", 1024 );
+  Insist( cache_mb >= 0 ? "Invalid pool_cache_mb value." : 0 );
+
+  const int is_using_huge_pages = Arguments_consume_int_or_default( args,
+                                         "--is_using_huge_pages", Bool_false );
+  Insist( is_using_huge_pages == 0 || is_using_huge_pages == 1 ?
+          "Invalid is_using_huge_pages value." : 0 );
+
+  pool_nbyte_cache_max_ = (size_t)( cache_mb * 1024 * 1024 );
+  pool_is_using_huge_pages_ = is_using_huge_pages;
+
+  /*---Drop any blocks the new limit no longer allows---*/
+
+  while( pool_nbyte_cached_ > pool_nbyte_cache_max_ )
+  {
+    Pool_evict_oldest_();
+  }
+}
+
+/*===========================================================================*/
+/*---Alignment of a block of a given size---*/
+
+static size_t Pool_align_( size_t nbyte )
+{
+  if( pool_is_using_huge_pages_ && nbyte >= POOL_NBYTE_HUGE_PAGE_MIN )
+  {
+    return POOL_NBYTE_HUGE_PAGE;
+  }
+  if( nbyte >= POOL_NBYTE_PAGE_ALIGN )
+  {
+    const long nbyte_page = sysconf( _SC_PAGESIZE );
+    return nbyte_page > POOL_ALIGN ? (size_t)nbyte_page : POOL_ALIGN;
+  }
+  return POOL_ALIGN;
+}
+
+/*===========================================================================*/
+/*---Allocate a block---*/
+
+void* Pool_allocate( size_t nbyte )
+{
+  /*---The cache is shared by all threads and not locked---*/
+  Assert( ! Env_omp_in_parallel() );
+
+  const size_t align = Pool_align_( nbyte );
+  /*---Capacity, a whole number of alignment units---*/
+  const size_t nbyte_block = ( ( nbyte + align - 1 ) / align ) * align;
+
+  ++pool_nallocate_;
+
+  /*---Take the best fitting cached block, if any wastes at most a
+       quarter of the request---*/
+
+  int i_best = -1;
+  int i = 0;
+
+  for( i=0; i<pool_ncache_; ++i )
+  {
+    const Pool_Header* const header = Pool_header_( pool_cache_[i] );
+    if( header->align >= align && header->nbyte >= nbyte_block &&
+        header->nbyte <= nbyte_block + nbyte_block / 4 &&
+        ( i_best < 0 ||
+          header->nbyte < Pool_header_( pool_cache_[i_best] )->nbyte ) )
+    {
+      i_best = i;
+    }
+  }
+
+  if( i_best >= 0 )
+  {
+    void* const result = pool_cache_[i_best];
+    Pool_uncache_( i_best );
+    ++pool_nreuse_;
+    return result;
+  }
+
+  /*---Otherwise allocate from the system; the header takes the alignment
+       unit before the block---*/
+
+  void* base = NULL;
+  const int error = posix_memalign( &base, align, align + nbyte_block );
+  Insist( error == 0 && base ? "Host memory allocation failed." : 0 );
+
+  void* const result = (void*)( (char*)base + align );
+
+#ifdef MADV_HUGEPAGE
+  if( align == POOL_NBYTE_HUGE_PAGE )
+  {
+    madvise( result, nbyte_block, MADV_HUGEPAGE );
+  }
+#endif
+
+  Pool_Header* const header = Pool_header_( result );
+  header->base  = base;
+  header->nbyte = nbyte_block;
+  header->align = align;
+  header->magic = POOL_MAGIC;
+
+  return result;
+}
+
+/*===========================================================================*/
+/*---Free a block, to the cache if it fits, oldest blocks making room---*/
+
+void Pool_free( void* p )
+{
+  Assert( p );
+  Assert( ! Env_omp_in_parallel() );
+
+  Pool_Header* const header = Pool_header_( p );
+  Assert( header->magic == POOL_MAGIC );
+
+  if( header->nbyte > pool_nbyte_cache_max_ )
+  {
+    free( header->base );
+    return;
+  }
+
+  while( pool_ncache_ == POOL_NCACHE_MAX ||
+         pool_nbyte_cached_ + header->nbyte > pool_nbyte_cache_max_ )
+  {
+    Pool_evict_oldest_();
+  }
+
+  pool_cache_[pool_ncache_++] = p;
+  pool_nbyte_cached_ += header->nbyte;
+}
+
+/*===========================================================================*/
+/*---Return the cached blocks to the system---*/
+
+void Pool_release()
+{
+  int i = 0;
+
+  for( i=0; i<pool_ncache_; ++i )
+  {
+    free( Pool_header_( pool_cache_[i] )->base );
+  }
+  pool_ncache_ = 0;
+  pool_nbyte_cached_ = 0;
+}
+
+/*===========================================================================*/
+/*---Statistics---*/
+
+size_t Pool_nallocate()
+{
+  return pool_nallocate_;
+}
+
+/*---------------------------------------------------------------------------*/
+
+size_t Pool_nreuse()
+{
+  return pool_nreuse_;
+}
+
+/*---------------------------------------------------------------------------*/
+
+size_t Pool_nbyte_cached()
+{
+  return pool_nbyte_cached_;
+}
+
+/*===========================================================================*/
+
+#ifdef __cplusplus_IGNORE
+} /*---extern "C"---*/
+#endif
+
+/*---------------------------------------------------------------------------*/
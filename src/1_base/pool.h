@@ -0,0 +1,78 @@
+/*---------------------------------------------------------------------------*/
+/*!
+ * \file   pool.h
+ * \author agent
+ * \date   Mon Oct 19 04:14:47 UTC 2026
+ * \brief  Pool of aligned host memory blocks, header.
+ */
+/*---------------------------------------------------------------------------*/
+
+/*=============================================================================
+
+Host arrays are allocated from the pool, aligned to 64 bytes, or to a page
+if of at least POOL_NBYTE_PAGE_ALIGN bytes.  A freed block is kept in a
+cache of bounded size and given to a later request it fits without much
+waste, so that the arrays of repeated sweeps and runs are recycled rather
+than returned to the system.  Blocks of at least POOL_NBYTE_HUGE_PAGE_MIN
+bytes may be backed by huge pages.  The cache is not locked, so calls must
+be made outside threaded regions, which is asserted.
+
+=============================================================================*/
+
+#ifndef _pool_h_
+#define _pool_h_
+
+#include <stddef.h>
+
+#include "types.h"
+#include "arguments.h"
+
+#ifdef __cplusplus_IGNORE
+extern "C"
+{
+#endif
+
+/*===========================================================================*/
+/*---Enums---*/
+
+enum{ POOL_ALIGN               = 64 };
+enum{ POOL_NBYTE_PAGE_ALIGN    = 64 * 1024 };
+enum{ POOL_NBYTE_HUGE_PAGE     = 2 * 1024 * 1024 };
+enum{ POOL_NBYTE_HUGE_PAGE_MIN = 16 * POOL_NBYTE_HUGE_PAGE };
+enum{ POOL_NCACHE_MAX          = 64 };
+
+/*===========================================================================*/
+/*---Set values from args---*/
+
+void Pool_set_values( Arguments* args );
+
+/*===========================================================================*/
+/*---Allocate, free a block---*/
+
+void* Pool_allocate( size_t nbyte );
+
+void Pool_free( void* p );
+
+/*===========================================================================*/
+/*---Return the cached blocks to the system---*/
+
+void Pool_release(void);
+
+/*===========================================================================*/
+/*---Number of allocations, number served from the cache, bytes cached---*/
+
+size_t Pool_nallocate(void);
+
+size_t Pool_nreuse(void);
+
+size_t Pool_nbyte_cached(void);
+
+/*===========================================================================*/
+
+#ifdef __cplusplus_IGNORE
+} /*---extern "C"---*/
+#endif
+
+#endif /*---_pool_h_---*/
+
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,590 @@
+/*---------------------------------------------------------------------------*/
+/*!
+ * \file   profiler.cpp
+ * \author agent
+ * \date   Mon Oct 19 03:25:59 UTC 2026
+ * \brief  Per-phase timers for profiling the sweep, definitions.
+ */
+/*---------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "types.h"
+#include "env.h"
+#include "env_openmp_kernels.h"
+#include "pointer.h"
+
+#include "profiler.h"
+
+#ifdef __cplusplus_IGNORE
+extern "C"
+{
+#endif
+
+/*===========================================================================*/
+/*---Timers of one thread, padded so threads do not share cache lines---*/
+
+typedef struct
+{
+  long long time_ns[PROFILER_NPHASE];
+  long long count[PROFILER_NPHASE];
+  char      pad_[64];
+} Profiler_Thread_;
+
+static Profiler_Thread_ profiler_thread_[PROFILER_NTHREAD_MAX];
+
+/*===========================================================================*/
+/*---Events recorded for a timeline---*/
+
+typedef struct
+{
+  int       phase;
+  int       arg;
+  long long time_begin;
+  long long time_end;
+} Profiler_Event_;
+
+/*---Ring buffer of one thread; nevent_total counts all events recorded,
+     the last nevent of which are kept---*/
+
+typedef struct
+{
+  Profiler_Event_* events;
+  long long        nevent_total;
+  char             pad_[64];
+} Profiler_Ring_;
+
+typedef struct
+{
+  Bool_t          is_on;
+  int             nevent;
+  int             nthread;
+  long long       time_origin;
+  Profiler_Ring_* rings;
+} Profiler_Trace_;
+
+static Profiler_Trace_ profiler_trace_;
+
+/*===========================================================================*/
+/*---Enclosing phase of a phase, or -1---*/
+
+int Profiler_phase_parent( int phase )
+{
+  Assert( phase >= 0 && phase < PROFILER_NPHASE );
+
+  /*---Parents precede their children.  MPI waits are timed within each
+       of the face phases, so have no single parent and are reported
+       apart from the hierarchy---*/
+
+  static const int parent[PROFILER_NPHASE] = {
+    -1,                             /*---SWEEP---*/
+    PROFILER_PHASE_SWEEP,           /*---STEP---*/
+    PROFILER_PHASE_STEP,            /*---FACE_RECV_WAIT---*/
+    PROFILER_PHASE_STEP,            /*---FACE_SEND_WAIT---*/
+    PROFILER_PHASE_STEP,            /*---FACE_COMM---*/
+    -1,                             /*---MPI_WAIT---*/
+    PROFILER_PHASE_STEP,            /*---BLOCK_COMPUTE---*/
+    PROFILER_PHASE_BLOCK_COMPUTE,   /*---SEMIBLOCK---*/
+    PROFILER_PHASE_SEMIBLOCK,       /*---SUBBLOCK---*/
+    PROFILER_PHASE_SUBBLOCK,        /*---BOUNDARY_INIT---*/
+    PROFILER_PHASE_STEP,            /*---BLOCK_TRANSFER---*/
+    PROFILER_PHASE_SWEEP,           /*---OCTANT_REDUCE---*/
+    -1 };                           /*---NORMS---*/
+
+  return parent[phase];
+}
+
+/*===========================================================================*/
+/*---Name of a phase---*/
+
+const char* Profiler_phase_name( int phase )
+{
+  Assert( phase >= 0 && phase < PROFILER_NPHASE );
+
+  static const char* const name[PROFILER_NPHASE] = {
+    "sweep",
+    "step",
+    "face recv wait",
+    "face send wait",
+    "face comm",
+    "mpi wait",
+    "block compute",
+    "semiblock",
+    "subblock",
+    "boundary init",
+    "block transfer",
+    "octant reduce",
+    "norms" };
+
+  return name[phase];
+}
+
+/*===========================================================================*/
+/*---Monotonic time in nanoseconds---*/
+
+long long Profiler_time_ns()
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return ( (long long) ts.tv_sec ) * 1000000000LL + ts.tv_nsec;
+}
+
+/*===========================================================================*/
+/*---Add time since time_begin to a phase, for the calling thread---*/
+
+void Profiler_accumulate( int phase, long long time_begin, int arg )
+{
+  const long long time_end = Profiler_time_ns();
+  const int thread = Env_omp_thread();
+
+  Assert( phase >= 0 && phase < PROFILER_NPHASE );
+  Assert( thread >= 0 && thread < PROFILER_NTHREAD_MAX );
+
+  profiler_thread_[thread].time_ns[phase] += time_end - time_begin;
+  profiler_thread_[thread].count[phase]   += 1;
+
+  /*---Threads beyond those given buffers are not traced---*/
+
+  if( profiler_trace_.is_on && thread < profiler_trace_.nthread )
+  {
+    Profiler_Ring_* const ring = &profiler_trace_.rings[thread];
+    Profiler_Event_* const event = &ring->events[ ring->nevent_total %
+                                                 profiler_trace_.nevent ];
+    event->phase      = phase;
+    event->arg        = arg;
+    event->time_begin = time_begin;
+    event->time_end   = time_end;
+    ++ring->nevent_total;
+  }
+}
+
+/*===========================================================================*/
+/*---Zero all timers---*/
+
+void Profiler_reset()
+{
+  memset( (void*)profiler_thread_, 0, sizeof(profiler_thread_) );
+
+  /*---Event times are taken from here---*/
+
+  profiler_trace_.time_origin = Profiler_time_ns();
+
+  int thread = 0;
+  for( thread=0; thread<profiler_trace_.nthread; ++thread )
+  {
+    profiler_trace_.rings[thread].nevent_total = 0;
+  }
+}
+
+/*===========================================================================*/
+/*---Reduce timers across active procs: calls averaged over procs, and
+     min, avg, max over procs of the time of the slowest thread---*/
+
+static void Profiler_reduce_( Env*    env,
+                              double* count_avg,
+                              double* time_min,
+                              double* time_avg,
+                              double* time_max )
+{
+  const int nproc = Env_nproc( env );
+  int phase = 0;
+
+  /*---Time of a proc is that of its slowest thread; calls are summed over
+       threads---*/
+
+  for( phase=0; phase<PROFILER_NPHASE; ++phase )
+  {
+    double time_this = 0;
+    double count_this = 0;
+    int thread = 0;
+
+    for( thread=0; thread<PROFILER_NTHREAD_MAX; ++thread )
+    {
+      const double time_thread = 1.e-9 *
+                                 profiler_thread_[thread].time_ns[phase];
+      time_this = time_thread > time_this ? time_thread : time_this;
+      count_this += profiler_thread_[thread].count[phase];
+    }
+
+    time_min[phase] = Env_min_d( env, time_this );
+    time_max[phase] = Env_max_d( env, time_this );
+    count_avg[phase] = Env_sum_d( env, count_this ) / nproc;
+    time_avg[phase] = Env_sum_d( env, time_this ) / nproc;
+  }
+}
+
+/*===========================================================================*/
+/*---Reduce timers across active procs, print table on master; must be
+     called by all active procs---*/
+
+void Profiler_print( Env* env )
+{
+  if( ! IS_USING_PROFILER )
+  {
+    return;
+  }
+
+  double count_avg[PROFILER_NPHASE];
+  double time_min[PROFILER_NPHASE];
+  double time_avg[PROFILER_NPHASE];
+  double time_max[PROFILER_NPHASE];
+  int phase = 0;
+
+  Profiler_reduce_( env, count_avg, time_min, time_avg, time_max );
+
+  if( ! Env_is_proc_master( env ) )
+  {
+    return;
+  }
+
+  printf( "Profile over %i procs (seconds, slowest thread of each):\n",
+          Env_nproc( env ) );
+  printf( "  %-22s %12s %10s %10s %10s %8s\n",
+          "phase", "calls", "min", "avg", "max", "%parent" );
+
+  for( phase=0; phase<PROFILER_NPHASE; ++phase )
+  {
+    if( count_avg[phase] == 0 || phase == PROFILER_PHASE_MPI_WAIT )
+    {
+      continue;
+    }
+
+    /*---Indent by depth in the phase hierarchy---*/
+
+    const int parent = Profiler_phase_parent( phase );
+    int depth = 0;
+    int p = 0;
+    for( p=parent; p>=0; p=Profiler_phase_parent( p ) )
+    {
+      ++depth;
+    }
+
+    char label[64];
+    sprintf( label, "%*s%s", 2*depth, "", Profiler_phase_name( phase ) );
+
+    printf( "  %-22s %12.0f %10.6f %10.6f %10.6f", label, count_avg[phase],
+            time_min[phase], time_avg[phase], time_max[phase] );
+    if( parent >= 0 && time_avg[parent] > 0 )
+    {
+      printf( " %8.1f", 100. * time_avg[phase] / time_avg[parent] );
+    }
+    printf( "\n" );
+  }
+
+  /*---MPI waits, as a percentage of the step time that contains them---*/
+
+  phase = PROFILER_PHASE_MPI_WAIT;
+  if( count_avg[phase] != 0 )
+  {
+    printf( "  %-22s %12.0f %10.6f %10.6f %10.6f", "mpi wait, in faces",
+            count_avg[phase], time_min[phase], time_avg[phase],
+            time_max[phase] );
+    if( time_avg[PROFILER_PHASE_STEP] > 0 )
+    {
+      printf( " %8.1f", 100. * time_avg[phase] /
+                        time_avg[PROFILER_PHASE_STEP] );
+    }
+    printf( "\n" );
+  }
+}
+
+/*===========================================================================*/
+/*---Reduce timers across active procs, write them on master as a member
+     of a JSON object; must be called by all active procs---*/
+
+void Profiler_write_json( Env* env, FILE* file )
+{
+  if( ! IS_USING_PROFILER )
+  {
+    return;
+  }
+
+  double count_avg[PROFILER_NPHASE];
+  double time_min[PROFILER_NPHASE];
+  double time_avg[PROFILER_NPHASE];
+  double time_max[PROFILER_NPHASE];
+  int phase = 0;
+
+  Profiler_reduce_( env, count_avg, time_min, time_avg, time_max );
+
+  if( ! Env_is_proc_master( env ) )
+  {
+    return;
+  }
+
+  Assert( file );
+
+  fprintf( file, ",\n  \"profiler\": {" );
+  for( phase=0; phase<PROFILER_NPHASE; ++phase )
+  {
+    const int parent = Profiler_phase_parent( phase );
+    fprintf( file, "%s\n    \"%s\": { \"parent\": ", phase == 0 ? "" : ",",
+             Profiler_phase_name( phase ) );
+    if( parent >= 0 )
+    {
+      fprintf( file, "\"%s\"", Profiler_phase_name( parent ) );
+    }
+    else
+    {
+      fprintf( file, "null" );
+    }
+    fprintf( file, ", \"calls\": %.17g, \"time_min\": %.17g, "
+             "\"time_avg\": %.17g, \"time_max\": %.17g }",
+             count_avg[phase], time_min[phase], time_avg[phase],
+             time_max[phase] );
+  }
+  fprintf( file, "\n  }" );
+}
+
+/*===========================================================================*/
+/*---Start recording events, keeping the last nevent of each thread---*/
+
+void Profiler_trace_start( int nevent )
+{
+  Insist( IS_USING_PROFILER ?
+          "Tracing requires a build with USE_PROFILER." : 0 );
+  Insist( nevent > 0 ? "Invalid trace event count supplied." : 0 );
+  Assert( ! profiler_trace_.is_on );
+
+  /*---Buffers are allocated up front for the threads available; the
+       sweeper reserves more if it runs more---*/
+
+  int nthread = 1;
+#ifdef USE_OPENMP
+  nthread = omp_get_max_threads() > omp_get_num_procs() ?
+            omp_get_max_threads() : omp_get_num_procs();
+#endif
+
+  profiler_trace_.nevent  = nevent;
+  profiler_trace_.nthread = 0;
+  profiler_trace_.rings   = NULL;
+  profiler_trace_.is_on   = Bool_true;
+
+  Profiler_trace_reserve( nthread );
+
+  profiler_trace_.time_origin = Profiler_time_ns();
+}
+
+/*===========================================================================*/
+/*---If recording, ensure buffers for at least nthread threads---*/
+
+void Profiler_trace_reserve( int nthread_req )
+{
+  if( ! profiler_trace_.is_on )
+  {
+    return;
+  }
+
+  const int nthread = nthread_req < PROFILER_NTHREAD_MAX ?
+                      nthread_req : PROFILER_NTHREAD_MAX;
+  const int nevent = profiler_trace_.nevent;
+
+  if( nthread <= profiler_trace_.nthread )
+  {
+    return;
+  }
+
+  profiler_trace_.rings = (Profiler_Ring_*) realloc(
+            (void*)profiler_trace_.rings, nthread * sizeof(Profiler_Ring_) );
+  Insist( profiler_trace_.rings ? "Trace allocation failed." : 0 );
+
+  int thread = 0;
+  for( thread=profiler_trace_.nthread; thread<nthread; ++thread )
+  {
+    Profiler_Ring_* const ring = &profiler_trace_.rings[thread];
+    ring->events = (Profiler_Event_*)
+                                 malloc( nevent * sizeof(Profiler_Event_) );
+    Insist( ring->events ? "Trace allocation failed." : 0 );
+    /*---Touch the pages now rather than while timing---*/
+    memset( (void*)ring->events, 0, nevent * sizeof(Profiler_Event_) );
+    ring->nevent_total = 0;
+  }
+
+  profiler_trace_.nthread = nthread;
+}
+
+/*===========================================================================*/
+/*---Pack the kept events of this proc: thread, phase, arg, begin, end---*/
+/*---pseudo-private member function---*/
+
+enum{ PROFILER_NVALUE_PER_EVENT = 5 };
+
+static P* Profiler_trace_pack_( int* nevent_packed )
+{
+  int nevent = 0;
+  int thread = 0;
+
+  for( thread=0; thread<profiler_trace_.nthread; ++thread )
+  {
+    const long long n = profiler_trace_.rings[thread].nevent_total;
+    nevent += n < profiler_trace_.nevent ? (int)n : profiler_trace_.nevent;
+  }
+
+  P* const values = malloc_host_P( nevent * PROFILER_NVALUE_PER_EVENT + 1 );
+  P* v = values;
+
+  for( thread=0; thread<profiler_trace_.nthread; ++thread )
+  {
+    const Profiler_Ring_* const ring = &profiler_trace_.rings[thread];
+    const long long first = ring->nevent_total > profiler_trace_.nevent ?
+                            ring->nevent_total - profiler_trace_.nevent : 0;
+    long long i = 0;
+
+    /*---Oldest kept event first---*/
+
+    for( i=first; i<ring->nevent_total; ++i )
+    {
+      const Profiler_Event_* const event =
+                                &ring->events[ i % profiler_trace_.nevent ];
+      *(v++) = thread;
+      *(v++) = event->phase;
+      *(v++) = event->arg;
+      *(v++) = event->time_begin - profiler_trace_.time_origin;
+      *(v++) = event->time_end   - profiler_trace_.time_origin;
+    }
+  }
+
+  *nevent_packed = nevent;
+  return values;
+}
+
+/*===========================================================================*/
+/*---Write packed events of a proc as trace-event JSON---*/
+/*---pseudo-private member function---*/
+
+static void Profiler_trace_write_proc_( FILE*    file,
+                                        int      proc,
+                                        const P* values,
+                                        int      nevent,
+                                        int*     is_thread_named )
+{
+  int i = 0;
+
+  fprintf( file, "%s\n{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%i,"
+                 "\"args\":{\"name\":\"rank %i\"}}",
+           proc == 0 ? "" : ",", proc, proc );
+
+  for( i=0; i<PROFILER_NTHREAD_MAX; ++i )
+  {
+    is_thread_named[i] = Bool_false;
+  }
+
+  for( i=0; i<nevent; ++i )
+  {
+    const P* const v = &values[ i * PROFILER_NVALUE_PER_EVENT ];
+    const int thread = (int) v[0];
+    const int phase  = (int) v[1];
+    const int arg    = (int) v[2];
+
+    if( ! is_thread_named[thread] )
+    {
+      fprintf( file, ",\n{\"ph\":\"M\",\"name\":\"thread_name\","
+                     "\"pid\":%i,\"tid\":%i,"
+                     "\"args\":{\"name\":\"thread %i\"}}",
+               proc, thread, thread );
+      is_thread_named[thread] = Bool_true;
+    }
+
+    /*---Times in microseconds---*/
+
+    fprintf( file, ",\n{\"ph\":\"X\",\"name\":\"%s\",\"pid\":%i,"
+                   "\"tid\":%i,\"ts\":%.3f,\"dur\":%.3f",
+             Profiler_phase_name( phase ), proc, thread,
+             1.e-3 * v[3], 1.e-3 * ( v[4] - v[3] ) );
+    if( arg != -1 )
+    {
+      fprintf( file, ",\"args\":{\"%s\":%i}",
+               phase == PROFILER_PHASE_STEP      ? "step" :
+               phase == PROFILER_PHASE_SEMIBLOCK ? "semiblock_step" :
+                                                   "subblockwave", arg );
+    }
+    fprintf( file, "}" );
+  }
+}
+
+/*===========================================================================*/
+/*---Write the events of all active procs as trace-event JSON---*/
+
+void Profiler_trace_write( Env* env, const char* filename )
+{
+  Assert( filename );
+  Assert( profiler_trace_.is_on );
+
+  const int nproc = Env_nproc( env );
+  const int proc_this = Env_proc_this( env );
+  const int tag = Env_tag( env );
+
+  int nevent = 0;
+  P* values = Profiler_trace_pack_( &nevent );
+
+  /*---Events are sent to the master, which writes them a proc at a time---*/
+
+  if( proc_this != 0 )
+  {
+    Env_send_i( env, &nevent, 1, 0, tag );
+    Env_send_P( env, values, nevent * PROFILER_NVALUE_PER_EVENT, 0, tag );
+  }
+  else
+  {
+    FILE* const file = fopen( filename, "w" );
+    Insist( file ? "Unable to open trace file." : 0 );
+
+    int* const is_thread_named = malloc_host_int( PROFILER_NTHREAD_MAX );
+    int proc = 0;
+
+    fprintf( file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[" );
+
+    for( proc=0; proc<nproc; ++proc )
+    {
+      if( proc != 0 )
+      {
+        free_host_P( values );
+        Env_recv_i( env, &nevent, 1, proc, tag );
+        values = malloc_host_P( nevent * PROFILER_NVALUE_PER_EVENT + 1 );
+        Env_recv_P( env, values, nevent * PROFILER_NVALUE_PER_EVENT, proc,
+                    tag );
+      }
+      Profiler_trace_write_proc_( file, proc, values, nevent,
+                                  is_thread_named );
+    }
+
+    fprintf( file, "\n]}\n" );
+    fclose( file );
+
+    free_host_int( is_thread_named );
+  }
+
+  free_host_P( values );
+
+  Env_increment_tag( env, 1 );
+}
+
+/*===========================================================================*/
+/*---Stop recording events, free buffers---*/
+
+void Profiler_trace_stop()
+{
+  int thread = 0;
+
+  for( thread=0; thread<profiler_trace_.nthread; ++thread )
+  {
+    free( (void*) profiler_trace_.rings[thread].events );
+  }
+  if( profiler_trace_.rings )
+  {
+    free( (void*) profiler_trace_.rings );
+  }
+
+  memset( (void*)&profiler_trace_, 0, sizeof(profiler_trace_) );
+}
+
+/*===========================================================================*/
+
+#ifdef __cplusplus_IGNORE
+} /*---extern "C"---*/
+#endif
+
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,73 @@
+/*---------------------------------------------------------------------------*/
+/*!
+ * \file   profiler.h
+ * \author agent
+ * \date   Mon Oct 19 03:25:59 UTC 2026
+ * \brief  Per-phase timers for profiling the sweep, header.
+ */
+/*---------------------------------------------------------------------------*/
+
+#ifndef _profiler_h_
+#define _profiler_h_
+
+#include <stdio.h>
+
+#include "types.h"
+#include "env.h"
+
+#include "profiler_kernels.h"
+
+#ifdef __cplusplus_IGNORE
+extern "C"
+{
+#endif
+
+/*===========================================================================*/
+/*---Zero all timers---*/
+
+void Profiler_reset(void);
+
+/*===========================================================================*/
+/*---Reduce timers across active procs, print table on master; must be
+     called by all active procs---*/
+
+void Profiler_print( Env* env );
+
+/*===========================================================================*/
+/*---Reduce timers across active procs, write them on master as a member
+     of a JSON object; must be called by all active procs---*/
+
+void Profiler_write_json( Env* env, FILE* file );
+
+/*===========================================================================*/
+/*---Start recording events, keeping the last nevent of each thread---*/
+
+void Profiler_trace_start( int nevent );
+
+/*===========================================================================*/
+/*---If recording, ensure buffers for at least nthread threads; to be called
+     before the threads are started---*/
+
+void Profiler_trace_reserve( int nthread );
+
+/*===========================================================================*/
+/*---Write the events of all active procs as trace-event JSON, one process
+     per proc and one track per thread; must be called by all active
+     procs---*/
+
+void Profiler_trace_write( Env* env, const char* filename );
+
+/*===========================================================================*/
+/*---Stop recording events, free buffers---*/
+
+void Profiler_trace_stop(void);
+
+/*===========================================================================*/
+
+#ifdef __cplusplus_IGNORE
+} /*---extern "C"---*/
+#endif
+
+#endif /*---_profiler_h_---*/
+
+/*---------------------------------------------------------------------------*/
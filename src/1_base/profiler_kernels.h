@@ -0,0 +1,118 @@
+/*---------------------------------------------------------------------------*/
+/*!
+ * \file   profiler_kernels.h
+ * \author agent
+ * \date   Mon Oct 19 03:25:59 UTC 2026
+ * \brief  Per-phase timers for profiling the sweep, code for comp. kernel.
+ */
+/*---------------------------------------------------------------------------*/
+
+/*=============================================================================
+
+Timers are accumulated per phase and per OpenMP thread, and are compiled
+only if USE_PROFILER is defined; otherwise Profiler_begin / Profiler_end
+expand to nothing.  A phase is timed by
+
+  Profiler_begin( BLOCK_COMPUTE );
+  ...
+  Profiler_end( BLOCK_COMPUTE );
+
+within one scope.  Phases are nested as given by Profiler_phase_parent.
+When tracing, each timed interval is also kept as an event in a ring
+buffer of the thread, for writing as a timeline.
+
+=============================================================================*/
+
+#ifndef _profiler_kernels_h_
+#define _profiler_kernels_h_
+
+#include "types_kernels.h"
+#include "env_assert_kernels.h"
+
+#ifdef __cplusplus_IGNORE
+extern "C"
+{
+#endif
+
+/*===========================================================================*/
+/*---Enums---*/
+
+#ifdef USE_PROFILER
+enum{ IS_USING_PROFILER = Bool_true };
+#else
+enum{ IS_USING_PROFILER = Bool_false };
+#endif
+
+/*---Phases timed---*/
+
+enum{ PROFILER_PHASE_SWEEP          =  0,
+      PROFILER_PHASE_STEP           =  1,
+      PROFILER_PHASE_FACE_RECV_WAIT =  2,
+      PROFILER_PHASE_FACE_SEND_WAIT =  3,
+      PROFILER_PHASE_FACE_COMM      =  4,
+      PROFILER_PHASE_MPI_WAIT       =  5,
+      PROFILER_PHASE_BLOCK_COMPUTE  =  6,
+      PROFILER_PHASE_SEMIBLOCK      =  7,
+      PROFILER_PHASE_SUBBLOCK       =  8,
+      PROFILER_PHASE_BOUNDARY_INIT  =  9,
+      PROFILER_PHASE_BLOCK_TRANSFER = 10,
+      PROFILER_PHASE_OCTANT_REDUCE  = 11,
+      PROFILER_PHASE_NORMS          = 12,
+      PROFILER_NPHASE               = 13 };
+
+enum{ PROFILER_NTHREAD_MAX = 256 };
+
+/*===========================================================================*/
+/*---Enclosing phase of a phase, or -1---*/
+
+int Profiler_phase_parent( int phase );
+
+/*===========================================================================*/
+/*---Name of a phase---*/
+
+const char* Profiler_phase_name( int phase );
+
+/*===========================================================================*/
+/*---Monotonic time in nanoseconds---*/
+
+long long Profiler_time_ns(void);
+
+/*===========================================================================*/
+/*---Add time since time_begin to a phase, for the calling thread; if
+     tracing, also record the event, tagged with arg if not -1---*/
+
+void Profiler_accumulate( int phase, long long time_begin, int arg );
+
+/*===========================================================================*/
+/*---Macros to time a phase---*/
+
+#if defined(USE_PROFILER) && ! defined(__HIP_DEVICE_COMPILE__)
+
+#define Profiler_begin( phase ) \
+  const long long profiler_time_begin_##phase = Profiler_time_ns()
+
+#define Profiler_end( phase ) \
+  Profiler_accumulate( PROFILER_PHASE_##phase, profiler_time_begin_##phase, \
+                       -1 )
+
+#define Profiler_end_arg( phase, arg ) \
+  Profiler_accumulate( PROFILER_PHASE_##phase, profiler_time_begin_##phase, \
+                       arg )
+
+#else
+
+#define Profiler_begin( phase )
+#define Profiler_end( phase )
+#define Profiler_end_arg( phase, arg )
+
+#endif
+
+/*===========================================================================*/
+
+#ifdef __cplusplus_IGNORE
+} /*---extern "C"---*/
+#endif
+
+#endif /*---_profiler_kernels_h_---*/
+
+/*---------------------------------------------------------------------------*/
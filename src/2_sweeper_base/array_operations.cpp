@@ -102,6 +102,14 @@ void get_state_norms( const P* const RESTRICT     vi,
   }
   Assert( normsq     >= P_zero() );
   Assert( normsqdiff >= P_zero() );
+
+  /*---State is replicated across octant groups, so count it once---*/
+  if( Env_proc_octant_this( env ) != 0 )
+  {
+    normsq     = P_zero();
+    normsqdiff = P_zero();
+  }
+
   normsq     = Env_sum_P( env, normsq );
   normsqdiff = Env_sum_P( env, normsqdiff );
 
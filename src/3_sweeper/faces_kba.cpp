@@ -8,7 +8,11 @@
  */
 /*---------------------------------------------------------------------------*/
 
+#include <string.h>
+
 #include "env.h"
+#include "profiler.h"
+#include "memtracker.h"
 #include "faces_kba.h"
 #include "array_operations.h"
 
@@ -17,19 +21,310 @@ extern "C"
 {
 #endif
 
+/*===========================================================================*/
+/*---Shared memory face comm: counters of faces sent and consumed---*/
+
+/*---For each octant, axis and direction, the sending proc counts faces it
+     has made available and the receiving proc counts faces it has copied
+     out, each in its own window segment.
+---*/
+
+enum{ FACES_NCOUNTER = 2 * NOCTANT * 2 * 2 };
+
+static int Faces_counter_index_( Bool_t is_consumed,
+                                 int    octant_in_block,
+                                 int    axis,
+                                 int    dir_ind )
+{
+  Assert( octant_in_block >= 0 && octant_in_block < NOCTANT );
+  Assert( axis >= 0 && axis < 2 );
+  Assert( dir_ind >= 0 && dir_ind < 2 );
+  return dir_ind + 2 * ( axis + 2 * ( octant_in_block +
+                                        NOCTANT * ( is_consumed ? 1 : 0 ) ) );
+}
+
+/*---------------------------------------------------------------------------*/
+
+static Bool_t Faces_is_shm_send_( Faces* faces, int axis, int dir_ind )
+{
+  /*---Only xz and yz faces are exchanged through shared memory---*/
+  return Faces_is_face_comm_shm( faces ) && axis < 2 &&
+         faces->counters_send[axis][dir_ind] != NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static Bool_t Faces_is_shm_recv_( Faces* faces, int axis, int dir_ind )
+{
+  return Faces_is_face_comm_shm( faces ) && axis < 2 &&
+         faces->counters_recv[axis][dir_ind] != NULL;
+}
+
+/*===========================================================================*/
+/*---Shared memory face comm: allocate faces in windows, find neighbors---*/
+
+static void Faces_create_shm_( Faces*      faces,
+                               Dimensions  dims_b,
+                               Env*        env )
+{
+  int i = 0;
+
+  const size_t size_facexz = Dimensions_size_facexz( dims_b, NU,
+                                                   faces->noctant_per_block );
+  const size_t size_faceyz = Dimensions_size_faceyz( dims_b, NU,
+                                                   faces->noctant_per_block );
+
+  /*---Separate windows so that a neighbor's buffer offsets match ours:
+       x neighbors share ncell_y, y neighbors share ncell_x---*/
+
+  P* base_xz = NULL;
+  P* base_yz = NULL;
+
+  Env_win_allocate_shared( env, NDIM * size_facexz * sizeof(P),
+                           &base_xz, &faces->win_xz );
+  Env_win_allocate_shared( env, NDIM * size_faceyz * sizeof(P),
+                           &base_yz, &faces->win_yz );
+  Env_win_allocate_shared( env, FACES_NCOUNTER * sizeof(long),
+                           &faces->counters, &faces->win_counters );
+
+  faces->nbyte_shm = NDIM * ( size_facexz + size_faceyz ) * sizeof(P);
+  MemTracker_allocate( MEMTRACKER_FACES, faces->nbyte_shm, Bool_false );
+
+  for( i = 0; i < NDIM; ++i )
+  {
+    Pointer_create_external( Faces_facexz( faces, i ),
+                             base_xz + i * size_facexz, size_facexz );
+    Pointer_create_external( Faces_faceyz( faces, i ),
+                             base_yz + i * size_faceyz, size_faceyz );
+  }
+
+  for( i = 0; i < FACES_NCOUNTER; ++i )
+  {
+    faces->counters[i] = 0;
+  }
+  Env_win_sync( env, &faces->win_counters );
+
+  /*---Locate window segments of on-node neighbors---*/
+
+  const int proc_x = Env_proc_x_this( env );
+  const int proc_y = Env_proc_y_this( env );
+  const int proc_z = Env_proc_z_this( env );
+
+  int axis = 0;
+
+  for( axis=0; axis<2; ++axis )
+  {
+    const Bool_t axis_x = axis==0;
+    const Bool_t axis_y = axis==1;
+
+    int dir_ind = 0;
+
+    for( dir_ind=0; dir_ind<2; ++dir_ind )
+    {
+      const int dir = dir_ind==0 ? DIR_UP*1 : DIR_DN*1;
+      const int inc_x = axis_x ? Dir_inc( dir ) : 0;
+      const int inc_y = axis_y ? Dir_inc( dir ) : 0;
+
+      faces->counters_send[axis][dir_ind] = NULL;
+      faces->counters_recv[axis][dir_ind] = NULL;
+      faces->faces_recv[axis][dir_ind]    = NULL;
+
+      /*---Downstream neighbor, to which faces are sent---*/
+
+      const int proc_x_send = proc_x + inc_x;
+      const int proc_y_send = proc_y + inc_y;
+
+      if( proc_x_send >= 0 && proc_x_send < Env_nproc_x( env ) &&
+          proc_y_send >= 0 && proc_y_send < Env_nproc_y( env ) )
+      {
+        const int proc_node = Env_proc_node( env,
+                       Env_proc( env, proc_x_send, proc_y_send, proc_z ) );
+        if( proc_node >= 0 )
+        {
+          faces->counters_send[axis][dir_ind] = (volatile long*)
+            Env_win_shared_query( env, &faces->win_counters, proc_node );
+        }
+      }
+
+      /*---Upstream neighbor, from which faces are received---*/
+
+      const int proc_x_recv = proc_x - inc_x;
+      const int proc_y_recv = proc_y - inc_y;
+
+      if( proc_x_recv >= 0 && proc_x_recv < Env_nproc_x( env ) &&
+          proc_y_recv >= 0 && proc_y_recv < Env_nproc_y( env ) )
+      {
+        const int proc_node = Env_proc_node( env,
+                       Env_proc( env, proc_x_recv, proc_y_recv, proc_z ) );
+        if( proc_node >= 0 )
+        {
+          faces->counters_recv[axis][dir_ind] = (volatile long*)
+            Env_win_shared_query( env, &faces->win_counters, proc_node );
+          faces->faces_recv[axis][dir_ind] = (P*)
+            Env_win_shared_query( env, axis_x ? &faces->win_yz
+                                             : &faces->win_xz, proc_node );
+        }
+      }
+    } /*---dir_ind---*/
+  } /*---axis---*/
+
+  /*---Counters must be zeroed everywhere before any neighbor reads them---*/
+
+  Env_mpi_barrier( env );
+}
+
+/*===========================================================================*/
+/*---Size of each staging buffer for faces of virtual blocks---*/
+
+static size_t Faces_size_buf_vblock_( const Faces* faces,
+                                      Dimensions   dims_b )
+{
+  /*---The parts of a face of all virtual blocks together are no larger
+       than all copies of the face---*/
+
+  const int noctant_per_block = faces->noctant_per_block;
+  const size_t size_buf_xy = Dimensions_size_facexy( dims_b, NU,
+                                   noctant_per_block ) / noctant_per_block;
+  const size_t size_buf_xz = Dimensions_size_facexz( dims_b, NU,
+                 noctant_per_block ) / noctant_per_block * faces->nblock_y;
+  const size_t size_buf_yz = Dimensions_size_faceyz( dims_b, NU,
+                 noctant_per_block ) / noctant_per_block * faces->nblock_x;
+
+  return size_buf_xy > size_buf_xz ?
+         ( size_buf_xy > size_buf_yz ? size_buf_xy : size_buf_yz ) :
+         ( size_buf_xz > size_buf_yz ? size_buf_xz : size_buf_yz );
+}
+
+/*===========================================================================*/
+/*---Bytes of the faces, all copies---*/
+
+static size_t Faces_nbyte_faces_( Faces*      faces,
+                                  Dimensions  dims_b )
+{
+  const int noctant_per_block = faces->noctant_per_block;
+
+  return sizeof(P) * ( Dimensions_size_facexy( dims_b, NU,
+                                               noctant_per_block ) +
+    ( Faces_is_face_comm_async( faces ) ? NDIM : 1 ) *
+    ( Dimensions_size_facexz( dims_b, NU, noctant_per_block ) *
+                                                        faces->nblock_y +
+      Dimensions_size_faceyz( dims_b, NU, noctant_per_block ) *
+                                                        faces->nblock_x ) );
+}
+
+/*===========================================================================*/
+/*---Bytes of the staging buffers kept for the life of the faces---*/
+
+static size_t Faces_nbyte_bufs_( Faces*      faces,
+                                 Dimensions  dims_b,
+                                 Env*        env )
+{
+  const int noctant_per_block = faces->noctant_per_block;
+
+  size_t result = 0;
+
+  if( Faces_is_face_comm_async( faces ) && Env_nproc_z( env ) > 1 )
+  {
+    result += 2 * sizeof(P) *
+                      Dimensions_size_facexy( dims_b, NU, noctant_per_block );
+  }
+
+  if( Faces_is_face_comm_async( faces ) && faces->nangle_set > 1 )
+  {
+    result += 2 * sizeof(P) *
+                  ( Dimensions_size_facexz( dims_b, NU, noctant_per_block ) +
+                    Dimensions_size_faceyz( dims_b, NU, noctant_per_block ) );
+  }
+
+  if( faces->nblock_x * faces->nblock_y > 1 )
+  {
+    result += 2 * sizeof(P) * Faces_size_buf_vblock_( faces, dims_b );
+  }
+
+  return result;
+}
+
+/*===========================================================================*/
+/*---Bytes of the buffers made at each step of synchronous comm without
+     virtual blocks---*/
+
+static size_t Faces_nbyte_bufs_step_( Faces*      faces,
+                                      Dimensions  dims_b )
+{
+  const size_t size_facexy_per_octant = Dimensions_size_facexy( dims_b,
+                 NU, faces->noctant_per_block ) / faces->noctant_per_block;
+  const size_t size_facexz_per_octant = Dimensions_size_facexz( dims_b,
+                 NU, faces->noctant_per_block ) / faces->noctant_per_block;
+  const size_t size_faceyz_per_octant = Dimensions_size_faceyz( dims_b,
+                 NU, faces->noctant_per_block ) / faces->noctant_per_block;
+
+  /*---With angle sets, one more for the slice of the largest face---*/
+
+  const size_t size_face_per_octant_max =
+    size_facexy_per_octant > size_facexz_per_octant ?
+    ( size_facexy_per_octant > size_faceyz_per_octant ?
+      size_facexy_per_octant : size_faceyz_per_octant ) :
+    ( size_facexz_per_octant > size_faceyz_per_octant ?
+      size_facexz_per_octant : size_faceyz_per_octant );
+
+  return sizeof(P) * ( size_facexy_per_octant + size_facexz_per_octant +
+    size_faceyz_per_octant +
+    ( faces->nangle_set > 1 ? size_face_per_octant_max : 0 ) );
+}
+
+/*===========================================================================*/
+/*---Set the settings of the faces---*/
+/*---pseudo-private member function---*/
+
+static void Faces_set_values_( Faces*      faces,
+                               int         noctant_per_block,
+                               int         nangle_set,
+                               int         nblock_x,
+                               int         nblock_y,
+                               const int*  ix_base_block,
+                               const int*  iy_base_block,
+                               Bool_t      is_face_comm_async,
+                               Bool_t      is_face_comm_shm,
+                               Env*        env )
+{
+  Insist( ( nblock_x * nblock_y == 1 || ! is_face_comm_async ) ?
+           "Virtual blocks currently require synchronous face comm." : 0 );
+
+  Insist( ( is_face_comm_async || ! is_face_comm_shm ) ?
+           "Shared memory face comm requires asynchronous face comm." : 0 );
+  Insist( ( ! Env_hip_is_using_device( env ) || ! is_face_comm_shm ) ?
+           "Shared memory face comm not supported on device." : 0 );
+
+  faces->noctant_per_block  = noctant_per_block;
+  faces->nangle_set         = nangle_set;
+  faces->nblock_x           = nblock_x;
+  faces->nblock_y           = nblock_y;
+  faces->ix_base_block      = ix_base_block;
+  faces->iy_base_block      = iy_base_block;
+  faces->is_face_comm_async = is_face_comm_async;
+  faces->is_face_comm_shm   = is_face_comm_shm;
+}
+
 /*===========================================================================*/
 /*---Pseudo-constructor for Faces struct---*/
 
 void Faces_create( Faces*      faces,
                    Dimensions  dims_b,
                    int         noctant_per_block,
+                   int         nangle_set,
+                   int         nblock_x,
+                   int         nblock_y,
+                   const int*  ix_base_block,
+                   const int*  iy_base_block,
                    Bool_t      is_face_comm_async,
+                   Bool_t      is_face_comm_shm,
                    Env*        env )
 {
   int i = 0;
 
-  faces->noctant_per_block  = noctant_per_block;
-  faces->is_face_comm_async = is_face_comm_async;
+  Faces_set_values_( faces, noctant_per_block, nangle_set, nblock_x,
+                     nblock_y, ix_base_block, iy_base_block,
+                     is_face_comm_async, is_face_comm_shm, env );
 
   /*====================*/
   /*---Allocate faces---*/
@@ -39,32 +334,99 @@ void Faces_create( Faces*      faces,
     Dimensions_size_facexy( dims_b, NU, noctant_per_block ),
     Env_hip_is_using_device( env ) );
   Pointer_set_pinned( Faces_facexy( faces, 0 ), Bool_true );
+  Pointer_set_category( Faces_facexy( faces, 0 ), MEMTRACKER_FACES );
   Pointer_allocate(     Faces_facexy( faces, 0 ) );
 
-  for( i = 0; i < ( Faces_is_face_comm_async( faces ) ? NDIM : 1 ); ++i )
+  /*---The xy face is carried from block to block within a proc, so
+       it is not multiply buffered; async comm along z is staged instead---*/
+
+  faces->buf_xy_send = NULL;
+  faces->buf_xy_recv = NULL;
+  faces->nbyte_bufs  = Faces_nbyte_bufs_( faces, dims_b, env );
+  faces->nbyte_shm   = 0;
+
+  if( Faces_is_face_comm_async( faces ) && Env_nproc_z( env ) > 1 )
   {
-    Pointer_create(       Faces_facexz( faces, i ),
-      Dimensions_size_facexz( dims_b, NU, noctant_per_block ),
-      Env_hip_is_using_device( env ) );
-    Pointer_set_pinned( Faces_facexz( faces, i ), Bool_true );
-
-    Pointer_create(       Faces_faceyz( faces, i ),
-      Dimensions_size_faceyz( dims_b, NU, noctant_per_block ),
-      Env_hip_is_using_device( env ) );
-    Pointer_set_pinned( Faces_faceyz( faces, i ), Bool_true );
+    faces->buf_xy_send = malloc_host_P(
+                      Dimensions_size_facexy( dims_b, NU, noctant_per_block ) );
+    faces->buf_xy_recv = malloc_host_P(
+                      Dimensions_size_facexy( dims_b, NU, noctant_per_block ) );
   }
 
-  for( i = 0; i < ( Faces_is_face_comm_async( faces ) ? NDIM : 1 ); ++i )
+  /*---With angle sets, only the angles of the set are sent, so async
+       comm of xz and yz faces is staged too---*/
+
+  faces->buf_xz_send = NULL;
+  faces->buf_xz_recv = NULL;
+  faces->buf_yz_send = NULL;
+  faces->buf_yz_recv = NULL;
+
+  if( Faces_is_face_comm_async( faces ) && nangle_set > 1 )
+  {
+    faces->buf_xz_send = malloc_host_P(
+                      Dimensions_size_facexz( dims_b, NU, noctant_per_block ) );
+    faces->buf_xz_recv = malloc_host_P(
+                      Dimensions_size_facexz( dims_b, NU, noctant_per_block ) );
+    faces->buf_yz_send = malloc_host_P(
+                      Dimensions_size_faceyz( dims_b, NU, noctant_per_block ) );
+    faces->buf_yz_recv = malloc_host_P(
+                      Dimensions_size_faceyz( dims_b, NU, noctant_per_block ) );
+  }
+
+  /*---Faces of virtual blocks are staged at every step---*/
+
+  faces->buf_vblock_send = NULL;
+  faces->buf_vblock_recv = NULL;
+  faces->offset_vblock   = NULL;
+
+  if( nblock_x * nblock_y > 1 )
+  {
+    const size_t size_buf = Faces_size_buf_vblock_( faces, dims_b );
+
+    faces->buf_vblock_send = malloc_host_P( size_buf );
+    faces->buf_vblock_recv = malloc_host_P( size_buf );
+    faces->offset_vblock   = (size_t*) malloc( nblock_x * nblock_y *
+                                               sizeof(size_t) );
+  }
+
+  MemTracker_allocate( MEMTRACKER_FACE_BUFS, faces->nbyte_bufs, Bool_false );
+
+  /*---The windows hold the same copies of the xz and yz faces---*/
+
+  if( Faces_is_face_comm_shm( faces ) )
   {
-    Pointer_allocate( Faces_facexz( faces, i ) );
-    Pointer_allocate( Faces_faceyz( faces, i ) );
+    Faces_create_shm_( faces, dims_b, env );
+  }
+  else
+  {
+    for( i = 0; i < ( Faces_is_face_comm_async( faces ) ? NDIM : 1 ); ++i )
+    {
+      Pointer_create(       Faces_facexz( faces, i ),
+        Dimensions_size_facexz( dims_b, NU, noctant_per_block ) * nblock_y,
+        Env_hip_is_using_device( env ) );
+      Pointer_set_pinned( Faces_facexz( faces, i ), Bool_true );
+      Pointer_set_category( Faces_facexz( faces, i ), MEMTRACKER_FACES );
+
+      Pointer_create(       Faces_faceyz( faces, i ),
+        Dimensions_size_faceyz( dims_b, NU, noctant_per_block ) * nblock_x,
+        Env_hip_is_using_device( env ) );
+      Pointer_set_pinned( Faces_faceyz( faces, i ), Bool_true );
+      Pointer_set_category( Faces_faceyz( faces, i ), MEMTRACKER_FACES );
+    }
+
+    for( i = 0; i < ( Faces_is_face_comm_async( faces ) ? NDIM : 1 ); ++i )
+    {
+      Pointer_allocate( Faces_facexz( faces, i ) );
+      Pointer_allocate( Faces_faceyz( faces, i ) );
+    }
   }
 }
 
 /*===========================================================================*/
 /*---Pseudo-destructor for Faces struct---*/
 
-void Faces_destroy( Faces* faces )
+void Faces_destroy( Faces* faces,
+                    Env*   env )
 {
   int i = 0;
 
@@ -79,7 +441,467 @@ void Faces_destroy( Faces* faces )
     Pointer_destroy( Faces_facexz( faces, i ) );
     Pointer_destroy( Faces_faceyz( faces, i ) );
   }
+
+  if( faces->buf_xy_send )
+  {
+    free_host_P( faces->buf_xy_send );
+    free_host_P( faces->buf_xy_recv );
+  }
+  faces->buf_xy_send = NULL;
+  faces->buf_xy_recv = NULL;
+
+  if( faces->buf_xz_send )
+  {
+    free_host_P( faces->buf_xz_send );
+    free_host_P( faces->buf_xz_recv );
+    free_host_P( faces->buf_yz_send );
+    free_host_P( faces->buf_yz_recv );
+  }
+  faces->buf_xz_send = NULL;
+  faces->buf_xz_recv = NULL;
+  faces->buf_yz_send = NULL;
+  faces->buf_yz_recv = NULL;
+
+  if( faces->buf_vblock_send )
+  {
+    free_host_P( faces->buf_vblock_send );
+    free_host_P( faces->buf_vblock_recv );
+    free( (void*) faces->offset_vblock );
+  }
+  faces->buf_vblock_send = NULL;
+  faces->buf_vblock_recv = NULL;
+  faces->offset_vblock   = NULL;
+
+  MemTracker_free( MEMTRACKER_FACE_BUFS, faces->nbyte_bufs, Bool_false );
+  faces->nbyte_bufs = 0;
+
+  if( Faces_is_face_comm_shm( faces ) )
+  {
+    Env_win_free( env, &faces->win_xz );
+    Env_win_free( env, &faces->win_yz );
+    Env_win_free( env, &faces->win_counters );
+    faces->counters = NULL;
+
+    MemTracker_free( MEMTRACKER_FACES, faces->nbyte_shm, Bool_false );
+    faces->nbyte_shm = 0;
+  }
+}
+
+/*===========================================================================*/
+/*---Bytes the faces would allocate, added by memory tracker category---*/
+
+void Faces_predict_memory( size_t*     nbyte,
+                           size_t*     nbyte_device,
+                           size_t*     nbyte_step,
+                           Dimensions  dims_b,
+                           int         noctant_per_block,
+                           int         nangle_set,
+                           int         nblock_x,
+                           int         nblock_y,
+                           Bool_t      is_face_comm_async,
+                           Bool_t      is_face_comm_shm,
+                           Env*        env )
+{
+  Faces faces;
+  memset( (void*)&faces, 0, sizeof(Faces) );
+
+  Faces_set_values_( &faces, noctant_per_block, nangle_set, nblock_x,
+                     nblock_y, NULL, NULL, is_face_comm_async,
+                     is_face_comm_shm, env );
+
+  const size_t nbyte_faces = Faces_nbyte_faces_( &faces, dims_b );
+
+  nbyte[MEMTRACKER_FACES]     += nbyte_faces;
+  nbyte[MEMTRACKER_FACE_BUFS] += Faces_nbyte_bufs_( &faces, dims_b, env );
+
+  if( Env_hip_is_using_device( env ) )
+  {
+    nbyte_device[MEMTRACKER_FACES] += nbyte_faces;
+  }
+
+  *nbyte_step = ! is_face_comm_async && nblock_x * nblock_y == 1 ?
+                Faces_nbyte_bufs_step_( &faces, dims_b ) : 0;
+}
+
+/*===========================================================================*/
+/*---Face to communicate along an axis, for one octant---*/
+
+static P* Faces_face_per_octant_( Faces*      faces,
+                                  Dimensions  dims_b,
+                                  int         axis,
+                                  int         step,
+                                  int         octant_in_block )
+{
+  /*---Communicating along an axis moves the face normal to it---*/
+  return axis==0 ?
+    ref_faceyz( Pointer_h( Faces_faceyz_step( faces, step ) ),
+                dims_b, NU, faces->noctant_per_block,
+                0, 0, 0, 0, 0, octant_in_block ) :
+         axis==1 ?
+    ref_facexz( Pointer_h( Faces_facexz_step( faces, step ) ),
+                dims_b, NU, faces->noctant_per_block,
+                0, 0, 0, 0, 0, octant_in_block ) :
+    ref_facexy( Pointer_h( Faces_facexy_step( faces, step ) ),
+                dims_b, NU, faces->noctant_per_block,
+                0, 0, 0, 0, 0, octant_in_block );
+}
+
+/*===========================================================================*/
+/*---Angle set swept by a virtual block of this proc at a step, for one
+     octant---*/
+
+static void Faces_angle_range_( Faces*          faces,
+                                StepScheduler*  stepscheduler,
+                                Dimensions      dims_b,
+                                int             step,
+                                int             vblock,
+                                int             octant_in_block,
+                                int*            ia_min,
+                                int*            ia_max )
+{
+  const StepInfo stepinfo = StepScheduler_stepinfo_this( stepscheduler, step,
+                                                 vblock, octant_in_block );
+
+  *ia_min = StepInfo_ia_min( stepinfo, dims_b.na, faces->nangle_set );
+  *ia_max = StepInfo_ia_max( stepinfo, dims_b.na, faces->nangle_set );
+}
+
+/*===========================================================================*/
+/*---Copy an angle range of a face, for one octant---*/
+
+/*---Angle is the fastest varying face index, so a face is a sequence of
+     rows of angles and an angle range is a strided slice of it---*/
+
+static void Faces_copy_angles_( P* const RESTRICT        dest,
+                                int                      dest_na,
+                                const P* const RESTRICT  src,
+                                int                      src_na,
+                                size_t                   nrow,
+                                int                      na_copy )
+{
+  size_t irow = 0;
+
+  for( irow=0; irow<nrow; ++irow )
+  {
+    int ia = 0;
+    for( ia=0; ia<na_copy; ++ia )
+    {
+      dest[ ia + dest_na * irow ] = src[ ia + src_na * irow ];
+    }
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static P* Faces_buf_send_( Faces* faces, int axis )
+{
+  return axis==0 ? faces->buf_yz_send :
+         axis==1 ? faces->buf_xz_send :
+                   faces->buf_xy_send;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static P* Faces_buf_recv_( Faces* faces, int axis )
+{
+  return axis==0 ? faces->buf_yz_recv :
+         axis==1 ? faces->buf_xz_recv :
+                   faces->buf_xy_recv;
+}
+
+/*===========================================================================*/
+/*---Part of a face belonging to a virtual block, for one octant---*/
+
+/*---A face normal to an axis is indexed by the cells along the two other
+     axes, c0 and c1 in x, y, z order.  A virtual block owns a range of c0
+     of its own copy of the face, and for the xy face a range of c1---*/
+
+static void Faces_vblock_region_( Faces*      faces,
+                                  Dimensions  dims_b,
+                                  int         axis,
+                                  int         step,
+                                  int         vblock,
+                                  int         octant_in_block,
+                                  P**         face,
+                                  int*        nc0_face,
+                                  int*        c0_min,
+                                  int*        nc0,
+                                  int*        nc1_face,
+                                  int*        c1_min,
+                                  int*        nc1 )
+{
+  const int block_x = vblock % faces->nblock_x;
+  const int block_y = vblock / faces->nblock_x;
+
+  const int ix_min = faces->ix_base_block[ block_x ];
+  const int ncell_x = faces->ix_base_block[ block_x + 1 ] - ix_min;
+  const int iy_min = faces->iy_base_block[ block_y ];
+  const int ncell_y = faces->iy_base_block[ block_y + 1 ] - iy_min;
+
+  const size_t size_face = axis==0 ?
+    Dimensions_size_faceyz( dims_b, NU, faces->noctant_per_block ) :
+                           axis==1 ?
+    Dimensions_size_facexz( dims_b, NU, faces->noctant_per_block ) :
+    Dimensions_size_facexy( dims_b, NU, faces->noctant_per_block );
+
+  const int copy = axis==0 ? block_x : axis==1 ? block_y : 0;
+
+  *face = Faces_face_per_octant_( faces, dims_b, axis, step, octant_in_block )
+        + size_face * copy;
+
+  *nc0_face = axis==0 ? dims_b.ncell_y : dims_b.ncell_x;
+  *c0_min   = axis==0 ? iy_min         : ix_min;
+  *nc0      = axis==0 ? ncell_y        : ncell_x;
+  *nc1_face = axis==2 ? dims_b.ncell_y : dims_b.ncell_z;
+  *c1_min   = axis==2 ? iy_min         : 0;
+  *nc1      = axis==2 ? ncell_y        : dims_b.ncell_z;
+}
+
+/*===========================================================================*/
+/*---Copy an angle range of a region of a face to or from a buffer---*/
+
+void Faces_copy_region_( P* const RESTRICT  face,
+                         P* const RESTRICT  buf,
+                         Dimensions         dims_b,
+                         int                nc0_face,
+                         int                c0_min,
+                         int                nc0,
+                         int                nc1_face,
+                         int                c1_min,
+                         int                nc1,
+                         int                ia_min,
+                         int                na_copy,
+                         Bool_t             is_to_buf )
+{
+  int ie = 0;
+
+  for( ie=0; ie<dims_b.ne; ++ie )
+  {
+    int c1 = 0;
+    for( c1=0; c1<nc1; ++c1 )
+    {
+      int c0 = 0;
+      for( c0=0; c0<nc0; ++c0 )
+      {
+        int iu = 0;
+        for( iu=0; iu<NU; ++iu )
+        {
+          P* const face_row = face + ia_min + dims_b.na * (
+                       iu + NU * ( c0_min + c0 + nc0_face * (
+                                 ( c1_min + c1 + nc1_face * (size_t)ie ) ) ) );
+          P* const buf_row  = buf + na_copy * (
+                       iu + NU * ( c0 + nc0 * ( c1 + nc1 * (size_t)ie ) ) );
+          int ia = 0;
+          for( ia=0; ia<na_copy; ++ia )
+          {
+            if( is_to_buf )
+            {
+              buf_row[ia] = face_row[ia];
+            }
+            else
+            {
+              face_row[ia] = buf_row[ia];
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+/*===========================================================================*/
+/*---Communicate faces computed at step, used at step+1, virtual blocks---*/
+
+static void Faces_communicate_faces_vblock_(
+  Faces*          faces,
+  StepScheduler*  stepscheduler,
+  Dimensions      dims_b,
+  int             step,
+  Env*            env )
+{
+  const int proc_x = Env_proc_x_this( env );
+  const int proc_y = Env_proc_y_this( env );
+  const int proc_z = Env_proc_z_this( env );
+
+  const int nblock_x = faces->nblock_x;
+  const int nblock_y = faces->nblock_y;
+  const int nvblock  = nblock_x * nblock_y;
+
+  const int noctant_per_block = faces->noctant_per_block;
+
+  /*---Staging buffers, allocated at create---*/
+
+  P* RESTRICT const buf_send = faces->buf_vblock_send;
+  P* RESTRICT const buf_recv = faces->buf_vblock_recv;
+  size_t* const offset = faces->offset_vblock;
+
+  Assert( buf_send && buf_recv && offset );
+
+  int octant_in_block = 0;
+
+  for( octant_in_block=0; octant_in_block<noctant_per_block;
+                                                            ++octant_in_block )
+  {
+    int axis = 0;
+
+    for( axis=0; axis<NDIM; ++axis )  /*---Loop: X, Y, Z---*/
+    {
+      const Bool_t axis_x = axis==0;
+      const Bool_t axis_y = axis==1;
+      const Bool_t axis_z = axis==2;
+
+      const int proc_axis = axis_x ? proc_x : axis_y ? proc_y : proc_z;
+
+      P* face = NULL;
+      int nc0_face = 0, c0_min = 0, nc0 = 0;
+      int nc1_face = 0, c1_min = 0, nc1 = 0;
+      int ia_min = 0, ia_max = 0;
+
+      int vblock = 0;
+      int dir_ind = 0;
+      size_t offset_next = 0;
+
+      /*---Place of the part of each virtual block in the buffers---*/
+
+      for( vblock=0; vblock<nvblock; ++vblock )
+      {
+        Faces_vblock_region_( faces, dims_b, axis, step, vblock,
+                              octant_in_block, &face, &nc0_face, &c0_min,
+                              &nc0, &nc1_face, &c1_min, &nc1 );
+        offset[vblock] = offset_next;
+        offset_next += dims_b.na * NU * nc0 * (size_t)nc1 * dims_b.ne;
+      }
+
+      /*---Stage all faces to send, to another proc or to a virtual block
+           of this one, before any is overwritten---*/
+
+      for( vblock=0; vblock<nvblock; ++vblock )
+      {
+        for( dir_ind=0; dir_ind<2; ++dir_ind )
+        {
+          if( StepScheduler_must_do_send( stepscheduler, step, vblock, axis,
+                                          dir_ind, octant_in_block, env ) )
+          {
+            Faces_angle_range_( faces, stepscheduler, dims_b, step, vblock,
+                                octant_in_block, &ia_min, &ia_max );
+            Faces_vblock_region_( faces, dims_b, axis, step, vblock,
+                                  octant_in_block, &face, &nc0_face, &c0_min,
+                                  &nc0, &nc1_face, &c1_min, &nc1 );
+            Faces_copy_region_( face, buf_send + offset[vblock], dims_b,
+                                nc0_face, c0_min, nc0, nc1_face, c1_min, nc1,
+                                ia_min, ia_max - ia_min, Bool_true );
+          }
+        }
+      }
+
+      /*---Exchange with other procs - red/black coloring to avoid
+           deadlock.  Along x and y only the virtual blocks at the edge of
+           this proc take part---*/
+
+      for( dir_ind=0; dir_ind<2; ++dir_ind ) /*---Loop: up, down---*/
+      {
+        const int dir = dir_ind==0 ? DIR_UP*1 : DIR_DN*1;
+        const int inc_x = axis_x ? Dir_inc( dir ) : 0;
+        const int inc_y = axis_y ? Dir_inc( dir ) : 0;
+        const int inc_z = axis_z ? Dir_inc( dir ) : 0;
+
+        int color = 0;
+
+        for( color=0; color<2; ++color )
+        {
+          const Bool_t is_sending = ( color == 0 ) == ( proc_axis % 2 == 0 );
+
+          for( vblock=0; vblock<nvblock; ++vblock )
+          {
+            const int block_x = vblock % nblock_x;
+            const int block_y = vblock / nblock_x;
+
+            const Bool_t is_send_remote = axis_z ||
+              block_x + inc_x < 0 || block_x + inc_x >= nblock_x ||
+              block_y + inc_y < 0 || block_y + inc_y >= nblock_y;
+            const Bool_t is_recv_remote = axis_z ||
+              block_x - inc_x < 0 || block_x - inc_x >= nblock_x ||
+              block_y - inc_y < 0 || block_y - inc_y >= nblock_y;
+
+            /*---The neighbor block lies in the same row across procs---*/
+            const int tag = Env_tag( env ) + octant_in_block +
+                            noctant_per_block * ( axis_x ? block_y :
+                                                  axis_y ? block_x : vblock );
+
+            Faces_vblock_region_( faces, dims_b, axis, step, vblock,
+                                  octant_in_block, &face, &nc0_face, &c0_min,
+                                  &nc0, &nc1_face, &c1_min, &nc1 );
+
+            if( is_sending && is_send_remote &&
+                StepScheduler_must_do_send( stepscheduler, step, vblock,
+                                       axis, dir_ind, octant_in_block, env ) )
+            {
+              const int proc_other = Env_proc( env, proc_x+inc_x,
+                                               proc_y+inc_y, proc_z+inc_z );
+              Faces_angle_range_( faces, stepscheduler, dims_b, step, vblock,
+                                  octant_in_block, &ia_min, &ia_max );
+              Env_send_P( env, buf_send + offset[vblock],
+                          ( ia_max - ia_min ) * NU * nc0 * (size_t)nc1 *
+                          dims_b.ne, proc_other, tag );
+            }
+
+            if( ! is_sending && is_recv_remote &&
+                StepScheduler_must_do_recv( stepscheduler, step, vblock,
+                                       axis, dir_ind, octant_in_block, env ) )
+            {
+              const int proc_other = Env_proc( env, proc_x-inc_x,
+                                               proc_y-inc_y, proc_z-inc_z );
+              Faces_angle_range_( faces, stepscheduler, dims_b, step+1,
+                             vblock, octant_in_block, &ia_min, &ia_max );
+              Profiler_begin( MPI_WAIT );
+              Env_recv_P( env, buf_recv + offset[vblock],
+                          ( ia_max - ia_min ) * NU * nc0 * (size_t)nc1 *
+                          dims_b.ne, proc_other, tag );
+              Profiler_end( MPI_WAIT );
+            }
+          } /*---vblock---*/
+        } /*---color---*/
+      } /*---dir_ind---*/
+
+      /*---Move the received faces into place; a face from a virtual block
+           of this proc is taken from where it was staged---*/
+
+      for( vblock=0; vblock<nvblock; ++vblock )
+      {
+        for( dir_ind=0; dir_ind<2; ++dir_ind )
+        {
+          const int dir = dir_ind==0 ? DIR_UP*1 : DIR_DN*1;
+          const int inc_x = axis_x ? Dir_inc( dir ) : 0;
+          const int inc_y = axis_y ? Dir_inc( dir ) : 0;
+
+          const int block_x = vblock % nblock_x;
+          const int block_y = vblock / nblock_x;
+
+          const Bool_t is_recv_remote = axis_z ||
+            block_x - inc_x < 0 || block_x - inc_x >= nblock_x ||
+            block_y - inc_y < 0 || block_y - inc_y >= nblock_y;
+
+          if( StepScheduler_must_do_recv( stepscheduler, step, vblock, axis,
+                                          dir_ind, octant_in_block, env ) )
+          {
+            P* const buf = is_recv_remote ? buf_recv + offset[vblock] :
+              buf_send + offset[ vblock - inc_x - nblock_x * inc_y ];
+
+            Faces_angle_range_( faces, stepscheduler, dims_b, step+1, vblock,
+                                octant_in_block, &ia_min, &ia_max );
+            Faces_vblock_region_( faces, dims_b, axis, step, vblock,
+                                  octant_in_block, &face, &nc0_face, &c0_min,
+                                  &nc0, &nc1_face, &c1_min, &nc1 );
+            Faces_copy_region_( face, buf, dims_b,
+                                nc0_face, c0_min, nc0, nc1_face, c1_min, nc1,
+                                ia_min, ia_max - ia_min, Bool_false );
+          }
+        }
+      } /*---vblock---*/
+    } /*---axis---*/
+  } /*---octant_in_block---*/
 }
+
 /*===========================================================================*/
 /*---Communicate faces computed at step, used at step+1---*/
 
@@ -92,9 +914,18 @@ void Faces_communicate_faces(
 {
   Assert( ! Faces_is_face_comm_async( faces ) );
 
+  if( faces->nblock_x * faces->nblock_y > 1 )
+  {
+    Faces_communicate_faces_vblock_( faces, stepscheduler, dims_b, step, env );
+    return;
+  }
+
   const int proc_x = Env_proc_x_this( env );
   const int proc_y = Env_proc_y_this( env );
+  const int proc_z = Env_proc_z_this( env );
 
+  const size_t size_facexy_per_octant = Dimensions_size_facexy( dims_b,
+                 NU, faces->noctant_per_block ) / faces->noctant_per_block;
   const size_t size_facexz_per_octant = Dimensions_size_facexz( dims_b,
                  NU, faces->noctant_per_block ) / faces->noctant_per_block;
   const size_t size_faceyz_per_octant = Dimensions_size_faceyz( dims_b,
@@ -102,9 +933,25 @@ void Faces_communicate_faces(
 
   /*---Allocate temporary face buffers---*/
 
+  P* RESTRICT     buf_xy  = malloc_host_P( size_facexy_per_octant );
   P* RESTRICT     buf_xz  = malloc_host_P( size_facexz_per_octant );
   P* RESTRICT     buf_yz  = malloc_host_P( size_faceyz_per_octant );
 
+  /*---With angle sets, the slice of a face for the set is received here---*/
+
+  const size_t size_face_per_octant_max =
+    size_facexy_per_octant > size_facexz_per_octant ?
+    ( size_facexy_per_octant > size_faceyz_per_octant ?
+      size_facexy_per_octant : size_faceyz_per_octant ) :
+    ( size_facexz_per_octant > size_faceyz_per_octant ?
+      size_facexz_per_octant : size_faceyz_per_octant );
+
+  P* RESTRICT     buf_slice = faces->nangle_set > 1 ?
+                      malloc_host_P( size_face_per_octant_max ) : (P*)NULL;
+
+  const size_t nbyte_bufs = Faces_nbyte_bufs_step_( faces, dims_b );
+  MemTracker_allocate( MEMTRACKER_FACE_BUFS, nbyte_bufs, Bool_false );
+
   /*---Loop over octants---*/
 
   int octant_in_block = 0;
@@ -112,28 +959,48 @@ void Faces_communicate_faces(
   for( octant_in_block=0; octant_in_block<faces->noctant_per_block;
                                                             ++octant_in_block )
   {
-    /*---Communicate +/-X, +/-Y---*/
+    /*---Communicate +/-X, +/-Y, +/-Z---*/
 
     int axis = 0;
 
-    for( axis=0; axis<2; ++axis )  /*---Loop: X, Y---*/
+    for( axis=0; axis<NDIM; ++axis )  /*---Loop: X, Y, Z---*/
     {
       const Bool_t axis_x = axis==0;
       const Bool_t axis_y = axis==1;
+      const Bool_t axis_z = axis==2;
 
-      const int proc_axis = axis_x ? proc_x : proc_y;
+      const int proc_axis = axis_x ? proc_x : axis_y ? proc_y : proc_z;
 
       const size_t    size_face_per_octant    = axis_x ? size_faceyz_per_octant
-                                                       : size_facexz_per_octant;
+                                              : axis_y ? size_facexz_per_octant
+                                                       : size_facexy_per_octant;
       P* RESTRICT     buf                     = axis_x ? buf_yz
-                                                       : buf_xz;
-      P* RESTRICT     face_per_octant = axis_x ?
-        ref_faceyz( Pointer_h( Faces_faceyz_step( faces, step ) ),
-                    dims_b, NU, faces->noctant_per_block,
-                    0, 0, 0, 0, 0, octant_in_block ) :
-        ref_facexz( Pointer_h( Faces_facexz_step( faces, step ) ),
-                    dims_b, NU, faces->noctant_per_block,
-                     0, 0, 0, 0, 0, octant_in_block );
+                                              : axis_y ? buf_xz
+                                                       : buf_xy;
+      P* RESTRICT     face_per_octant = Faces_face_per_octant_( faces,
+                                    dims_b, axis, step, octant_in_block );
+
+      /*---Only the angles of the angle set of the step are communicated---*/
+
+      const size_t nrow = size_face_per_octant / dims_b.na;
+
+      int ia_min_send = 0;
+      int ia_max_send = 0;
+      int ia_min_recv = 0;
+      int ia_max_recv = 0;
+
+      Faces_angle_range_( faces, stepscheduler, dims_b, step, 0,
+                          octant_in_block, &ia_min_send, &ia_max_send );
+      Faces_angle_range_( faces, stepscheduler, dims_b, step+1, 0,
+                          octant_in_block, &ia_min_recv, &ia_max_recv );
+
+      const int na_send = ia_max_send - ia_min_send;
+      const int na_recv = ia_max_recv - ia_min_recv;
+
+      const Bool_t is_sliced_send = na_send < dims_b.na;
+      const Bool_t is_sliced_recv = na_recv < dims_b.na;
+
+      P* RESTRICT     face_recv = is_sliced_recv ? buf_slice : face_per_octant;
 
       int dir_ind = 0;
 
@@ -142,14 +1009,15 @@ void Faces_communicate_faces(
         const int dir = dir_ind==0 ? DIR_UP*1 : DIR_DN*1;
         const int inc_x = axis_x ? Dir_inc( dir ) : 0;
         const int inc_y = axis_y ? Dir_inc( dir ) : 0;
+        const int inc_z = axis_z ? Dir_inc( dir ) : 0;
 
         /*---Determine whether to communicate---*/
 
         Bool_t const do_send = StepScheduler_must_do_send(
-                   stepscheduler, step, axis, dir_ind, octant_in_block, env );
+                stepscheduler, step, 0, axis, dir_ind, octant_in_block, env );
 
         Bool_t const do_recv = StepScheduler_must_do_recv(
-                   stepscheduler, step, axis, dir_ind, octant_in_block, env );
+                stepscheduler, step, 0, axis, dir_ind, octant_in_block, env );
 
         /*---Communicate as needed - red/black coloring to avoid deadlock---*/
 
@@ -157,6 +1025,13 @@ void Faces_communicate_faces(
 
         Bool_t use_buf = Bool_false;
 
+        if( do_send && is_sliced_send )
+        {
+          Faces_copy_angles_( buf, na_send, face_per_octant + ia_min_send,
+                              dims_b.na, nrow, na_send );
+          use_buf = Bool_true;
+        }
+
         for( color=0; color<2; ++color )
         {
           if( color == 0 )
@@ -165,9 +1040,10 @@ void Faces_communicate_faces(
             {
               if( do_send )
               {
-                const int proc_other
-                                 = Env_proc( env, proc_x+inc_x, proc_y+inc_y );
-                Env_send_P( env, face_per_octant, size_face_per_octant,
+                const int proc_other = Env_proc( env, proc_x+inc_x,
+                                                 proc_y+inc_y, proc_z+inc_z );
+                Env_send_P( env, use_buf ? buf : face_per_octant,
+                            nrow * na_send,
                             proc_other, Env_tag( env )+octant_in_block );
               }
             }
@@ -175,13 +1051,18 @@ void Faces_communicate_faces(
             {
               if( do_recv )
               {
-                const int proc_other
-                                 = Env_proc( env, proc_x-inc_x, proc_y-inc_y );
+                const int proc_other = Env_proc( env, proc_x-inc_x,
+                                                 proc_y-inc_y, proc_z-inc_z );
                 /*---save copy else color 0 recv will destroy color 1 send---*/
-                copy_vector( buf, face_per_octant, size_face_per_octant );
-                use_buf = Bool_true;
-                Env_recv_P( env, face_per_octant, size_face_per_octant,
+                if( ! use_buf )
+                {
+                  copy_vector( buf, face_per_octant, size_face_per_octant );
+                  use_buf = Bool_true;
+                }
+                Profiler_begin( MPI_WAIT );
+                Env_recv_P( env, face_recv, nrow * na_recv,
                             proc_other, Env_tag( env )+octant_in_block );
+                Profiler_end( MPI_WAIT );
               }
             }
           }
@@ -191,33 +1072,47 @@ void Faces_communicate_faces(
             {
               if( do_recv )
               {
-                const int proc_other
-                                 = Env_proc( env, proc_x-inc_x, proc_y-inc_y );
-                Env_recv_P( env, face_per_octant, size_face_per_octant,
+                const int proc_other = Env_proc( env, proc_x-inc_x,
+                                                 proc_y-inc_y, proc_z-inc_z );
+                Profiler_begin( MPI_WAIT );
+                Env_recv_P( env, face_recv, nrow * na_recv,
                             proc_other, Env_tag( env )+octant_in_block );
+                Profiler_end( MPI_WAIT );
               }
             }
             else
             {
               if( do_send )
               {
-                const int proc_other
-                                 = Env_proc( env, proc_x+inc_x, proc_y+inc_y );
+                const int proc_other = Env_proc( env, proc_x+inc_x,
+                                                 proc_y+inc_y, proc_z+inc_z );
                 Env_send_P( env, use_buf ? buf : face_per_octant,
-                  size_face_per_octant, proc_other,
+                  nrow * na_send, proc_other,
                   Env_tag( env )+octant_in_block );
               }
             }
           } /*---if color---*/
         } /*---color---*/
+
+        if( do_recv && is_sliced_recv )
+        {
+          Faces_copy_angles_( face_per_octant + ia_min_recv, dims_b.na,
+                              buf_slice, na_recv, nrow, na_recv );
+        }
       } /*---dir_ind---*/
     } /*---axis---*/
   } /*---octant_in_block---*/
 
   /*---Deallocations---*/
 
+  free_host_P( buf_xy );
   free_host_P( buf_xz );
   free_host_P( buf_yz );
+  if( buf_slice )
+  {
+    free_host_P( buf_slice );
+  }
+  MemTracker_free( MEMTRACKER_FACE_BUFS, nbyte_bufs, Bool_false );
 }
 
 /*===========================================================================*/
@@ -234,7 +1129,10 @@ void Faces_send_faces_start(
 
   const int proc_x = Env_proc_x_this( env );
   const int proc_y = Env_proc_y_this( env );
+  const int proc_z = Env_proc_z_this( env );
 
+  const size_t size_facexy_per_octant = Dimensions_size_facexy( dims_b,
+                 NU, faces->noctant_per_block ) / faces->noctant_per_block;
   const size_t size_facexz_per_octant = Dimensions_size_facexz( dims_b,
                  NU, faces->noctant_per_block ) / faces->noctant_per_block;
   const size_t size_faceyz_per_octant = Dimensions_size_faceyz( dims_b,
@@ -247,26 +1145,35 @@ void Faces_send_faces_start(
   for( octant_in_block=0; octant_in_block<faces->noctant_per_block;
                                                             ++octant_in_block )
   {
-    /*---Communicate +/-X, +/-Y---*/
+    /*---Communicate +/-X, +/-Y, +/-Z---*/
 
     int axis = 0;
 
-    for( axis=0; axis<2; ++axis )
+    for( axis=0; axis<NDIM; ++axis )
     {
       const Bool_t axis_x = axis==0;
       const Bool_t axis_y = axis==1;
+      const Bool_t axis_z = axis==2;
 
       /*---Send values computed on this step---*/
 
       const size_t    size_face_per_octant    = axis_x ? size_faceyz_per_octant
-                                                       : size_facexz_per_octant;
-      P* RESTRICT     face_per_octant = axis_x ?
-        ref_faceyz( Pointer_h( Faces_faceyz_step( faces, step ) ),
-                    dims_b, NU, faces->noctant_per_block,
-                    0, 0, 0, 0, 0, octant_in_block ) :
-        ref_facexz( Pointer_h( Faces_facexz_step( faces, step ) ),
-                    dims_b, NU, faces->noctant_per_block,
-                    0, 0, 0, 0, 0, octant_in_block );
+                                              : axis_y ? size_facexz_per_octant
+                                                       : size_facexy_per_octant;
+      P* RESTRICT     face_per_octant = Faces_face_per_octant_( faces,
+                                    dims_b, axis, step, octant_in_block );
+
+      /*---Only the angles of the angle set of the step are communicated---*/
+
+      const size_t nrow = size_face_per_octant / dims_b.na;
+
+      int ia_min = 0;
+      int ia_max = 0;
+
+      Faces_angle_range_( faces, stepscheduler, dims_b, step, 0,
+                          octant_in_block, &ia_min, &ia_max );
+
+      const Bool_t is_sliced = ia_max - ia_min < dims_b.na;
 
       int dir_ind = 0;
 
@@ -275,19 +1182,45 @@ void Faces_send_faces_start(
         const int dir = dir_ind==0 ? DIR_UP*1 : DIR_DN*1;
         const int inc_x = axis_x ? Dir_inc( dir ) : 0;
         const int inc_y = axis_y ? Dir_inc( dir ) : 0;
+        const int inc_z = axis_z ? Dir_inc( dir ) : 0;
 
         /*---Determine whether to communicate---*/
 
         Bool_t const do_send = StepScheduler_must_do_send(
-                   stepscheduler, step, axis, dir_ind, octant_in_block, env );
+                stepscheduler, step, 0, axis, dir_ind, octant_in_block, env );
 
-        if( do_send )
+        if( do_send && Faces_is_shm_send_( faces, axis, dir_ind ) )
         {
-          const int proc_other = Env_proc( env, proc_x+inc_x, proc_y+inc_y );
+          /*---Neighbor on node: publish face, neighbor copies it out---*/
+          Env_win_sync( env, axis_x ? &faces->win_yz : &faces->win_xz );
+          ++faces->counters[ Faces_counter_index_( Bool_false,
+                                       octant_in_block, axis, dir_ind ) ];
+          Env_win_sync( env, &faces->win_counters );
+        }
+        else if( do_send )
+        {
+          const int proc_other = Env_proc( env, proc_x+inc_x,
+                                           proc_y+inc_y, proc_z+inc_z );
           Request_t* request = axis_x ?
                                    & faces->request_send_xz[octant_in_block]
-                                 : & faces->request_send_yz[octant_in_block];
-          Env_asend_P( env, face_per_octant, size_face_per_octant,
+                             : axis_y ?
+                                   & faces->request_send_yz[octant_in_block]
+                                 : & faces->request_send_xy[octant_in_block];
+
+          /*---The xy face may be reused before the send completes---*/
+
+          P* const buf = axis_z || is_sliced ?
+                         Faces_buf_send_( faces, axis ) +
+                                  octant_in_block * size_face_per_octant :
+                                  face_per_octant;
+          if( axis_z || is_sliced )
+          {
+            Faces_copy_angles_( buf, ia_max - ia_min,
+                                face_per_octant + ia_min, dims_b.na,
+                                nrow, ia_max - ia_min );
+          }
+
+          Env_asend_P( env, buf, nrow * ( ia_max - ia_min ),
                     proc_other, Env_tag( env )+octant_in_block, request );
         }
       } /*---dir_ind---*/
@@ -307,9 +1240,6 @@ void Faces_send_faces_end(
 {
   Assert( Faces_is_face_comm_async( faces ) );
 
-  const int proc_x = Env_proc_x_this( env );
-  const int proc_y = Env_proc_y_this( env );
-
   /*---Loop over octants---*/
 
   int octant_in_block = 0;
@@ -317,13 +1247,14 @@ void Faces_send_faces_end(
   for( octant_in_block=0; octant_in_block<faces->noctant_per_block;
                                                             ++octant_in_block )
   {
-    /*---Communicate +/-X, +/-Y---*/
+    /*---Communicate +/-X, +/-Y, +/-Z---*/
 
     int axis = 0;
 
-    for( axis=0; axis<2; ++axis )
+    for( axis=0; axis<NDIM; ++axis )
     {
       const Bool_t axis_x = axis==0;
+      const Bool_t axis_y = axis==1;
 
       int dir_ind = 0;
 
@@ -333,14 +1264,27 @@ void Faces_send_faces_end(
         /*---Determine whether to communicate---*/
 
         Bool_t const do_send = StepScheduler_must_do_send(
-                   stepscheduler, step, axis, dir_ind, octant_in_block, env );
+                stepscheduler, step, 0, axis, dir_ind, octant_in_block, env );
 
-        if( do_send )
+        if( do_send && Faces_is_shm_send_( faces, axis, dir_ind ) )
+        {
+          /*---Wait until neighbor has copied out the face---*/
+          Env_win_wait_counter( env, &faces->win_counters,
+            faces->counters_send[axis][dir_ind] + Faces_counter_index_(
+                            Bool_true, octant_in_block, axis, dir_ind ),
+            faces->counters[ Faces_counter_index_(
+                            Bool_false, octant_in_block, axis, dir_ind ) ] );
+        }
+        else if( do_send )
         {
           Request_t* request = axis_x ?
                                    & faces->request_send_xz[octant_in_block]
-                                 : & faces->request_send_yz[octant_in_block];
+                             : axis_y ?
+                                   & faces->request_send_yz[octant_in_block]
+                                 : & faces->request_send_xy[octant_in_block];
+          Profiler_begin( MPI_WAIT );
           Env_wait( env, request );
+          Profiler_end( MPI_WAIT );
         }
       } /*---dir_ind---*/
     } /*---axis---*/
@@ -361,7 +1305,10 @@ void Faces_recv_faces_start(
 
   const int proc_x = Env_proc_x_this( env );
   const int proc_y = Env_proc_y_this( env );
+  const int proc_z = Env_proc_z_this( env );
 
+  const size_t size_facexy_per_octant = Dimensions_size_facexy( dims_b,
+                 NU, faces->noctant_per_block ) / faces->noctant_per_block;
   const size_t size_facexz_per_octant = Dimensions_size_facexz( dims_b,
                  NU, faces->noctant_per_block ) / faces->noctant_per_block;
   const size_t size_faceyz_per_octant = Dimensions_size_faceyz( dims_b,
@@ -374,26 +1321,38 @@ void Faces_recv_faces_start(
   for( octant_in_block=0; octant_in_block<faces->noctant_per_block;
                                                             ++octant_in_block )
   {
-    /*---Communicate +/-X, +/-Y---*/
+    /*---Communicate +/-X, +/-Y, +/-Z---*/
 
     int axis = 0;
 
-    for( axis=0; axis<2; ++axis )
+    for( axis=0; axis<NDIM; ++axis )
     {
       const Bool_t axis_x = axis==0;
       const Bool_t axis_y = axis==1;
+      const Bool_t axis_z = axis==2;
 
       /*---Receive values computed on the next step---*/
+      /*---The xy face, or a face sliced to an angle set, is received
+           into a staging buffer---*/
 
       const size_t    size_face_per_octant    = axis_x ? size_faceyz_per_octant
-                                                       : size_facexz_per_octant;
-      P* RESTRICT     face_per_octant = axis_x ?
-        ref_faceyz( Pointer_h( Faces_faceyz_step( faces, step+1 ) ),
-                    dims_b, NU, faces->noctant_per_block,
-                    0, 0, 0, 0, 0, octant_in_block ) :
-        ref_facexz( Pointer_h( Faces_facexz_step( faces, step+1 ) ),
-                    dims_b, NU, faces->noctant_per_block,
-                    0, 0, 0, 0, 0, octant_in_block );
+                                              : axis_y ? size_facexz_per_octant
+                                                       : size_facexy_per_octant;
+
+      const size_t nrow = size_face_per_octant / dims_b.na;
+
+      int ia_min = 0;
+      int ia_max = 0;
+
+      Faces_angle_range_( faces, stepscheduler, dims_b, step+1, 0,
+                          octant_in_block, &ia_min, &ia_max );
+
+      const Bool_t is_sliced = ia_max - ia_min < dims_b.na;
+
+      P* RESTRICT     face_per_octant = axis_z || is_sliced ?
+        Faces_buf_recv_( faces, axis ) +
+                                  octant_in_block * size_face_per_octant :
+        Faces_face_per_octant_( faces, dims_b, axis, step+1, octant_in_block );
 
       int dir_ind = 0;
 
@@ -402,19 +1361,25 @@ void Faces_recv_faces_start(
         const int dir = dir_ind==0 ? DIR_UP*1 : DIR_DN*1;
         const int inc_x = axis_x ? Dir_inc( dir ) : 0;
         const int inc_y = axis_y ? Dir_inc( dir ) : 0;
+        const int inc_z = axis_z ? Dir_inc( dir ) : 0;
 
         /*---Determine whether to communicate---*/
 
         Bool_t const do_recv = StepScheduler_must_do_recv(
-                   stepscheduler, step, axis, dir_ind, octant_in_block, env );
+                stepscheduler, step, 0, axis, dir_ind, octant_in_block, env );
+
+        /*---Neighbor on node: nothing to post, face is copied at end---*/
 
-        if( do_recv )
+        if( do_recv && ! Faces_is_shm_recv_( faces, axis, dir_ind ) )
         {
-          const int proc_other = Env_proc( env, proc_x-inc_x, proc_y-inc_y );
+          const int proc_other = Env_proc( env, proc_x-inc_x,
+                                           proc_y-inc_y, proc_z-inc_z );
           Request_t* request = axis_x ?
                                    & faces->request_recv_xz[octant_in_block]
-                                 : & faces->request_recv_yz[octant_in_block];
-          Env_arecv_P( env, face_per_octant, size_face_per_octant,
+                             : axis_y ?
+                                   & faces->request_recv_yz[octant_in_block]
+                                 : & faces->request_recv_xy[octant_in_block];
+          Env_arecv_P( env, face_per_octant, nrow * ( ia_max - ia_min ),
                     proc_other, Env_tag( env )+octant_in_block, request );
         }
       } /*---dir_ind---*/
@@ -434,9 +1399,8 @@ void Faces_recv_faces_end(
 {
   Assert( Faces_is_face_comm_async( faces ) );
 
-  const int proc_x = Env_proc_x_this( env );
-  const int proc_y = Env_proc_y_this( env );
-
+  const size_t size_facexy_per_octant = Dimensions_size_facexy( dims_b,
+                 NU, faces->noctant_per_block ) / faces->noctant_per_block;
   const size_t size_facexz_per_octant = Dimensions_size_facexz( dims_b,
                  NU, faces->noctant_per_block ) / faces->noctant_per_block;
   const size_t size_faceyz_per_octant = Dimensions_size_faceyz( dims_b,
@@ -449,13 +1413,31 @@ void Faces_recv_faces_end(
   for( octant_in_block=0; octant_in_block<faces->noctant_per_block;
                                                             ++octant_in_block )
   {
-    /*---Communicate +/-X, +/-Y---*/
+    /*---Communicate +/-X, +/-Y, +/-Z---*/
 
     int axis = 0;
 
-    for( axis=0; axis<2; ++axis )
+    for( axis=0; axis<NDIM; ++axis )
     {
       const Bool_t axis_x = axis==0;
+      const Bool_t axis_y = axis==1;
+      const Bool_t axis_z = axis==2;
+
+      const size_t    size_face_per_octant    = axis_x ? size_faceyz_per_octant
+                                              : axis_y ? size_facexz_per_octant
+                                                       : size_facexy_per_octant;
+      P* RESTRICT     face_per_octant = Faces_face_per_octant_( faces,
+                                    dims_b, axis, step+1, octant_in_block );
+
+      const size_t nrow = size_face_per_octant / dims_b.na;
+
+      int ia_min = 0;
+      int ia_max = 0;
+
+      Faces_angle_range_( faces, stepscheduler, dims_b, step+1, 0,
+                          octant_in_block, &ia_min, &ia_max );
+
+      const Bool_t is_sliced = ia_max - ia_min < dims_b.na;
 
       int dir_ind = 0;
 
@@ -464,14 +1446,59 @@ void Faces_recv_faces_end(
         /*---Determine whether to communicate---*/
 
         Bool_t const do_recv = StepScheduler_must_do_recv(
-                   stepscheduler, step, axis, dir_ind, octant_in_block, env );
+                stepscheduler, step, 0, axis, dir_ind, octant_in_block, env );
+
+        if( do_recv && Faces_is_shm_recv_( faces, axis, dir_ind ) )
+        {
+          /*---Neighbor on node: wait for face, copy from its window---*/
 
-        if( do_recv )
+          long* const count_consumed = & faces->counters[
+            Faces_counter_index_( Bool_true, octant_in_block, axis, dir_ind ) ];
+
+          Env_win_wait_counter( env, &faces->win_counters,
+            faces->counters_recv[axis][dir_ind] + Faces_counter_index_(
+                            Bool_false, octant_in_block, axis, dir_ind ),
+            *count_consumed + 1 );
+
+          /*---Neighbor's buffers are laid out as ours, same step index---*/
+
+          P* const face_other = faces->faces_recv[axis][dir_ind] +
+                  ( (step+3)%3 ) * size_face_per_octant *
+                  faces->noctant_per_block;
+
+          const P* const face_other_per_octant = axis_x ?
+            ref_faceyz( face_other, dims_b, NU, faces->noctant_per_block,
+                        0, 0, 0, 0, 0, octant_in_block ) :
+            ref_facexz( face_other, dims_b, NU, faces->noctant_per_block,
+                        0, 0, 0, 0, 0, octant_in_block );
+
+          Faces_copy_angles_( face_per_octant + ia_min, dims_b.na,
+                              face_other_per_octant + ia_min, dims_b.na,
+                              nrow, ia_max - ia_min );
+
+          ++*count_consumed;
+          Env_win_sync( env, &faces->win_counters );
+        }
+        else if( do_recv )
         {
           Request_t* request = axis_x ?
                                    & faces->request_recv_xz[octant_in_block]
-                                 : & faces->request_recv_yz[octant_in_block];
+                             : axis_y ?
+                                   & faces->request_recv_yz[octant_in_block]
+                                 : & faces->request_recv_xy[octant_in_block];
+          Profiler_begin( MPI_WAIT );
           Env_wait( env, request );
+          Profiler_end( MPI_WAIT );
+
+          /*---Move the face from the staging buffer into place---*/
+
+          if( axis_z || is_sliced )
+          {
+            Faces_copy_angles_( face_per_octant + ia_min, dims_b.na,
+                                Faces_buf_recv_( faces, axis ) +
+                                  octant_in_block * size_face_per_octant,
+                                ia_max - ia_min, nrow, ia_max - ia_min );
+          }
         }
       } /*---dir_ind---*/
     } /*---axis---*/
@@ -42,10 +42,54 @@ typedef struct
   Request_t        request_send_yz[NOCTANT];
   Request_t        request_recv_xz[NOCTANT];
   Request_t        request_recv_yz[NOCTANT];
+  Request_t        request_send_xy[NOCTANT];
+  Request_t        request_recv_xy[NOCTANT];
+
+  P*               buf_xy_send;
+  P*               buf_xy_recv;
+
+  /*---Staging buffers for xz, yz faces sliced to one angle set---*/
+
+  P*               buf_xz_send;
+  P*               buf_xz_recv;
+  P*               buf_yz_send;
+  P*               buf_yz_recv;
+
+  /*---Staging buffers for faces of virtual blocks, and the place of the
+       part of each block in them---*/
+
+  P*               buf_vblock_send;
+  P*               buf_vblock_recv;
+  size_t*          offset_vblock;
+
+  size_t           nbyte_bufs;     /*---Of all staging buffers---*/
 
   int              noctant_per_block;
+  int              nangle_set;
+
+  /*---Virtual blocks of this proc and their cell bounds; the xz face is
+       held once per block along y, the yz face once per block along x---*/
+
+  int              nblock_x;
+  int              nblock_y;
+  const int*       ix_base_block;
+  const int*       iy_base_block;
 
   Bool_t           is_face_comm_async;
+
+  /*---On-node neighbors exchange faces through shared memory windows---*/
+
+  Bool_t           is_face_comm_shm;
+
+  Win_t            win_xz;
+  Win_t            win_yz;
+  Win_t            win_counters;
+  size_t           nbyte_shm;      /*---Of the face windows---*/
+
+  long*            counters;
+  volatile long*   counters_send[2][2];
+  volatile long*   counters_recv[2][2];
+  P*               faces_recv[2][2];
 } Faces;
 
 /*===========================================================================*/
@@ -54,13 +98,36 @@ typedef struct
 void Faces_create( Faces*      faces,
                    Dimensions  dims_b,
                    int         noctant_per_block,
+                   int         nangle_set,
+                   int         nblock_x,
+                   int         nblock_y,
+                   const int*  ix_base_block,
+                   const int*  iy_base_block,
                    Bool_t      is_face_comm_async,
+                   Bool_t      is_face_comm_shm,
                    Env*        env );
 
 /*===========================================================================*/
 /*---Pseudo-destructor for Faces struct---*/
 
-void Faces_destroy( Faces* faces );
+void Faces_destroy( Faces* faces,
+                    Env*   env );
+
+/*===========================================================================*/
+/*---Bytes the faces would allocate, added by memory tracker category, and
+     of the buffers made at each step, without creating them---*/
+
+void Faces_predict_memory( size_t*     nbyte,
+                           size_t*     nbyte_device,
+                           size_t*     nbyte_step,
+                           Dimensions  dims_b,
+                           int         noctant_per_block,
+                           int         nangle_set,
+                           int         nblock_x,
+                           int         nblock_y,
+                           Bool_t      is_face_comm_async,
+                           Bool_t      is_face_comm_shm,
+                           Env*        env );
 
 /*===========================================================================*/
 /*---Is face communication done asynchronously---*/
@@ -70,6 +137,14 @@ static int Faces_is_face_comm_async( Faces* faces )
   return faces->is_face_comm_async;
 }
 
+/*===========================================================================*/
+/*---Is face communication with on-node neighbors done via shared memory---*/
+
+static inline int Faces_is_face_comm_shm( Faces* faces )
+{
+  return faces->is_face_comm_shm;
+}
+
 /*===========================================================================*/
 /*---Selectors for faces---*/
 
@@ -191,6 +266,23 @@ void Faces_recv_faces_end(
   int             step,
   Env*            env );
 
+/*===========================================================================*/
+/*---Copy an angle range of a region of a face to or from a buffer---*/
+/*---pseudo-private member function---*/
+
+void Faces_copy_region_( P* const RESTRICT  face,
+                         P* const RESTRICT  buf,
+                         Dimensions         dims_b,
+                         int                nc0_face,
+                         int                c0_min,
+                         int                nc0,
+                         int                nc1_face,
+                         int                c1_min,
+                         int                nc1,
+                         int                ia_min,
+                         int                na_copy,
+                         Bool_t             is_to_buf );
+
 /*===========================================================================*/
 
 #ifdef __cplusplus_IGNORE
@@ -14,6 +14,7 @@
 #include "env.h"
 #include "dimensions.h"
 #include "array_accessors.h"
+#include "memtracker.h"
 #include "pointer.h"
 #include "quantities_testing.h"
 
@@ -54,6 +55,8 @@ void Quantities_init_am_matrices_( Quantities*       quan,
                                              Env_hip_is_using_device( env ) );
   Pointer_create( & quan->m_from_a, dims.nm * dims.na * NOCTANT,
                                              Env_hip_is_using_device( env ) );
+  Pointer_set_category( & quan->a_from_m, MEMTRACKER_ANGLE );
+  Pointer_set_category( & quan->m_from_a, MEMTRACKER_ANGLE );
 
   Pointer_allocate( & quan->a_from_m );
   Pointer_allocate( & quan->m_from_a );
@@ -211,14 +214,12 @@ void Quantities_init_decomp_( Quantities*       quan,
 
   int i  = 0;
 
-  /*---Record z dimension---*/
-
-  quan->ncell_z_g = dims.ncell_z;
-
   /*---Allocate arrays---*/
 
   quan->ix_base_vals = malloc_host_int( Env_nproc_x( env ) + 1 );
   quan->iy_base_vals = malloc_host_int( Env_nproc_y( env ) + 1 );
+  quan->iz_base_vals = malloc_host_int( Env_nproc_z( env ) + 1 );
+  quan->ie_base_vals = malloc_host_int( Env_nproc_e( env ) + 1 );
 
   /*---------------------------------*/
   /*---Set entries of ix_base_vals---*/
@@ -233,13 +234,15 @@ void Quantities_init_decomp_( Quantities*       quan,
     for( proc_x=1; proc_x<Env_nproc_x( env ); ++proc_x )
     {
       Env_recv_i( env, & quan->ix_base_vals[ 1+proc_x ], 1,
-        Env_proc( env, proc_x, Env_proc_y_this( env ) ), Env_tag( env ) );
+        Env_proc( env, proc_x, Env_proc_y_this( env ),
+                                Env_proc_z_this( env ) ), Env_tag( env ) );
     }
   }
   else
   {
     Env_send_i( env, & dims.ncell_x, 1,
-             Env_proc( env, 0, Env_proc_y_this( env ) ), Env_tag( env ) );
+             Env_proc( env, 0, Env_proc_y_this( env ),
+                              Env_proc_z_this( env ) ), Env_tag( env ) );
   }
   Env_increment_tag( env, 1 );
 
@@ -251,13 +254,15 @@ void Quantities_init_decomp_( Quantities*       quan,
     for( proc_x=1; proc_x<Env_nproc_x( env ); ++proc_x )
     {
       Env_send_i( env, & quan->ix_base_vals[ 1 ], Env_nproc_x( env ),
-        Env_proc( env, proc_x, Env_proc_y_this( env ) ), Env_tag( env ) );
+        Env_proc( env, proc_x, Env_proc_y_this( env ),
+                                Env_proc_z_this( env ) ), Env_tag( env ) );
     }
   }
   else
   {
     Env_recv_i( env, & quan->ix_base_vals[ 1 ], Env_nproc_x( env ),
-             Env_proc( env, 0, Env_proc_y_this( env ) ), Env_tag( env ) );
+             Env_proc( env, 0, Env_proc_y_this( env ),
+                              Env_proc_z_this( env ) ), Env_tag( env ) );
   }
   Env_increment_tag( env, 1 );
 
@@ -288,13 +293,15 @@ void Quantities_init_decomp_( Quantities*       quan,
     for( proc_y=1; proc_y<Env_nproc_y( env ); ++proc_y )
     {
       Env_recv_i( env, & quan->iy_base_vals[ 1+proc_y ], 1,
-        Env_proc( env, Env_proc_x_this( env ), proc_y ), Env_tag( env ) );
+        Env_proc( env, Env_proc_x_this( env ), proc_y,
+                                Env_proc_z_this( env ) ), Env_tag( env ) );
     }
   }
   else
   {
     Env_send_i( env, & dims.ncell_y, 1,
-             Env_proc( env, Env_proc_x_this( env ), 0 ), Env_tag( env ) );
+             Env_proc( env, Env_proc_x_this( env ), 0,
+                              Env_proc_z_this( env ) ), Env_tag( env ) );
   }
   Env_increment_tag( env, 1 );
 
@@ -306,13 +313,15 @@ void Quantities_init_decomp_( Quantities*       quan,
     for( proc_y=1; proc_y<Env_nproc_y( env ); ++proc_y )
     {
       Env_send_i( env, & quan->iy_base_vals[ 1 ], Env_nproc_y( env ),
-        Env_proc( env, Env_proc_x_this( env ), proc_y ), Env_tag( env ) );
+        Env_proc( env, Env_proc_x_this( env ), proc_y,
+                                Env_proc_z_this( env ) ), Env_tag( env ) );
     }
   }
   else
   {
     Env_recv_i( env, & quan->iy_base_vals[ 1 ], Env_nproc_y( env ),
-             Env_proc( env, Env_proc_x_this( env ), 0 ), Env_tag( env ) );
+             Env_proc( env, Env_proc_x_this( env ), 0,
+                              Env_proc_z_this( env ) ), Env_tag( env ) );
   }
   Env_increment_tag( env, 1 );
 
@@ -330,6 +339,124 @@ void Quantities_init_decomp_( Quantities*       quan,
   Assert( quan->iy_base_vals[ Env_proc_y_this( env )+1 ] -
           quan->iy_base_vals[ Env_proc_y_this( env )   ] == dims.ncell_y );
 
+  /*---------------------------------*/
+  /*---Set entries of iz_base_vals---*/
+  /*---------------------------------*/
+
+  /*---Collect values to base proc along axis---*/
+
+  if( Env_proc_z_this( env ) == 0 )
+  {
+    int proc_z = 0;
+    quan->iz_base_vals[ 1+0 ] = dims.ncell_z;
+    for( proc_z=1; proc_z<Env_nproc_z( env ); ++proc_z )
+    {
+      Env_recv_i( env, & quan->iz_base_vals[ 1+proc_z ], 1,
+        Env_proc( env, Env_proc_x_this( env ), Env_proc_y_this( env ),
+                                        proc_z ), Env_tag( env ) );
+    }
+  }
+  else
+  {
+    Env_send_i( env, & dims.ncell_z, 1,
+             Env_proc( env, Env_proc_x_this( env ), Env_proc_y_this( env ),
+                                        0 ), Env_tag( env ) );
+  }
+  Env_increment_tag( env, 1 );
+
+  /*---Broadcast collected array to all other procs along axis---*/
+
+  if( Env_proc_z_this( env ) == 0 )
+  {
+    int proc_z = 0;
+    for( proc_z=1; proc_z<Env_nproc_z( env ); ++proc_z )
+    {
+      Env_send_i( env, & quan->iz_base_vals[ 1 ], Env_nproc_z( env ),
+        Env_proc( env, Env_proc_x_this( env ), Env_proc_y_this( env ),
+                                        proc_z ), Env_tag( env ) );
+    }
+  }
+  else
+  {
+    Env_recv_i( env, & quan->iz_base_vals[ 1 ], Env_nproc_z( env ),
+             Env_proc( env, Env_proc_x_this( env ), Env_proc_y_this( env ),
+                                        0 ), Env_tag( env ) );
+  }
+  Env_increment_tag( env, 1 );
+
+  /*---Scan sum---*/
+
+  quan->iz_base_vals[0] = 0;
+  for( i=0; i<Env_nproc_z( env ); ++i )
+  {
+    quan->iz_base_vals[1+i] += quan->iz_base_vals[i];
+  }
+
+  quan->iz_base   = quan->iz_base_vals[ Env_proc_z_this( env ) ];
+  quan->ncell_z_g = quan->iz_base_vals[ Env_nproc_z(     env ) ];
+
+  Assert( quan->iz_base_vals[ Env_proc_z_this( env )+1 ] -
+          quan->iz_base_vals[ Env_proc_z_this( env )   ] == dims.ncell_z );
+
+  /*---------------------------------*/
+  /*---Set entries of ie_base_vals---*/
+  /*---------------------------------*/
+
+  /*---Collect values to base proc along axis---*/
+
+  if( Env_proc_e_this( env ) == 0 )
+  {
+    int proc_e = 0;
+    quan->ie_base_vals[ 1+0 ] = dims.ne;
+    for( proc_e=1; proc_e<Env_nproc_e( env ); ++proc_e )
+    {
+      Env_recv_i( env, & quan->ie_base_vals[ 1+proc_e ], 1,
+        Env_proc_xyze( env, Env_proc_x_this( env ), Env_proc_y_this( env ),
+                       Env_proc_z_this( env ), proc_e ), Env_tag( env ) );
+    }
+  }
+  else
+  {
+    Env_send_i( env, & dims.ne, 1,
+             Env_proc_xyze( env, Env_proc_x_this( env ), Env_proc_y_this( env ),
+                            Env_proc_z_this( env ), 0 ), Env_tag( env ) );
+  }
+  Env_increment_tag( env, 1 );
+
+  /*---Broadcast collected array to all other procs along axis---*/
+
+  if( Env_proc_e_this( env ) == 0 )
+  {
+    int proc_e = 0;
+    for( proc_e=1; proc_e<Env_nproc_e( env ); ++proc_e )
+    {
+      Env_send_i( env, & quan->ie_base_vals[ 1 ], Env_nproc_e( env ),
+        Env_proc_xyze( env, Env_proc_x_this( env ), Env_proc_y_this( env ),
+                       Env_proc_z_this( env ), proc_e ), Env_tag( env ) );
+    }
+  }
+  else
+  {
+    Env_recv_i( env, & quan->ie_base_vals[ 1 ], Env_nproc_e( env ),
+             Env_proc_xyze( env, Env_proc_x_this( env ), Env_proc_y_this( env ),
+                            Env_proc_z_this( env ), 0 ), Env_tag( env ) );
+  }
+  Env_increment_tag( env, 1 );
+
+  /*---Scan sum---*/
+
+  quan->ie_base_vals[0] = 0;
+  for( i=0; i<Env_nproc_e( env ); ++i )
+  {
+    quan->ie_base_vals[1+i] += quan->ie_base_vals[i];
+  }
+
+  quan->ie_base = quan->ie_base_vals[ Env_proc_e_this( env ) ];
+  quan->ne_g    = quan->ie_base_vals[ Env_nproc_e(     env ) ];
+
+  Assert( quan->ie_base_vals[ Env_proc_e_this( env )+1 ] -
+          quan->ie_base_vals[ Env_proc_e_this( env )   ] == dims.ne );
+
 } /*---Quantities_init_decomp_---*/
 
 /*===========================================================================*/
@@ -344,9 +471,13 @@ void Quantities_destroy( Quantities* quan )
 
   free_host_int( quan->ix_base_vals );
   free_host_int( quan->iy_base_vals );
+  free_host_int( quan->iz_base_vals );
+  free_host_int( quan->ie_base_vals );
 
   quan->ix_base_vals = NULL;
   quan->iy_base_vals = NULL;
+  quan->iz_base_vals = NULL;
+  quan->ie_base_vals = NULL;
 
 } /*---Quantities_destroy---*/
 
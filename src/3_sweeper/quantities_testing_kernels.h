@@ -38,11 +38,16 @@ typedef struct
   Pointer  m_from_a;
   int*     ix_base_vals;
   int*     iy_base_vals;
+  int*     iz_base_vals;
+  int*     ie_base_vals;
   int      ix_base;
   int      iy_base;
+  int      iz_base;
+  int      ie_base;
   int      ncell_x_g;
   int      ncell_y_g;
   int      ncell_z_g;
+  int      ne_g;
 } Quantities;
 
 /*===========================================================================*/
@@ -8,9 +8,13 @@
  */
 /*---------------------------------------------------------------------------*/
 
+#include <stdio.h>
+#include <stdlib.h>
+
 #include "env.h"
 #include "definitions.h"
 #include "stepscheduler_kba.h"
+#include "sweeper_kba_kernels.h"
 
 #ifdef __cplusplus_IGNORE
 extern "C"
@@ -27,20 +31,283 @@ StepScheduler StepScheduler_null()
   return result;
 }
 
+/*===========================================================================*/
+/*---Compile the schedule of this proc into tables---*/
+
+static void StepScheduler_compile_( StepScheduler* stepscheduler,
+                                    Env*           env );
+
+/*===========================================================================*/
+/*---Steps from the start of one octant block to the start of the next---*/
+/*---pseudo-private member function---*/
+
+static int StepScheduler_step_base_inc_(
+  const StepScheduler* stepscheduler,
+  int                  folded_octant,
+  int                  folded_octant_next )
+{
+  /*---The next octant block may start on a proc once the previous one is
+       done there.  Along an axis whose direction reverses, the proc that
+       finishes last starts first, so the extent of the procs along that
+       axis is added.  Along z this is the part of the pipeline owned by
+       the other procs along z---*/
+
+  const int nblock_zother = ( stepscheduler->nproc_z_ - 1 ) *
+                              stepscheduler->nblock_z_;
+
+  return StepScheduler_nblock( stepscheduler ) - nblock_zother
+    + ( Dir_x( folded_octant ) != Dir_x( folded_octant_next ) ?
+                                           stepscheduler->nproc_x_ - 1 : 0 )
+    + ( Dir_y( folded_octant ) != Dir_y( folded_octant_next ) ?
+                                           stepscheduler->nproc_y_ - 1 : 0 )
+    + ( Dir_z( folded_octant ) != Dir_z( folded_octant_next ) ?
+                                           nblock_zother               : 0 );
+}
+
+/*===========================================================================*/
+/*---Steps to sweep a sequence of octant blocks---*/
+/*---pseudo-private member function---*/
+
+static int StepScheduler_nstep_order_( const StepScheduler* stepscheduler,
+                                       const int*           octant_order,
+                                       int                  noctant_key )
+{
+  /*---Starts of the octant blocks, plus the last one's sweep from the
+       first proc to the last---*/
+
+  int result = StepScheduler_nblock( stepscheduler )
+             + ( stepscheduler->nproc_x_ - 1 )
+             + ( stepscheduler->nproc_y_ - 1 );
+  int octant_key = 0;
+
+  for( octant_key=1; octant_key<noctant_key; ++octant_key )
+  {
+    result += StepScheduler_step_base_inc_( stepscheduler,
+                octant_order[octant_key-1], octant_order[octant_key] );
+  }
+
+  return result;
+}
+
+/*===========================================================================*/
+/*---Search orderings of the octant blocks for the fewest steps---*/
+/*---pseudo-private member function---*/
+
+static void StepScheduler_search_order_(
+  const StepScheduler* stepscheduler,
+  int*                 octant_order,
+  int                  nset,
+  int                  nstep_set,
+  int*                 octant_order_best,
+  int*                 nstep_best )
+{
+  /*---Entries before nset are placed; nstep_set is the step at which the
+       last placed one starts---*/
+
+  const int nblock_octant = stepscheduler->nblock_octant_;
+  const int nstep_last = StepScheduler_nblock( stepscheduler )
+                       + ( stepscheduler->nproc_x_ - 1 )
+                       + ( stepscheduler->nproc_y_ - 1 );
+
+  int i = 0;
+
+  if( nset == nblock_octant )
+  {
+    /*---Keep the earlier (e.g. built-in) order unless strictly better---*/
+    if( nstep_set + nstep_last < *nstep_best )
+    {
+      *nstep_best = nstep_set + nstep_last;
+      for( i=0; i<nblock_octant; ++i )
+      {
+        octant_order_best[i] = octant_order[i];
+      }
+    }
+    return;
+  }
+
+  for( i=nset; i<nblock_octant; ++i )
+  {
+    int tmp = octant_order[nset];
+    octant_order[nset] = octant_order[i];
+    octant_order[i] = tmp;
+
+    const int nstep_set_next = nset == 0 ? 0 : nstep_set +
+      StepScheduler_step_base_inc_( stepscheduler, octant_order[nset-1],
+                                                   octant_order[nset] );
+
+    if( nstep_set_next + nstep_last < *nstep_best )
+    {
+      StepScheduler_search_order_( stepscheduler, octant_order, nset+1,
+                      nstep_set_next, octant_order_best, nstep_best );
+    }
+
+    tmp = octant_order[nset];
+    octant_order[nset] = octant_order[i];
+    octant_order[i] = tmp;
+  }
+}
+
+/*===========================================================================*/
+/*---Step at which an octant block starts at the corner proc---*/
+/*---pseudo-private member function---*/
+
+static int StepScheduler_step_base_key_( const StepScheduler* stepscheduler,
+                                         int                  octant_key )
+{
+  /*---Octant keys run over the octant blocks of all pipelined iterations;
+       every iteration repeats the order of the first---*/
+
+  const int nblock_octant = stepscheduler->nblock_octant_;
+
+  return ( octant_key / nblock_octant ) * stepscheduler->step_period_
+         + stepscheduler->step_base_[ octant_key % nblock_octant ];
+}
+
+/*===========================================================================*/
+/*---Set up everything but the compiled tables of the schedule---*/
+/*---pseudo-private member function---*/
+
+static void StepScheduler_plan_( StepScheduler* stepscheduler,
+                                 int            nblock_z,
+                                 int            nangle_set,
+                                 int            nblock_x,
+                                 int            nblock_y,
+                                 int            nproc_x,
+                                 int            nproc_y,
+                                 int            nproc_z,
+                                 int            nblock_octant,
+                                 int            nproc_octant,
+                                 int            proc_octant,
+                                 int            nsemiblock,
+                                 int            niteration,
+                                 Bool_t         is_octant_order_optimized )
+{
+  Insist( nblock_z > 0 ? "Invalid z blocking factor supplied." : 0 );
+  Insist( nangle_set > 0 ? "Invalid angle set count supplied." : 0 );
+  Insist( nblock_x > 0 && nblock_y > 0 ?
+          "Invalid x or y blocking factor supplied." : 0 );
+  stepscheduler->nblock_z_          = nblock_z;
+  stepscheduler->nangle_set_        = nangle_set;
+  stepscheduler->nblock_x_          = nblock_x;
+  stepscheduler->nblock_y_          = nblock_y;
+
+  /*---The virtual blocks of the procs are scheduled as if they were
+       procs themselves---*/
+  stepscheduler->nproc_x_           = nproc_x * nblock_x;
+  stepscheduler->nproc_y_           = nproc_y * nblock_y;
+  stepscheduler->nproc_z_           = nproc_z;
+  stepscheduler->nblock_octant_     = nblock_octant;
+  stepscheduler->noctant_per_block_ = NOCTANT / nblock_octant;
+
+  /*---Octant groups of procs each sweep a contiguous part of the
+       sequence of octant blocks---*/
+  Insist( nblock_octant % nproc_octant == 0 ?
+          "Octant thread count times nproc_octant must not exceed 8." : 0 );
+  stepscheduler->noctant_key_    = nblock_octant / nproc_octant;
+  stepscheduler->octant_key_min_ = stepscheduler->noctant_key_ * proc_octant;
+
+  stepscheduler->nsemiblock_ = nsemiblock;
+
+  /*---Iterations pipelined one after another in the schedule; the
+       octant groups must sum their results between iterations---*/
+  Insist( niteration > 0 ? "Invalid iteration count supplied." : 0 );
+  Insist( niteration == 1 || nproc_octant == 1 ?
+          "Pipelined iterations currently require nproc_octant 1." : 0 );
+  stepscheduler->niteration_ = niteration;
+
+  /*---Order of the octant blocks.  The built-in order is
+       xyz = +++, ++-, -++, -+-, --+, ---, +-+, +--, or the first
+       nblock_octant of these when octants are folded into blocks.
+       It reverses x once and y twice, so packs the wavefronts tightly
+       when z is not decomposed and nproc_y <= nproc_x.  Otherwise a search
+       for the actual decomposition may do better, e.g. for 2 x 4 procs
+       the order 0 4 1 5 3 7 2 6 saves 2 steps---*/
+
+  const int octant_selector[NOCTANT] = { 0, 4, 2, 6, 3, 7, 1, 5 };
+
+  int octant_order[NOCTANT];
+  int octant_key = 0;
+
+  for( octant_key=0; octant_key<nblock_octant; ++octant_key )
+  {
+    octant_order[octant_key]                 = octant_selector[octant_key];
+    stepscheduler->octant_order_[octant_key] = octant_selector[octant_key];
+  }
+
+  stepscheduler->nstep_all_builtin_ = StepScheduler_nstep_order_(
+                      stepscheduler, octant_order, nblock_octant );
+  stepscheduler->nstep_all_ = stepscheduler->nstep_all_builtin_;
+
+  if( is_octant_order_optimized )
+  {
+    StepScheduler_search_order_( stepscheduler, octant_order, 0, 0,
+              stepscheduler->octant_order_, &(stepscheduler->nstep_all_) );
+  }
+
+  stepscheduler->step_base_[0] = 0;
+  for( octant_key=1; octant_key<nblock_octant; ++octant_key )
+  {
+    stepscheduler->step_base_[octant_key] =
+      stepscheduler->step_base_[octant_key-1] + StepScheduler_step_base_inc_(
+        stepscheduler, stepscheduler->octant_order_[octant_key-1],
+                       stepscheduler->octant_order_[octant_key] );
+  }
+
+  /*---The next iteration starts with the first octant block as soon as
+       the last one of this iteration allows---*/
+
+  stepscheduler->step_period_ = stepscheduler->step_base_[nblock_octant-1]
+    + StepScheduler_step_base_inc_( stepscheduler,
+                           stepscheduler->octant_order_[nblock_octant-1],
+                           stepscheduler->octant_order_[0] );
+}
+
 /*===========================================================================*/
 /*---Pseudo-constructor for StepScheduler struct---*/
 
 void StepScheduler_create( StepScheduler* stepscheduler,
                            int             nblock_z,
+                           int             nangle_set,
+                           int             nblock_x,
+                           int             nblock_y,
                            int             nblock_octant,
+                           int             nsemiblock,
+                           int             niteration,
+                           Bool_t          is_octant_order_optimized,
                            Env*            env )
 {
-  Insist( nblock_z > 0 ? "Invalid z blocking factor supplied." : 0 );
-  stepscheduler->nblock_z_          = nblock_z;
-  stepscheduler->nproc_x_           = Env_nproc_x( env );
-  stepscheduler->nproc_y_           = Env_nproc_y( env );
-  stepscheduler->nblock_octant_     = nblock_octant;
-  stepscheduler->noctant_per_block_ = NOCTANT / nblock_octant;
+  StepScheduler_plan_( stepscheduler, nblock_z, nangle_set, nblock_x,
+                       nblock_y, Env_nproc_x( env ), Env_nproc_y( env ),
+                       Env_nproc_z( env ), nblock_octant,
+                       Env_nproc_octant( env ), Env_proc_octant_this( env ),
+                       nsemiblock, niteration, is_octant_order_optimized );
+
+  StepScheduler_compile_( stepscheduler, env );
+}
+
+/*===========================================================================*/
+/*---Pseudo-constructor for a schedule that is only measured, for a
+     decomposition other than that of the environment---*/
+
+void StepScheduler_create_model( StepScheduler* stepscheduler,
+                                 int            nblock_z,
+                                 int            nangle_set,
+                                 int            nproc_x,
+                                 int            nproc_y,
+                                 int            nproc_z,
+                                 int            nblock_octant,
+                                 int            nproc_octant,
+                                 int            proc_octant,
+                                 int            niteration,
+                                 Bool_t         is_octant_order_optimized )
+{
+  StepScheduler_plan_( stepscheduler, nblock_z, nangle_set, 1, 1,
+                       nproc_x, nproc_y, nproc_z, nblock_octant,
+                       nproc_octant, proc_octant, 1, niteration,
+                       is_octant_order_optimized );
+
+  /*---No tables are compiled, so no step can be queried---*/
+  stepscheduler->nstep_ = StepScheduler_nstep( stepscheduler );
 }
 
 /*===========================================================================*/
@@ -48,6 +315,20 @@ void StepScheduler_create( StepScheduler* stepscheduler,
 
 void StepScheduler_destroy( StepScheduler* stepscheduler )
 {
+  free( (void*) stepscheduler->stepinfo_ );
+  free( (void*) stepscheduler->send_mask_ );
+  free( (void*) stepscheduler->recv_mask_ );
+  free( (void*) stepscheduler->do_block_init_ );
+  if( stepscheduler->step_block_final_ )
+  {
+    free_host_int( stepscheduler->step_block_final_ );
+  }
+
+  stepscheduler->stepinfo_         = NULL;
+  stepscheduler->send_mask_        = NULL;
+  stepscheduler->recv_mask_        = NULL;
+  stepscheduler->do_block_init_    = NULL;
+  stepscheduler->step_block_final_ = NULL;
 }
 
 /*===========================================================================*/
@@ -58,12 +339,39 @@ int StepScheduler_nblock_z( const StepScheduler* stepscheduler )
   return stepscheduler->nblock_z_;
 }
 
+/*===========================================================================*/
+/*---Accessor: angle sets---*/
+
+int StepScheduler_nangle_set( const StepScheduler* stepscheduler )
+{
+  return stepscheduler->nangle_set_;
+}
+
+/*===========================================================================*/
+/*---Number of virtual blocks of this proc---*/
+
+int StepScheduler_nvblock( const StepScheduler* stepscheduler )
+{
+  return stepscheduler->nblock_x_ * stepscheduler->nblock_y_;
+}
+
+/*===========================================================================*/
+/*---Accessor: iterations pipelined in the schedule---*/
+
+int StepScheduler_niteration( const StepScheduler* stepscheduler )
+{
+  return stepscheduler->niteration_;
+}
+
 /*===========================================================================*/
 /*---Number of block steps executed for a single octant in isolation---*/
 
 int StepScheduler_nblock( const StepScheduler* stepscheduler )
 {
-  return stepscheduler->nblock_z_;
+  /*---The z blocks of all procs along the z axis form one pipeline,
+       which is traversed once for each angle set---*/
+  return stepscheduler->nblock_z_ * stepscheduler->nproc_z_ *
+         stepscheduler->nangle_set_;
 }
 
 /*===========================================================================*/
@@ -79,40 +387,34 @@ int StepScheduler_noctant_per_block( const StepScheduler* stepscheduler )
 
 int StepScheduler_nstep( const StepScheduler* stepscheduler )
 {
-  int result;
-
-  switch( stepscheduler->nblock_octant_ )
-  {
-    case 8:
-      result = 8 * StepScheduler_nblock( stepscheduler )
-                                        + 2 * ( stepscheduler->nproc_x_ - 1 )
-                                        + 3 * ( stepscheduler->nproc_y_ - 1 );
-      break;
-
-    case 4:
-      result = 4 * StepScheduler_nblock( stepscheduler )
-                                        + 1 * ( stepscheduler->nproc_x_ - 1 )
-                                        + 2 * ( stepscheduler->nproc_y_ - 1 );
-      break;
+  /*---Steps spanned by the starts of the octant blocks of this octant
+       group, plus the sweep of the last one across the procs---*/
+
+  const int octant_key_min = stepscheduler->octant_key_min_;
+  const int octant_key_max = octant_key_min + stepscheduler->noctant_key_ *
+                                              stepscheduler->niteration_;
+
+  return StepScheduler_step_base_key_( stepscheduler, octant_key_max-1 )
+       - StepScheduler_step_base_key_( stepscheduler, octant_key_min )
+       + StepScheduler_nblock( stepscheduler )
+       + ( stepscheduler->nproc_x_ - 1 )
+       + ( stepscheduler->nproc_y_ - 1 );
+}
 
-    case 2:
-      result = 2 * StepScheduler_nblock( stepscheduler )
-                                        + 1 * ( stepscheduler->nproc_x_ - 1 )
-                                        + 1 * ( stepscheduler->nproc_y_ - 1 );
-      break;
+/*===========================================================================*/
+/*---Number of steps saved by pipelining the iterations---*/
 
-    case 1:
-      result = 1 * StepScheduler_nblock( stepscheduler )
-                                        + 1 * ( stepscheduler->nproc_x_ - 1 )
-                                        + 1 * ( stepscheduler->nproc_y_ - 1 );
-      break;
+int StepScheduler_nstep_saved( const StepScheduler* stepscheduler )
+{
+  /*---Each iteration after the first starts step_period_ steps after the
+       previous one rather than after all of its steps---*/
 
-    default:
-      Assert( Bool_false );
-      break;
-  }
+  const int niteration = stepscheduler->niteration_;
+  const int nstep_iteration = stepscheduler->nstep_
+                            - ( niteration - 1 ) * stepscheduler->step_period_;
 
-  return result;
+  return ( niteration - 1 ) *
+         ( nstep_iteration - stepscheduler->step_period_ );
 }
 
 /*===========================================================================*/
@@ -122,24 +424,41 @@ StepInfo StepScheduler_stepinfo( const StepScheduler* stepscheduler,
                                  const int            step,
                                  const int            octant_in_block,
                                  const int            proc_x,
-                                 const int            proc_y )
+                                 const int            proc_y,
+                                 const int            proc_z )
 {
   Assert( octant_in_block>=0 &&
           octant_in_block * stepscheduler->nblock_octant_ < NOCTANT );
 
-  /*
-  const int nblock_octant     = stepscheduler->nblock_octant_;
-  */
   const int nproc_x           = stepscheduler->nproc_x_;
   const int nproc_y           = stepscheduler->nproc_y_;
+  const int nproc_z           = stepscheduler->nproc_z_;
+  const int nblock_z          = stepscheduler->nblock_z_;
+  const int nblock_g          = nblock_z * nproc_z;
   const int nblock            = StepScheduler_nblock( stepscheduler );
   const int nstep             = StepScheduler_nstep( stepscheduler );
   const int noctant_per_block = stepscheduler->noctant_per_block_;
+  const int octant_key_min    = stepscheduler->octant_key_min_;
+
+  const int nblock_octant     = stepscheduler->nblock_octant_;
+  const int octant_key_max    = octant_key_min + stepscheduler->noctant_key_ *
+                                                 stepscheduler->niteration_;
+
+  /*---Largest delay of the start of an octant block at a proc after
+       its start at the corner proc---*/
+  const int step_delay_max    = ( nproc_x - 1 ) + ( nproc_y - 1 ) +
+                                ( nproc_z - 1 ) * nblock_z;
+
+  /*---Position in the schedule sweeping all octant blocks---*/
+  const int step_all = step + StepScheduler_step_base_key_( stepscheduler,
+                                                            octant_key_min );
 
   int octant_key    = 0;
   int wave          = 0;
-  int step_base     = 0;
   int block         = 0;
+  int block_g       = 0;
+  int block_set     = 0;
+  int angle_set     = 0;
   int octant        = 0;
   int dir_x         = 0;
   int dir_y         = 0;
@@ -149,11 +468,11 @@ StepInfo StepScheduler_stepinfo( const StepScheduler* stepscheduler,
   int start_z       = 0;
   int folded_octant = 0;
   int folded_block  = 0;
+  int key           = 0;
+  int key_first     = 0;
 
   StepInfo stepinfo;
 
-  const int octant_selector[NOCTANT] = { 0, 4, 2, 6, 3, 7, 1, 5 };
-
   const Bool_t is_folded_x = noctant_per_block >= 2;
   const Bool_t is_folded_y = noctant_per_block >= 4;
   const Bool_t is_folded_z = noctant_per_block >= 8;
@@ -166,81 +485,66 @@ StepInfo StepScheduler_stepinfo( const StepScheduler* stepscheduler,
                           ?  ( nproc_y - 1 - proc_y )
                           :                  proc_y;
 
+  const int folded_proc_z = ( is_folded_z && ( octant_in_block & (1<<2) ) )
+                          ?  ( nproc_z - 1 - proc_z )
+                          :                  proc_z;
+
   /*===========================================================================
     For a given step and octant_in_block, the following computes the
     octant block (i.e., octant step), from which the octant can be
     computed, and the wavefront number, starting from the relevant begin
     corner of the selected octant.
-    For the nblock_octant==8 case, the 8 octants are processed in sequence,
-    in the order xyz = +++, ++-, -++, -+-, --+, ---, +-+, +--.
-    This order is chosen to "pack" the wavefronts to minimize
-    the KBA wavefront startup latency.
-    For nblock_octant=k for some smaller k, this sequence is divided into
-    subsequences of length k, and each subsequence defines the schedule
-    for a given octant_in_block.
-    The code below is essentially a search into the first subsequence
-    to determine where the requested step is located.  Locations in
-    the other subsequences can be derived from this.
-    NOTE: the following does not address possibility that for a single
-    step, two or more octants could update the same block.
+    The octant blocks are processed in the sequence octant_order_, each
+    starting at step_base_ on the proc at its begin corner and at a
+    correspondingly later step on the other procs.  By default this is
+    the order xyz = +++, ++-, -++, -+-, --+, ---, +-+, +--, or the order
+    found by the search at create time if shorter.
+    For nblock_octant=k for some smaller k, the sequence has length k and
+    is the schedule for octant_in_block 0; the schedules of the other
+    octants in the block are derived from it by folding.  With proc
+    groups dividing the octants, this proc group sweeps only its part of
+    the sequence.
+    With pipelined iterations the sequence is repeated once per
+    iteration, each repetition starting step_period_ steps after the
+    previous one.
+    The search below finds the last octant block this proc has started
+    by the requested step, i.e., whose wavefront has reached the first
+    block of this proc.  Octant blocks start on a proc in sequence, and
+    those of iterations starting step_delay_max or more steps earlier
+    have all started.
   ===========================================================================*/
 
-  if ( Bool_true )
-  {
-    wave = step - ( step_base );
-    octant_key = 0;
-  }
-  step_base += nblock;
-  if ( step >= ( step_base + folded_proc_x
-                           + folded_proc_y ) && ! is_folded_z )
-  {
-    wave = step - ( step_base );
-    octant_key = 1;
-  }
-  step_base += nblock;
-  if ( step >= ( step_base +            folded_proc_x
-                           +            folded_proc_y ) && ! is_folded_y )
-  {
-    wave = step - ( step_base + (nproc_y-1) );
-    octant_key = 2;
-  }
-  step_base += nblock + (nproc_y-1);
-  if ( step >= ( step_base + (nproc_y-1-folded_proc_y)
-                           +            folded_proc_x ) && ! is_folded_y )
-  {
-    wave = step - ( step_base );
-    octant_key = 3;
-  }
-  step_base += nblock;
-  if ( step >= ( step_base + (nproc_y-1-folded_proc_y)
-                           +            folded_proc_x ) && ! is_folded_x )
-  {
-    wave = step - ( step_base + (nproc_x-1) );
-    octant_key = 4;
-  }
-  step_base += nblock + (nproc_x-1);
-  if ( step >= ( step_base + (nproc_y-1-folded_proc_y)
-                           + (nproc_x-1-folded_proc_x) ) && ! is_folded_x )
-  {
-    wave = step - ( step_base );
-    octant_key = 5;
-  }
-  step_base += nblock;
-  if ( step >= ( step_base + (nproc_y-1-folded_proc_y)
-                           + (nproc_x-1-folded_proc_x) ) && ! is_folded_x )
-  {
-    wave = step - ( step_base + (nproc_y-1) );
-    octant_key = 6;
-  }
-  step_base += nblock + (nproc_y-1);
-  if ( step >= ( step_base +            folded_proc_y
-                           + (nproc_x-1-folded_proc_x) ) && ! is_folded_x )
+  key_first = step_all >= step_delay_max ?
+              ( ( step_all - step_delay_max ) / stepscheduler->step_period_ )
+                                                          * nblock_octant : 0;
+  key_first = key_first > octant_key_min ? key_first : octant_key_min;
+
+  octant_key = key_first;
+
+  for( key=key_first+1; key<octant_key_max; ++key )
   {
-    wave = step - ( step_base );
-    octant_key = 7;
+    const int octant_key_dir = stepscheduler->octant_order_[
+                                                       key % nblock_octant ];
+
+    const int step_start = StepScheduler_step_base_key_( stepscheduler, key )
+      + ( Dir_x( octant_key_dir ) == DIR_UP ? folded_proc_x
+                                            : nproc_x - 1 - folded_proc_x )
+      + ( Dir_y( octant_key_dir ) == DIR_UP ? folded_proc_y
+                                            : nproc_y - 1 - folded_proc_y )
+      + ( Dir_z( octant_key_dir ) == DIR_UP ? folded_proc_z
+                                            : nproc_z - 1 - folded_proc_z )
+                                                                  * nblock_z;
+
+    if( step_all < step_start )
+    {
+      break;
+    }
+    octant_key = key;
   }
 
-  folded_octant = octant_selector[ octant_key ];
+  wave = step_all - StepScheduler_step_base_key_( stepscheduler, octant_key );
+
+  folded_octant = stepscheduler->octant_order_[ octant_key % nblock_octant ];
 
   octant = folded_octant + octant_in_block;
 
@@ -257,120 +561,503 @@ StepInfo StepScheduler_stepinfo( const StepScheduler* stepscheduler,
   start_y = dir_y==DIR_UP ? 0 : ( nproc_y - 1 );
   start_z = dir_z==DIR_UP ? 0 : ( nblock  - 1 );
 
-  /*---Get coordinate of block on this processor to be processed---*/
+  /*---Get global z coordinate of block in this proc column to be processed---*/
   folded_block = ( wave - ( start_x + folded_proc_x * dir_x )
                         - ( start_y + folded_proc_y * dir_y )
                         - ( start_z ) ) / dir_z;
 
-  block = ( is_folded_z && ( octant_in_block & (1<<2) ) )
+  block_set = ( is_folded_z && ( octant_in_block & (1<<2) ) )
                           ? ( nblock - 1 - folded_block )
                           : folded_block;
 
+  /*---The pipeline visits every global z block for one angle set, then
+       every block for the next; a z neighbor thus receives its face for
+       the same angle set on the following step---*/
+
+  angle_set = block_set >= 0 ? block_set / nblock_g : -1;
+  block_g   = block_set >= 0 ? block_set % nblock_g : -1;
+
+  /*---Convert to a block number local to this proc along z---*/
+
+  block = block_g - proc_z * nblock_z;
+
   /*---Now determine whether the block calculation is active based on whether
-       the block in question falls within the physical domain.
+       the block in question falls within the physical domain
+       and is owned by this proc.
   ---*/
 
-  stepinfo.is_active = block  >= 0 && block  < nblock &&
+  stepinfo.is_active = block_set >= 0 && block_set < nblock &&
+                       block  >= 0 && block  < nblock_z &&
                        step   >= 0 && step   < nstep &&
+                       octant_key >= octant_key_min &&
+                       octant_key <  octant_key_max &&
                        proc_x >= 0 && proc_x < nproc_x &&
-                       proc_y >= 0 && proc_y < nproc_y;
+                       proc_y >= 0 && proc_y < nproc_y &&
+                       proc_z >= 0 && proc_z < nproc_z;
 
   /*---Set remaining values---*/
 
-  stepinfo.block_z = stepinfo.is_active ? block : 0;
-  stepinfo.octant  = octant;
+  stepinfo.block_z   = stepinfo.is_active ? block : 0;
+  stepinfo.octant    = octant;
+  stepinfo.angle_set = stepinfo.is_active ? angle_set : 0;
+  stepinfo.iteration = octant_key / nblock_octant;
+  stepinfo.iz_base   = 0;
+  stepinfo.ncell_z   = 0;
+  stepinfo.ix_base   = 0;
+  stepinfo.ncell_x   = 0;
+  stepinfo.iy_base   = 0;
+  stepinfo.ncell_y   = 0;
 
   return stepinfo;
 }
 
 /*===========================================================================*/
-/*---Determine whether to send a face computed at step, used at step+1---*/
-
-Bool_t StepScheduler_must_do_send(
-  StepScheduler* stepscheduler,
-  int            step,
-  int            axis,
-  int            dir_ind,
-  int            octant_in_block,
-  Env*           env )
+/*---Determine whether a given proc sends a face computed at step---*/
+/*---The target may be a virtual block of the same proc---*/
+
+Bool_t StepScheduler_must_do_send_proc(
+  const StepScheduler* stepscheduler,
+  int                  step,
+  int                  axis,
+  int                  dir_ind,
+  int                  octant_in_block,
+  int                  proc_x,
+  int                  proc_y,
+  int                  proc_z )
 {
-  const int proc_x = Env_proc_x_this( env );
-  const int proc_y = Env_proc_y_this( env );
+  const int nblock_z = stepscheduler->nblock_z_;
 
   const Bool_t axis_x = axis==0;
   const Bool_t axis_y = axis==1;
+  const Bool_t axis_z = axis==2;
 
   const int dir = dir_ind==0 ? (int)DIR_UP : (int)DIR_DN;
   const int inc_x = axis_x ? Dir_inc( dir ) : 0;
   const int inc_y = axis_y ? Dir_inc( dir ) : 0;
+  const int inc_z = axis_z ? Dir_inc( dir ) : 0;
 
   /*---Get step info for processors involved in communication---*/
 
   const StepInfo stepinfo_send_source_step = StepScheduler_stepinfo(
-    stepscheduler, step,   octant_in_block, proc_x,       proc_y       );
+    stepscheduler, step,   octant_in_block, proc_x,       proc_y,
+                                            proc_z );
 
   const StepInfo stepinfo_send_target_step = StepScheduler_stepinfo(
-    stepscheduler, step+1, octant_in_block, proc_x+inc_x, proc_y+inc_y );
+    stepscheduler, step+1, octant_in_block, proc_x+inc_x, proc_y+inc_y,
+                                            proc_z+inc_z );
 
   /*---Determine whether to communicate---*/
+  /*---Along z the target block is the next one in global numbering---*/
 
   Bool_t const do_send = stepinfo_send_source_step.is_active
                       && stepinfo_send_target_step.is_active
                       && stepinfo_send_source_step.octant ==
                          stepinfo_send_target_step.octant
-                      && stepinfo_send_source_step.block_z ==
-                         stepinfo_send_target_step.block_z
+                      && stepinfo_send_source_step.angle_set ==
+                         stepinfo_send_target_step.angle_set
+                      && stepinfo_send_source_step.iteration ==
+                         stepinfo_send_target_step.iteration
+                      && stepinfo_send_source_step.block_z +
+                                       nblock_z * proc_z + inc_z ==
+                         stepinfo_send_target_step.block_z +
+                                       nblock_z * ( proc_z + inc_z )
                       && ( axis_x ?
                            Dir_x( stepinfo_send_target_step.octant ) :
-                           Dir_y( stepinfo_send_target_step.octant ) ) == dir;
+                           axis_y ?
+                           Dir_y( stepinfo_send_target_step.octant ) :
+                           Dir_z( stepinfo_send_target_step.octant ) ) == dir;
 
   return do_send;
 }
 
 /*===========================================================================*/
-/*---Determine whether to recv a face computed at step, used at step+1---*/
-
-Bool_t StepScheduler_must_do_recv(
-  StepScheduler* stepscheduler,
-  int            step,
-  int            axis,
-  int            dir_ind,
-  int            octant_in_block,
-  Env*           env )
+/*---Determine whether a given proc recvs a face computed at step---*/
+
+Bool_t StepScheduler_must_do_recv_proc(
+  const StepScheduler* stepscheduler,
+  int                  step,
+  int                  axis,
+  int                  dir_ind,
+  int                  octant_in_block,
+  int                  proc_x,
+  int                  proc_y,
+  int                  proc_z )
 {
-  const int proc_x = Env_proc_x_this( env );
-  const int proc_y = Env_proc_y_this( env );
+  const int nblock_z = stepscheduler->nblock_z_;
 
   const Bool_t axis_x = axis==0;
   const Bool_t axis_y = axis==1;
+  const Bool_t axis_z = axis==2;
 
   const int dir = dir_ind==0 ? (int)DIR_UP : (int)DIR_DN;
   const int inc_x = axis_x ? Dir_inc( dir ) : 0;
   const int inc_y = axis_y ? Dir_inc( dir ) : 0;
+  const int inc_z = axis_z ? Dir_inc( dir ) : 0;
 
   /*---Get step info for processors involved in communication---*/
 
   const StepInfo stepinfo_recv_source_step = StepScheduler_stepinfo(
-    stepscheduler, step,   octant_in_block, proc_x-inc_x, proc_y-inc_y );
+    stepscheduler, step,   octant_in_block, proc_x-inc_x, proc_y-inc_y,
+                                            proc_z-inc_z );
 
   const StepInfo stepinfo_recv_target_step = StepScheduler_stepinfo(
-    stepscheduler, step+1, octant_in_block, proc_x,       proc_y       );
+    stepscheduler, step+1, octant_in_block, proc_x,       proc_y,
+                                            proc_z );
 
   /*---Determine whether to communicate---*/
+  /*---Along z the target block is the next one in global numbering---*/
 
   Bool_t const do_recv = stepinfo_recv_source_step.is_active
                       && stepinfo_recv_target_step.is_active
                       && stepinfo_recv_source_step.octant ==
                          stepinfo_recv_target_step.octant
-                      && stepinfo_recv_source_step.block_z ==
-                         stepinfo_recv_target_step.block_z
+                      && stepinfo_recv_source_step.angle_set ==
+                         stepinfo_recv_target_step.angle_set
+                      && stepinfo_recv_source_step.iteration ==
+                         stepinfo_recv_target_step.iteration
+                      && stepinfo_recv_source_step.block_z +
+                                       nblock_z * ( proc_z - inc_z ) + inc_z ==
+                         stepinfo_recv_target_step.block_z +
+                                       nblock_z * proc_z
                       && ( axis_x ?
                            Dir_x( stepinfo_recv_target_step.octant ) :
-                           Dir_y( stepinfo_recv_target_step.octant ) ) == dir;
+                           axis_y ?
+                           Dir_y( stepinfo_recv_target_step.octant ) :
+                           Dir_z( stepinfo_recv_target_step.octant ) ) == dir;
 
   return do_recv;
 }
 
+/*===========================================================================*/
+/*---Compile the schedule of this proc into tables---*/
+
+static void StepScheduler_compile_( StepScheduler* stepscheduler,
+                                    Env*           env )
+{
+  const int nblock_x = stepscheduler->nblock_x_;
+  const int nblock_y = stepscheduler->nblock_y_;
+  const int nvblock  = nblock_x * nblock_y;
+
+  const int proc_x = Env_proc_x_this( env );
+  const int proc_y = Env_proc_y_this( env );
+  const int proc_z = Env_proc_z_this( env );
+
+  const int nstep             = StepScheduler_nstep( stepscheduler );
+  const int nblock_z          = stepscheduler->nblock_z_;
+  const int noctant_per_block = stepscheduler->noctant_per_block_;
+  const int nsemiblock        = stepscheduler->nsemiblock_;
+  const int nentry            = nstep * nvblock * noctant_per_block;
+
+  stepscheduler->nstep_    = nstep;
+  stepscheduler->stepinfo_ = (StepInfo*) malloc( nentry * sizeof(StepInfo) );
+  stepscheduler->send_mask_     = (int*) malloc( nentry * sizeof(int) );
+  stepscheduler->recv_mask_     = (int*) malloc( nentry * sizeof(int) );
+  stepscheduler->do_block_init_ = (unsigned long int*)
+                     malloc( nstep * nvblock * sizeof(unsigned long int) );
+  stepscheduler->step_block_final_ = malloc_host_int( nblock_z );
+
+  /*---Running tally of which semiblocks of each block have been set,
+       for each iteration and virtual block---*/
+
+  const int nblock_init = nblock_z * stepscheduler->niteration_ * nvblock;
+
+  int* is_block_init = malloc_host_int( nblock_init );
+
+  int step = 0;
+  int i = 0;
+
+  for( i=0; i<nblock_init; ++i )
+  {
+    is_block_init[i] = 0;
+  }
+
+  for( i=0; i<nblock_z; ++i )
+  {
+    stepscheduler->step_block_final_[i] = -1;
+  }
+
+  for( step=0; step<nstep; ++step )
+  {
+  int vblock = 0;
+  for( vblock=0; vblock<nvblock; ++vblock )
+  {
+    /*---Position of the virtual block among those of all procs---*/
+
+    const int vproc_x = proc_x * nblock_x + vblock % nblock_x;
+    const int vproc_y = proc_y * nblock_y + vblock / nblock_x;
+
+    const int index_vblock = vblock + nvblock * step;
+
+    int octant_in_block = 0;
+    int semiblock_step = 0;
+
+    /*---Step info and face communication---*/
+
+    for( octant_in_block=0; octant_in_block<noctant_per_block;
+                                                            ++octant_in_block )
+    {
+      const int index = octant_in_block + noctant_per_block * index_vblock;
+
+      int axis = 0;
+
+      stepscheduler->stepinfo_[index] = StepScheduler_stepinfo(
+        stepscheduler, step, octant_in_block, vproc_x, vproc_y, proc_z );
+
+      if( stepscheduler->stepinfo_[index].is_active )
+      {
+        stepscheduler->step_block_final_[
+                           stepscheduler->stepinfo_[index].block_z ] = step;
+      }
+
+      stepscheduler->send_mask_[index] = 0;
+      stepscheduler->recv_mask_[index] = 0;
+
+      for( axis=0; axis<NDIM; ++axis )
+      {
+        int dir_ind = 0;
+        for( dir_ind=0; dir_ind<2; ++dir_ind )
+        {
+          if( StepScheduler_must_do_send_proc( stepscheduler, step, axis,
+                         dir_ind, octant_in_block, vproc_x, vproc_y, proc_z ) )
+          {
+            stepscheduler->send_mask_[index] |= 1 << ( dir_ind + 2 * axis );
+          }
+          if( StepScheduler_must_do_recv_proc( stepscheduler, step, axis,
+                         dir_ind, octant_in_block, vproc_x, vproc_y, proc_z ) )
+          {
+            stepscheduler->recv_mask_[index] |= 1 << ( dir_ind + 2 * axis );
+          }
+        }
+      }
+    } /*---octant_in_block---*/
+
+    /*---Determine whether this is the first calculation for this sweep step
+         and semiblock step - in which case set values rather than add
+         values---*/
+
+    stepscheduler->do_block_init_[index_vblock] = 0;
+
+    for( semiblock_step=0; semiblock_step<nsemiblock; ++semiblock_step )
+    {
+      for( octant_in_block=0; octant_in_block<noctant_per_block;
+                                                            ++octant_in_block )
+      {
+        const StepInfo stepinfo = stepscheduler->stepinfo_[
+                         octant_in_block + noctant_per_block * index_vblock ];
+        if( stepinfo.is_active )
+        {
+          const Bool_t is_semiblock_min_x = is_semiblock_min_when_semiblocked(
+              nsemiblock, semiblock_step, DIM_X, Dir_x( stepinfo.octant ) ) ||
+              ! is_axis_semiblocked( nsemiblock, DIM_X );
+          const Bool_t is_semiblock_min_y = is_semiblock_min_when_semiblocked(
+              nsemiblock, semiblock_step, DIM_Y, Dir_y( stepinfo.octant ) ) ||
+              ! is_axis_semiblocked( nsemiblock, DIM_Y );
+          const Bool_t is_semiblock_min_z = is_semiblock_min_when_semiblocked(
+              nsemiblock, semiblock_step, DIM_Z, Dir_z( stepinfo.octant ) ) ||
+              ! is_axis_semiblocked( nsemiblock, DIM_Z );
+
+          /*---Which semiblock is being processed, according to a uniform
+               direction-independent numbering scheme---*/
+
+          const int semiblock_num = ( is_semiblock_min_x ? 0 : 1 ) + 2 * (
+                                    ( is_semiblock_min_y ? 0 : 1 ) + 2 * (
+                                    ( is_semiblock_min_z ? 0 : 1 ) ));
+
+          const int block_init = stepinfo.block_z + nblock_z * (
+                                 stepinfo.iteration +
+                                 stepscheduler->niteration_ * vblock );
+
+          if( ! ( is_block_init[ block_init ] & ( 1 << semiblock_num ) ) )
+          {
+            stepscheduler->do_block_init_[index_vblock] |=
+                             ( ((unsigned long int)1) <<
+                             ( octant_in_block + noctant_per_block *
+                               semiblock_step ) );
+            is_block_init[ block_init ] |= ( 1 << semiblock_num );
+          }
+        }
+      } /*---octant_in_block---*/
+    } /*---semiblock_step---*/
+  } /*---vblock---*/
+  } /*---step---*/
+
+  free_host_int( is_block_init );
+}
+
+/*===========================================================================*/
+/*---Get information describing a sweep step of this proc---*/
+
+StepInfo StepScheduler_stepinfo_this( const StepScheduler* stepscheduler,
+                                      int                  step,
+                                      int                  vblock,
+                                      int                  octant_in_block )
+{
+  Assert( vblock >= 0 && vblock < StepScheduler_nvblock( stepscheduler ) );
+  Assert( octant_in_block>=0 &&
+          octant_in_block < stepscheduler->noctant_per_block_ );
+
+  if( step < 0 || step >= stepscheduler->nstep_ )
+  {
+    /*---Steps outside the schedule, e.g. to fill or drain a pipeline---*/
+    StepInfo stepinfo;
+    stepinfo.block_z   = 0;
+    stepinfo.octant    = 0;
+    stepinfo.angle_set = 0;
+    stepinfo.iteration = 0;
+    stepinfo.iz_base   = 0;
+    stepinfo.ncell_z   = 0;
+    stepinfo.ix_base   = 0;
+    stepinfo.ncell_x   = 0;
+    stepinfo.iy_base   = 0;
+    stepinfo.ncell_y   = 0;
+    stepinfo.is_active = Bool_false;
+    return stepinfo;
+  }
+
+  return stepscheduler->stepinfo_[ octant_in_block +
+                                   stepscheduler->noctant_per_block_ * (
+                                   vblock +
+                                   StepScheduler_nvblock( stepscheduler ) *
+                                   step ) ];
+}
+
+/*===========================================================================*/
+/*---Octants and semiblocks whose update of a block at a step is the first---*/
+
+unsigned long int StepScheduler_do_block_init(
+  const StepScheduler* stepscheduler,
+  int                  step,
+  int                  vblock )
+{
+  Assert( step >= 0 && step < stepscheduler->nstep_ );
+  Assert( vblock >= 0 && vblock < StepScheduler_nvblock( stepscheduler ) );
+
+  return stepscheduler->do_block_init_[ vblock +
+                               StepScheduler_nvblock( stepscheduler ) * step ];
+}
+
+/*===========================================================================*/
+/*---Determine whether to send a face computed at step, used at step+1---*/
+
+Bool_t StepScheduler_must_do_send(
+  StepScheduler* stepscheduler,
+  int            step,
+  int            vblock,
+  int            axis,
+  int            dir_ind,
+  int            octant_in_block,
+  Env*           env )
+{
+  Assert( vblock >= 0 && vblock < StepScheduler_nvblock( stepscheduler ) );
+  Assert( axis >= 0 && axis < NDIM );
+  Assert( dir_ind >= 0 && dir_ind < 2 );
+  Assert( octant_in_block>=0 &&
+          octant_in_block < stepscheduler->noctant_per_block_ );
+
+  return step >= 0 && step < stepscheduler->nstep_ &&
+         ( stepscheduler->send_mask_[ octant_in_block +
+                                   stepscheduler->noctant_per_block_ * (
+                                   vblock +
+                                   StepScheduler_nvblock( stepscheduler ) *
+                                   step ) ] &
+           ( 1 << ( dir_ind + 2 * axis ) ) ) != 0;
+}
+
+/*===========================================================================*/
+/*---Determine whether to recv a face computed at step, used at step+1---*/
+
+Bool_t StepScheduler_must_do_recv(
+  StepScheduler* stepscheduler,
+  int            step,
+  int            vblock,
+  int            axis,
+  int            dir_ind,
+  int            octant_in_block,
+  Env*           env )
+{
+  Assert( vblock >= 0 && vblock < StepScheduler_nvblock( stepscheduler ) );
+  Assert( axis >= 0 && axis < NDIM );
+  Assert( dir_ind >= 0 && dir_ind < 2 );
+  Assert( octant_in_block>=0 &&
+          octant_in_block < stepscheduler->noctant_per_block_ );
+
+  return step >= 0 && step < stepscheduler->nstep_ &&
+         ( stepscheduler->recv_mask_[ octant_in_block +
+                                   stepscheduler->noctant_per_block_ * (
+                                   vblock +
+                                   StepScheduler_nvblock( stepscheduler ) *
+                                   step ) ] &
+           ( 1 << ( dir_ind + 2 * axis ) ) ) != 0;
+}
+
+/*===========================================================================*/
+/*---Last step at which this proc sweeps a z block, or -1 if none---*/
+
+int StepScheduler_step_block_final( const StepScheduler* stepscheduler,
+                                    int                  block_z )
+{
+  Assert( block_z >= 0 && block_z < stepscheduler->nblock_z_ );
+  Assert( stepscheduler->step_block_final_ );
+
+  return stepscheduler->step_block_final_[ block_z ];
+}
+
+/*===========================================================================*/
+/*---Print the compiled schedule of this proc---*/
+
+void StepScheduler_dump( const StepScheduler* stepscheduler,
+                         Env*                 env )
+{
+  const int noctant_per_block = stepscheduler->noctant_per_block_;
+  const int nvblock           = StepScheduler_nvblock( stepscheduler );
+
+  int step = 0;
+  int octant_key = 0;
+
+  /*---Order of the octant blocks and steps saved against the built-in
+       order, for the schedule sweeping all octant blocks---*/
+
+  printf( "schedule proc %i octant_order", Env_proc_this( env ) );
+  for( octant_key=0; octant_key<stepscheduler->nblock_octant_; ++octant_key )
+  {
+    printf( " %i", stepscheduler->octant_order_[octant_key] );
+  }
+  printf( " nstep_all %i nstep_all_builtin %i saved %i\n",
+          stepscheduler->nstep_all_, stepscheduler->nstep_all_builtin_,
+          stepscheduler->nstep_all_builtin_ - stepscheduler->nstep_all_ );
+
+  for( step=0; step<stepscheduler->nstep_; ++step )
+  {
+  int vblock = 0;
+  for( vblock=0; vblock<nvblock; ++vblock )
+  {
+    const int index_vblock = vblock + nvblock * step;
+
+    int octant_in_block = 0;
+    for( octant_in_block=0; octant_in_block<noctant_per_block;
+                                                            ++octant_in_block )
+    {
+      const int index = octant_in_block + noctant_per_block * index_vblock;
+      const StepInfo stepinfo = stepscheduler->stepinfo_[index];
+
+      if( stepinfo.is_active )
+      {
+        printf( "schedule proc %i step %i vblock %i octant_in_block %i"
+                " octant %i block_z %i angle_set %i iteration %i"
+                " send %02x recv %02x init %lx\n",
+                Env_proc_this( env ), step, vblock, octant_in_block,
+                stepinfo.octant, stepinfo.block_z, stepinfo.angle_set,
+                stepinfo.iteration,
+                stepscheduler->send_mask_[index],
+                stepscheduler->recv_mask_[index],
+                stepscheduler->do_block_init_[index_vblock] );
+      }
+    }
+  }
+  }
+  fflush( stdout );
+}
+
 /*===========================================================================*/
 
 #ifdef __cplusplus_IGNORE
@@ -26,10 +26,45 @@ extern "C"
 typedef struct
 {
   int nblock_z_;
-  int nproc_x_;
+  int nangle_set_;        /*---Angle sets pipelined after the z blocks---*/
+  int nblock_x_;          /*---Virtual blocks of this proc along x, y---*/
+  int nblock_y_;
+  int nproc_x_;           /*---Counts virtual blocks along x, y---*/
   int nproc_y_;
+  int nproc_z_;
   int nblock_octant_;
   int noctant_per_block_;
+  int octant_key_min_;    /*---First octant block swept by this proc group---*/
+  int noctant_key_;       /*---Number of octant blocks swept by this group---*/
+  int nsemiblock_;
+
+  /*---Order in which octant blocks are swept, given by the octant of the
+       block with all folded directions up, and step at which each starts
+       at the corner proc; steps of the full schedule for this order and
+       for the built-in order---*/
+
+  int octant_order_[NOCTANT];
+  int step_base_[NOCTANT];
+  int nstep_all_;
+  int nstep_all_builtin_;
+
+  /*---Iterations pipelined one after another, and steps between the
+       starts of successive iterations at the corner proc---*/
+
+  int niteration_;
+  int step_period_;
+
+  /*---Schedule of this proc, compiled once, indexed by step, virtual
+       block and octant_in_block; masks have bit dir_ind+2*axis set for
+       each face communicated---*/
+
+  int                nstep_;
+  StepInfo*          stepinfo_;
+  int*               send_mask_;
+  int*               recv_mask_;
+  unsigned long int* do_block_init_;   /*---indexed by step, vblock---*/
+  int*               step_block_final_; /*---Last step at which this proc
+                                            sweeps each z block, or -1---*/
 } StepScheduler;
 
 /*===========================================================================*/
@@ -42,9 +77,31 @@ StepScheduler StepScheduler_null(void);
 
 void StepScheduler_create( StepScheduler* stepscheduler,
                            int            nblock_z,
+                           int            nangle_set,
+                           int            nblock_x,
+                           int            nblock_y,
                            int            nblock_octant,
+                           int            nsemiblock,
+                           int            niteration,
+                           Bool_t         is_octant_order_optimized,
                            Env*           env );
 
+/*===========================================================================*/
+/*---Pseudo-constructor for a schedule that is only measured, for a
+     decomposition other than that of the environment---*/
+
+void StepScheduler_create_model( StepScheduler* stepscheduler,
+                                 int            nblock_z,
+                                 int            nangle_set,
+                                 int            nproc_x,
+                                 int            nproc_y,
+                                 int            nproc_z,
+                                 int            nblock_octant,
+                                 int            nproc_octant,
+                                 int            proc_octant,
+                                 int            niteration,
+                                 Bool_t         is_octant_order_optimized );
+
 /*===========================================================================*/
 /*---Pseudo-destructor for StepScheduler struct---*/
 
@@ -55,6 +112,21 @@ void StepScheduler_destroy( StepScheduler* stepscheduler );
 
 int StepScheduler_nblock_z( const StepScheduler* stepscheduler );
 
+/*===========================================================================*/
+/*---Accessor: angle sets---*/
+
+int StepScheduler_nangle_set( const StepScheduler* stepscheduler );
+
+/*===========================================================================*/
+/*---Number of virtual blocks of this proc---*/
+
+int StepScheduler_nvblock( const StepScheduler* stepscheduler );
+
+/*===========================================================================*/
+/*---Accessor: iterations pipelined in the schedule---*/
+
+int StepScheduler_niteration( const StepScheduler* stepscheduler );
+
 /*===========================================================================*/
 /*---Number of block steps executed for a single octant in isolation---*/
 
@@ -70,14 +142,52 @@ int StepScheduler_noctant_per_block( const StepScheduler* stepscheduler );
 
 int StepScheduler_nstep( const StepScheduler* stepscheduler );
 
+/*===========================================================================*/
+/*---Number of steps saved by pipelining the iterations---*/
+
+int StepScheduler_nstep_saved( const StepScheduler* stepscheduler );
+
 /*===========================================================================*/
 /*---Get information describing a sweep step---*/
+/*---proc_x, proc_y count virtual blocks---*/
 
 StepInfo StepScheduler_stepinfo( const StepScheduler* stepscheduler,  
                                  const int            step,
                                  const int            octant_in_block,
                                  const int            proc_x,
-                                 const int            proc_y );
+                                 const int            proc_y,
+                                 const int            proc_z );
+
+/*===========================================================================*/
+/*---Get information describing a sweep step of a virtual block of this
+     proc, numbered x fastest---*/
+
+StepInfo StepScheduler_stepinfo_this( const StepScheduler* stepscheduler,
+                                      int                  step,
+                                      int                  vblock,
+                                      int                  octant_in_block );
+
+/*===========================================================================*/
+/*---Octants and semiblocks whose update of a block at a step is the first,
+     so that values are set rather than added: bit
+     octant_in_block+noctant_per_block*semiblock_step---*/
+
+unsigned long int StepScheduler_do_block_init(
+  const StepScheduler* stepscheduler,
+  int                  step,
+  int                  vblock );
+
+/*===========================================================================*/
+/*---Last step at which this proc sweeps a z block, or -1 if none---*/
+
+int StepScheduler_step_block_final( const StepScheduler* stepscheduler,
+                                    int                  block_z );
+
+/*===========================================================================*/
+/*---Print the compiled schedule of this proc---*/
+
+void StepScheduler_dump( const StepScheduler* stepscheduler,
+                         Env*                 env );
 
 /*===========================================================================*/
 /*---Determine whether to send a face computed at step, used at step+1---*/
@@ -85,6 +195,7 @@ StepInfo StepScheduler_stepinfo( const StepScheduler* stepscheduler,
 Bool_t StepScheduler_must_do_send(
   StepScheduler* stepscheduler,
   int            step,
+  int            vblock,
   int            axis,
   int            dir_ind,
   int            octant_in_block,
@@ -96,11 +207,40 @@ Bool_t StepScheduler_must_do_send(
 Bool_t StepScheduler_must_do_recv(
   StepScheduler* stepscheduler,
   int            step,
+  int            vblock,
   int            axis,
   int            dir_ind,
   int            octant_in_block,
   Env*           env );
 
+/*===========================================================================*/
+/*---Determine whether a given proc sends a face computed at step, used at
+     step+1; proc_x, proc_y count virtual blocks---*/
+
+Bool_t StepScheduler_must_do_send_proc(
+  const StepScheduler* stepscheduler,
+  int                  step,
+  int                  axis,
+  int                  dir_ind,
+  int                  octant_in_block,
+  int                  proc_x,
+  int                  proc_y,
+  int                  proc_z );
+
+/*===========================================================================*/
+/*---Determine whether a given proc recvs a face computed at step, used at
+     step+1; proc_x, proc_y count virtual blocks---*/
+
+Bool_t StepScheduler_must_do_recv_proc(
+  const StepScheduler* stepscheduler,
+  int                  step,
+  int                  axis,
+  int                  dir_ind,
+  int                  octant_in_block,
+  int                  proc_x,
+  int                  proc_y,
+  int                  proc_z );
+
 /*===========================================================================*/
 
 #ifdef __cplusplus_IGNORE
@@ -26,9 +26,36 @@ typedef struct
 {
   int     block_z;
   int     octant;
+  int     angle_set;
+  int     iteration;  /*---Pipelined iteration the step belongs to---*/
+  int     iz_base;    /*---Cells of the z block, set by the sweeper---*/
+  int     ncell_z;
+  int     ix_base;    /*---Cells of the virtual x/y block, likewise---*/
+  int     ncell_x;
+  int     iy_base;
+  int     ncell_y;
   Bool_t  is_active;
 } StepInfo;
 
+/*===========================================================================*/
+/*---Range of angles swept at a step: the angle set of the step---*/
+
+TARGET_HD static inline int StepInfo_ia_min( const StepInfo stepinfo,
+                                             int            na,
+                                             int            nangle_set )
+{
+  return ( na * ( stepinfo.angle_set     ) ) / nangle_set;
+}
+
+/*---------------------------------------------------------------------------*/
+
+TARGET_HD static inline int StepInfo_ia_max( const StepInfo stepinfo,
+                                             int            na,
+                                             int            nangle_set )
+{
+  return ( na * ( stepinfo.angle_set + 1 ) ) / nangle_set;
+}
+
 /*===========================================================================*/
 /*---8 copies of the same---*/
 
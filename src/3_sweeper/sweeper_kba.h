@@ -48,6 +48,14 @@ typedef struct
   int              nthread_z;
 
   int              nblock_z;
+  int*             iz_base_block;  /*---z cell bounds of the blocks---*/
+  Request_t*       request_reduce; /*---Of the sums of z blocks of vo
+                                        across octant groups---*/
+  int              nblock_x;       /*---Virtual blocks along x, y---*/
+  int              nblock_y;
+  int*             ix_base_block;  /*---x, y cell bounds of these---*/
+  int*             iy_base_block;
+  int              nangle_set;
   int              nblock_octant;
   int              noctant_per_block;
   int              nsemiblock;
@@ -56,8 +64,18 @@ typedef struct
   int              ncell_z_per_subblock;
 
   StepScheduler    stepscheduler;
+  Bool_t           is_octant_order_optimized;
 
   Faces            faces;
+
+  Timer            time_sweep_block;  /*---Accumulated block compute time---*/
+  Timer            time_idle_saved;   /*---Estimated idle time recovered by
+                                           pipelining iterations---*/
+  Timer            time_comm_wait;    /*---Accumulated time waiting on face
+                                           and octant sum messages---*/
+  int              nstep_active;      /*---Accumulated steps with and
+                                           without work on this proc---*/
+  int              nstep_inactive;
 } Sweeper;
 
 /*===========================================================================*/
@@ -80,6 +98,18 @@ void Sweeper_create( Sweeper*          sweeper,
 void Sweeper_destroy( Sweeper* sweeper,
                       Env*     env );
 
+/*===========================================================================*/
+/*---Bytes of the arrays a sweeper would allocate, added by memory tracker
+     category, and of the buffers made at each step, without creating it;
+     the settings are taken from args as by Sweeper_create---*/
+
+void Sweeper_predict_memory( size_t*     nbyte,
+                             size_t*     nbyte_device,
+                             size_t*     nbyte_step,
+                             Dimensions  dims,
+                             Env*        env,
+                             Arguments*  args );
+
 /*===========================================================================*/
 /*---Number of octants in an octant block---*/
 
@@ -230,22 +260,30 @@ static int Sweeper_shared_size_( Sweeper* sweeper,
 SweeperLite Sweeper_sweeperlite( Sweeper* sweeper );
 
 /*===========================================================================*/
-/*---Perform a sweep for a block---*/
+/*---Perform a sweep for a virtual block---*/
 
 void Sweeper_sweep_block(
   Sweeper*               sweeper,
   Pointer*               vo,
   Pointer*               vi,
-  int*                   is_block_init,
   Pointer*               facexy,
   Pointer*               facexz,
   Pointer*               faceyz,
   const Pointer*         a_from_m,
   const Pointer*         m_from_a,
   int                    step,
+  int                    vblock,
   const Quantities*      quan,
   Env*                   env );
 
+/*===========================================================================*/
+/*---Rebuild the step schedule for a number of pipelined iterations, if
+     not already built for it---*/
+
+void Sweeper_set_niteration( Sweeper* sweeper,
+                             int      niteration,
+                             Env*     env );
+
 /*===========================================================================*/
 /*---Perform a sweep---*/
 
@@ -256,6 +294,17 @@ void Sweeper_sweep(
   const Quantities*      quan,
   Env*                   env );
 
+/*===========================================================================*/
+/*---Perform several sweep iterations as one pipeline, alternating vi/vo---*/
+
+void Sweeper_sweep_iterations(
+  Sweeper*               sweeper,
+  Pointer*               vo,
+  Pointer*               vi,
+  int                    niterations,
+  const Quantities*      quan,
+  Env*                   env );
+
 /*===========================================================================*/
 
 #ifdef __cplusplus_IGNORE
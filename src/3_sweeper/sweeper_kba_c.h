@@ -13,6 +13,9 @@
 
 #include "types.h"
 #include "env.h"
+#include "profiler.h"
+#include "counters.h"
+#include "memtracker.h"
 #include "pointer.h"
 #include "definitions.h"
 #include "quantities.h"
@@ -41,20 +44,88 @@ Sweeper Sweeper_null()
 }
 
 /*===========================================================================*/
-/*---Pseudo-constructor for Sweeper struct---*/
+/*---Set z cell bounds of the blocks of this proc---*/
 
-void Sweeper_create( Sweeper*          sweeper,
-                     Dimensions        dims,
-                     const Quantities* quan,
-                     Env*              env,
-                     Arguments*        args )
+static void Sweeper_set_iz_base_block_( Sweeper* sweeper,
+                                        int      ncell_z,
+                                        Bool_t   is_block_z_tapered,
+                                        Env*     env )
+{
+  const int nblock_z = sweeper->nblock_z;
+  const int nblock_g = nblock_z * Env_nproc_z( env );
+  const int block_g_base = nblock_z * Env_proc_z_this( env );
+
+  int* iz_base_block = sweeper->iz_base_block;
+
+  int block = 0;
+
+  if( ! is_block_z_tapered )
+  {
+    /*---Split as evenly as possible---*/
+
+    for( block=0; block<=nblock_z; ++block )
+    {
+      iz_base_block[block] = ( block * ncell_z ) / nblock_z;
+    }
+  }
+  else
+  {
+    /*---Thickness grows from the ends of the global wavefront pipeline
+         toward its middle, so that filling and draining the pipeline
+         take short steps---*/
+
+    double weight_sum = 0;
+    double weight_partial = 0;
+
+    for( block=0; block<nblock_z; ++block )
+    {
+      const int block_g = block_g_base + block;
+      weight_sum += 1 + imin( block_g, nblock_g - 1 - block_g );
+    }
+
+    iz_base_block[0] = 0;
+    for( block=1; block<nblock_z; ++block )
+    {
+      const int block_g = block_g_base + block - 1;
+      weight_partial += 1 + imin( block_g, nblock_g - 1 - block_g );
+      const int iz = (int)( ncell_z * weight_partial / weight_sum + .5 );
+      /*---Keep every block nonempty---*/
+      const int iz_min = iz_base_block[block-1] + 1;
+      const int iz_max = ncell_z - ( nblock_z - block );
+      iz_base_block[block] = iz < iz_min ? iz_min : iz > iz_max ? iz_max : iz;
+    }
+    iz_base_block[nblock_z] = ncell_z;
+  }
+}
+
+/*===========================================================================*/
+/*---Set the blockings, thread counts and block dims from args, as for
+     Sweeper_create; the only arrays allocated are the block bounds---*/
+/*---pseudo-private member function---*/
+
+static void Sweeper_set_sizes_( Sweeper*          sweeper,
+                                Dimensions        dims,
+                                Bool_t*           is_face_comm_async,
+                                Bool_t*           is_face_comm_shm,
+                                Env*              env,
+                                Arguments*        args )
 {
   /*====================*/
   /*---Declarations---*/
   /*====================*/
 
-  Bool_t is_face_comm_async = Arguments_consume_int_or_default( args,
-                                           "--is_face_comm_async", Bool_true );
+  /*---Virtual blocks along x and y currently exchange faces only
+       synchronously, which is then the default---*/
+
+  sweeper->nblock_x = Arguments_consume_int_or_default( args, "--nblock_x", 1);
+  sweeper->nblock_y = Arguments_consume_int_or_default( args, "--nblock_y", 1);
+
+  *is_face_comm_async = Arguments_consume_int_or_default( args,
+      "--is_face_comm_async", sweeper->nblock_x * sweeper->nblock_y == 1 );
+  *is_face_comm_shm = Arguments_consume_int_or_default( args,
+                                           "--is_face_comm_shm", Bool_false );
+
+  int i = 0;
 
   Insist( dims.ncell_x > 0 ?
                 "Currently required that all spatial blocks be nonempty" : 0 );
@@ -67,13 +138,76 @@ void Sweeper_create( Sweeper*          sweeper,
   /*---Set up number of kba blocks---*/
   /*====================*/
 
+  Insist( Env_nproc_octant( env ) == 1 || ! Env_hip_is_using_device( env ) ?
+                    "Octant groups currently require a host-only run." : 0 );
+
   sweeper->nblock_z = Arguments_consume_int_or_default( args, "--nblock_z", 1);
 
   Insist( sweeper->nblock_z > 0 ? "Invalid z blocking factor supplied" : 0 );
-  Insist( dims.ncell_z % sweeper->nblock_z == 0
-                  ? "Currently require all blocks have same z dimension" : 0 );
+  Insist( dims.ncell_z >= sweeper->nblock_z
+                  ? "Currently require all blocks be nonempty" : 0 );
 
-  const int dims_b_ncell_z = dims.ncell_z / sweeper->nblock_z;
+  /*---Blocks may differ in thickness; block arrays such as faces are
+       sized for the thickest---*/
+
+  sweeper->iz_base_block = (int*) malloc( ( sweeper->nblock_z + 1 ) *
+                                          sizeof( int ) );
+
+  Sweeper_set_iz_base_block_( sweeper, dims.ncell_z,
+    Arguments_consume_int_or_default( args, "--is_block_z_tapered",
+                                                         Bool_false ), env );
+
+  int dims_b_ncell_z = 0;
+  for( i=0; i<sweeper->nblock_z; ++i )
+  {
+    dims_b_ncell_z = imax( dims_b_ncell_z, sweeper->iz_base_block[i+1] -
+                                           sweeper->iz_base_block[i] );
+  }
+
+  /*====================*/
+  /*---Set up virtual blocks along x and y---*/
+  /*====================*/
+
+  /*---The x, y extent of this proc is divided into virtual blocks, which
+       are scheduled like procs of their own in the wavefront---*/
+
+  Insist( sweeper->nblock_x > 0 && sweeper->nblock_y > 0 ?
+                               "Invalid x or y blocking factor supplied" : 0 );
+  Insist( dims.ncell_x >= sweeper->nblock_x &&
+          dims.ncell_y >= sweeper->nblock_y
+                  ? "Currently require all blocks be nonempty" : 0 );
+  Insist( sweeper->nblock_x * sweeper->nblock_y == 1 ||
+          ! Env_hip_is_using_device( env ) ?
+                  "Virtual blocks currently require a host-only run." : 0 );
+
+  sweeper->ix_base_block = (int*) malloc( ( sweeper->nblock_x + 1 ) *
+                                          sizeof( int ) );
+  sweeper->iy_base_block = (int*) malloc( ( sweeper->nblock_y + 1 ) *
+                                          sizeof( int ) );
+
+  for( i=0; i<=sweeper->nblock_x; ++i )
+  {
+    sweeper->ix_base_block[i] = ( i * dims.ncell_x ) / sweeper->nblock_x;
+  }
+  for( i=0; i<=sweeper->nblock_y; ++i )
+  {
+    sweeper->iy_base_block[i] = ( i * dims.ncell_y ) / sweeper->nblock_y;
+  }
+
+  const int ncell_x_vblock_max = iceil( dims.ncell_x, sweeper->nblock_x );
+  const int ncell_y_vblock_max = iceil( dims.ncell_y, sweeper->nblock_y );
+
+  /*====================*/
+  /*---Set up number of angle sets pipelined through the z blocks---*/
+  /*====================*/
+
+  sweeper->nangle_set = Arguments_consume_int_or_default( args,
+                                                         "--nangle_set", 1 );
+
+  Insist( sweeper->nangle_set > 0 && sweeper->nangle_set <= dims.na ?
+                                     "Invalid angle set count supplied" : 0 );
+  Insist( sweeper->nangle_set == 1 || ! Env_hip_is_using_device( env ) ?
+                       "Angle sets currently require a host-only run." : 0 );
 
   /*====================*/
   /*---Set up number of octant threads---*/
@@ -128,12 +262,12 @@ void Sweeper_create( Sweeper*          sweeper,
   /*====================*/
 
   const int ncell_x_per_subblock_default = sweeper->nsemiblock >= 2 ?
-                                           (dims.ncell_x+1) / 2 :
-                                            dims.ncell_x;
+                                           (ncell_x_vblock_max+1) / 2 :
+                                            ncell_x_vblock_max;
 
   const int ncell_y_per_subblock_default = sweeper->nsemiblock >= 4 ?
-                                           (dims.ncell_y+1) / 2 :
-                                            dims.ncell_y;
+                                           (ncell_y_vblock_max+1) / 2 :
+                                            ncell_y_vblock_max;
 
   const int ncell_z_per_subblock_default = sweeper->nsemiblock >= 8 ?
                                            (dims_b_ncell_z+1) / 2 :
@@ -163,10 +297,6 @@ void Sweeper_create( Sweeper*          sweeper,
   sweeper->dims_b = sweeper->dims;
   sweeper->dims_b.ncell_z = dims_b_ncell_z;
 
-  sweeper->dims_g = sweeper->dims;
-  sweeper->dims_g.ncell_x = quan->ncell_x_g;
-  sweeper->dims_g.ncell_y = quan->ncell_y_g;
-
   /*====================*/
   /*---Set up number of energy threads---*/
   /*====================*/
@@ -196,11 +326,11 @@ void Sweeper_create( Sweeper*          sweeper,
     const Bool_t is_semiblocked_z = sweeper->nsemiblock > (1<<2);
 
     const int ncell_x_semiblock_up2 = is_semiblocked_x ?
-                                      ( sweeper->dims_b.ncell_x + 1 ) / 2 :
-                                        sweeper->dims_b.ncell_x;
+                                      ( ncell_x_vblock_max + 1 ) / 2 :
+                                        ncell_x_vblock_max;
     const int ncell_y_semiblock_up2 = is_semiblocked_y ?
-                                      ( sweeper->dims_b.ncell_y + 1 ) / 2 :
-                                        sweeper->dims_b.ncell_y;
+                                      ( ncell_y_vblock_max + 1 ) / 2 :
+                                        ncell_y_vblock_max;
     const int ncell_z_semiblock_up2 = is_semiblocked_z ?
                                       ( sweeper->dims_b.ncell_z + 1 ) / 2 :
                                         sweeper->dims_b.ncell_z;
@@ -242,13 +372,64 @@ void Sweeper_create( Sweeper*          sweeper,
     Insist( sweeper->nthread_z==1 || ! IS_USING_OPENMP_TASKS ?
             "Spatial threading must be defined via subblock sizes." : 0 );
   }
+}
+
+/*===========================================================================*/
+/*---Pseudo-constructor for Sweeper struct---*/
+
+void Sweeper_create( Sweeper*          sweeper,
+                     Dimensions        dims,
+                     const Quantities* quan,
+                     Env*              env,
+                     Arguments*        args )
+{
+  Bool_t is_face_comm_async = Bool_false;
+  Bool_t is_face_comm_shm   = Bool_false;
+
+  Sweeper_set_sizes_( sweeper, dims, &is_face_comm_async, &is_face_comm_shm,
+                      env, args );
+
+  sweeper->time_sweep_block = 0;
+  sweeper->time_idle_saved  = 0;
+  sweeper->time_comm_wait   = 0;
+  sweeper->nstep_active     = 0;
+  sweeper->nstep_inactive   = 0;
+
+  sweeper->request_reduce = (Request_t*) malloc( sweeper->nblock_z *
+                                                 sizeof( Request_t ) );
+
+  sweeper->dims_g = sweeper->dims;
+  sweeper->dims_g.ncell_x = quan->ncell_x_g;
+  sweeper->dims_g.ncell_y = quan->ncell_y_g;
+  sweeper->dims_g.ncell_z = quan->ncell_z_g;
+  sweeper->dims_g.ne      = quan->ne_g;
+
+  /*---If tracing, have buffers ready for all threads of the block sweep---*/
+
+  if( IS_USING_OPENMP_THREADS && ! Env_hip_is_using_device( env ) )
+  {
+    Profiler_trace_reserve( sweeper->nthread_e * sweeper->nthread_octant *
+                            sweeper->nthread_y * sweeper->nthread_z );
+  }
 
   /*====================*/
   /*---Set up step scheduler---*/
   /*====================*/
 
-  StepScheduler_create( &(sweeper->stepscheduler),
-                              sweeper->nblock_z, sweeper->nblock_octant, env );
+  sweeper->is_octant_order_optimized = Arguments_consume_int_or_default(
+                         args, "--is_octant_order_optimized", Bool_true );
+
+  StepScheduler_create( &(sweeper->stepscheduler), sweeper->nblock_z,
+                        sweeper->nangle_set, sweeper->nblock_x,
+                        sweeper->nblock_y, sweeper->nblock_octant,
+                        sweeper->nsemiblock, 1,
+                        sweeper->is_octant_order_optimized, env );
+
+  if( Arguments_consume_int_or_default( args, "--is_dumping_schedule",
+                                                               Bool_false ) )
+  {
+    StepScheduler_dump( &(sweeper->stepscheduler), env );
+  }
 
   /*====================*/
   /*---Set up amu threads---*/
@@ -289,12 +470,23 @@ void Sweeper_create( Sweeper*          sweeper,
                            ( (P*) NULL ) :
                            malloc_host_P( Sweeper_nvolocal_( sweeper, env ) );
 
+  if( ! Env_hip_is_using_device( env ) )
+  {
+    MemTracker_allocate( MEMTRACKER_SCRATCH, sizeof(P) *
+                         ( Sweeper_nvilocal_( sweeper, env ) +
+                           Sweeper_nvslocal_( sweeper, env ) +
+                           Sweeper_nvolocal_( sweeper, env ) ), Bool_false );
+  }
+
   /*====================*/
   /*---Allocate faces---*/
   /*====================*/
 
   Faces_create( &(sweeper->faces), sweeper->dims_b,
-                sweeper->noctant_per_block, is_face_comm_async, env );
+                sweeper->noctant_per_block, sweeper->nangle_set,
+                sweeper->nblock_x, sweeper->nblock_y,
+                sweeper->ix_base_block, sweeper->iy_base_block,
+                is_face_comm_async, is_face_comm_shm, env );
 }
 
 /*===========================================================================*/
@@ -324,19 +516,69 @@ void Sweeper_destroy( Sweeper* sweeper,
     sweeper->vilocal_host_ = NULL;
     sweeper->vslocal_host_ = NULL;
     sweeper->volocal_host_ = NULL;
+
+    MemTracker_free( MEMTRACKER_SCRATCH, sizeof(P) *
+                     ( Sweeper_nvilocal_( sweeper, env ) +
+                       Sweeper_nvslocal_( sweeper, env ) +
+                       Sweeper_nvolocal_( sweeper, env ) ), Bool_false );
   }
 
   /*====================*/
   /*---Deallocate faces---*/
   /*====================*/
 
-  Faces_destroy( &(sweeper->faces) );
+  Faces_destroy( &(sweeper->faces), env );
 
   /*====================*/
   /*---Terminate scheduler---*/
   /*====================*/
 
   StepScheduler_destroy( &( sweeper->stepscheduler ) );
+
+  free( (void*) sweeper->iz_base_block );
+  free( (void*) sweeper->request_reduce );
+  free( (void*) sweeper->ix_base_block );
+  free( (void*) sweeper->iy_base_block );
+  sweeper->iz_base_block = NULL;
+  sweeper->request_reduce = NULL;
+  sweeper->ix_base_block = NULL;
+  sweeper->iy_base_block = NULL;
+}
+
+/*===========================================================================*/
+/*---Bytes of the arrays a sweeper would allocate, added by memory tracker
+     category, and of the buffers made at each step---*/
+
+void Sweeper_predict_memory( size_t*     nbyte,
+                             size_t*     nbyte_device,
+                             size_t*     nbyte_step,
+                             Dimensions  dims,
+                             Env*        env,
+                             Arguments*  args )
+{
+  Sweeper sweeper = Sweeper_null();
+  Bool_t is_face_comm_async = Bool_false;
+  Bool_t is_face_comm_shm   = Bool_false;
+
+  Sweeper_set_sizes_( &sweeper, dims, &is_face_comm_async, &is_face_comm_shm,
+                      env, args );
+
+  if( ! Env_hip_is_using_device( env ) )
+  {
+    nbyte[MEMTRACKER_SCRATCH] += sizeof(P) *
+                             ( Sweeper_nvilocal_( &sweeper, env ) +
+                               Sweeper_nvslocal_( &sweeper, env ) +
+                               Sweeper_nvolocal_( &sweeper, env ) );
+  }
+
+  Faces_predict_memory( nbyte, nbyte_device, nbyte_step, sweeper.dims_b,
+                        sweeper.noctant_per_block, sweeper.nangle_set,
+                        sweeper.nblock_x, sweeper.nblock_y,
+                        is_face_comm_async, is_face_comm_shm, env );
+
+  free( (void*) sweeper.iz_base_block );
+  free( (void*) sweeper.ix_base_block );
+  free( (void*) sweeper.iy_base_block );
 }
 
 /*===========================================================================*/
@@ -361,6 +603,7 @@ SweeperLite Sweeper_sweeperlite( Sweeper* sweeper )
   sweeperlite.nthread_z      = sweeper->nthread_z;
 
   sweeperlite.nblock_z             = sweeper->nblock_z;
+  sweeperlite.nangle_set           = sweeper->nangle_set;
   sweeperlite.nblock_octant        = sweeper->nblock_octant;
   sweeperlite.noctant_per_block    = sweeper->noctant_per_block;
   sweeperlite.nsemiblock           = sweeper->nsemiblock;
@@ -483,6 +726,8 @@ static void Sweeper_sweep_block_adapter(
   {
 #endif
 
+    Counters_begin( COUNTERS_REGION_BLOCK );
+
     Sweeper_sweep_block_impl( sweeperlite,
                               vo,
                               vi,
@@ -500,6 +745,8 @@ static void Sweeper_sweep_block_adapter(
                               stepinfoall,
                               do_block_init );
 
+    Counters_end( COUNTERS_REGION_BLOCK );
+
 #ifdef USE_OPENMP_THREADS
   } /*---OPENMP---*/
 #endif
@@ -507,19 +754,19 @@ static void Sweeper_sweep_block_adapter(
 }
 
 /*===========================================================================*/
-/*---Perform a sweep for a block---*/
+/*---Perform a sweep for a virtual block---*/
 
 void Sweeper_sweep_block(
   Sweeper*               sweeper,
   Pointer*               vo,
   Pointer*               vi,
-  int*                   is_block_init,
   Pointer*               facexy,
   Pointer*               facexz,
   Pointer*               faceyz,
   const Pointer*         a_from_m,
   const Pointer*         m_from_a,
   int                    step,
+  int                    vblock,
   const Quantities*      quan,
   Env*                   env )
 {
@@ -528,88 +775,65 @@ void Sweeper_sweep_block(
   const int proc_x = Env_proc_x_this( env );
   const int proc_y = Env_proc_y_this( env );
 
-  const int noctant_per_block = sweeper->noctant_per_block;
+  const int block_x = vblock % sweeper->nblock_x;
+  const int block_y = vblock / sweeper->nblock_x;
 
   StepInfoAll stepinfoall;  /*---But only use noctant_per_block values---*/
 
   int octant_in_block = 0;
 
-  int semiblock_step = 0;
+  Bool_t is_active = Bool_false;
 
   unsigned long int do_block_init = 0;
 
-  /*---Precalculate stepinfo for required octants---*/
+  /*---Look up stepinfo for required octants---*/
 
   for( octant_in_block=0; octant_in_block<sweeper->noctant_per_block;
                                                             ++octant_in_block )
   {
-    stepinfoall.stepinfo[octant_in_block] = StepScheduler_stepinfo(
-      &(sweeper->stepscheduler), step, octant_in_block, proc_x, proc_y );
-
+    StepInfo* const stepinfo = &stepinfoall.stepinfo[octant_in_block];
+
+    *stepinfo = StepScheduler_stepinfo_this( &(sweeper->stepscheduler),
+                                             step, vblock, octant_in_block );
+
+    stepinfo->iz_base = sweeper->iz_base_block[ stepinfo->block_z ];
+    stepinfo->ncell_z = sweeper->iz_base_block[ stepinfo->block_z + 1 ]
+                      - stepinfo->iz_base;
+    stepinfo->ix_base = sweeper->ix_base_block[ block_x ];
+    stepinfo->ncell_x = sweeper->ix_base_block[ block_x + 1 ]
+                      - stepinfo->ix_base;
+    stepinfo->iy_base = sweeper->iy_base_block[ block_y ];
+    stepinfo->ncell_y = sweeper->iy_base_block[ block_y + 1 ]
+                      - stepinfo->iy_base;
+
+    is_active = is_active || stepinfo->is_active;
   }
 
-  /*---Precalculate initialization schedule---*/
-  /*---Determine whether this is the first calculation for this sweep step
-       and semiblock step - in which case set values rather than add values---*/
+  /*---Skip a virtual block idle at this step---*/
 
-  for( semiblock_step=0; semiblock_step<sweeper->nsemiblock; ++semiblock_step )
+  if( ! is_active && StepScheduler_nvblock( &(sweeper->stepscheduler) ) > 1 )
   {
-#pragma novector
-    for( octant_in_block=0; octant_in_block<sweeper->noctant_per_block;
-                                                            ++octant_in_block )
-    {
-      const StepInfo stepinfo = stepinfoall.stepinfo[octant_in_block];
-      if( stepinfo.is_active )
-      {
-        const Bool_t is_semiblock_x_lo = is_semiblock_min_when_semiblocked(
-            sweeper->nsemiblock, semiblock_step,
-            DIM_X, Dir_x( stepinfo.octant ) );
-        const Bool_t is_semiblock_min_x = is_semiblock_x_lo ||
-                             ! is_axis_semiblocked(sweeper->nsemiblock, DIM_X);
-
-
-        const Bool_t is_semiblock_y_lo = is_semiblock_min_when_semiblocked(
-            sweeper->nsemiblock, semiblock_step,
-            DIM_Y, Dir_y( stepinfo.octant ) );
-        const Bool_t is_semiblock_min_y = is_semiblock_y_lo ||
-                             ! is_axis_semiblocked(sweeper->nsemiblock, DIM_Y);
-
-
-        const Bool_t is_semiblock_z_lo = is_semiblock_min_when_semiblocked(
-            sweeper->nsemiblock, semiblock_step,
-            DIM_Z, Dir_z( stepinfo.octant ) );
-        const Bool_t is_semiblock_min_z = is_semiblock_z_lo ||
-                             ! is_axis_semiblocked(sweeper->nsemiblock, DIM_Z);
-
-        /*---Which semiblock is being processed, according to a uniform
-             direction-independent numbering scheme---*/
+    return;
+  }
 
-        const int semiblock_num = ( is_semiblock_min_x ? 0 : 1 ) + 2 * (
-                                  ( is_semiblock_min_y ? 0 : 1 ) + 2 * (
-                                  ( is_semiblock_min_z ? 0 : 1 ) ));
+  /*---Look up initialization schedule---*/
 
-        /*---Update the running tally of whether this semiblock of this
-             block has been initialized yet---*/
+  do_block_init = StepScheduler_do_block_init( &(sweeper->stepscheduler),
+                                               step, vblock );
 
-        if( ! ( is_block_init[ stepinfo.block_z ] & ( 1 << semiblock_num ) ) )
-        {
-          do_block_init |= ( ((unsigned long int)1) <<
-                             ( octant_in_block + noctant_per_block *
-                               semiblock_step ) );
-          is_block_init[ stepinfo.block_z ] |= ( 1 << semiblock_num );
-        }
-      }
-    } /*---octant_in_block---*/
-  } /*---semiblock---*/
-
-  /*---Call kernel adapter---*/
+  /*---Call kernel adapter; the xz and yz faces are held once per virtual
+       block along y and x respectively---*/
 
   Sweeper_sweep_block_adapter( sweeper,
                                Pointer_active( vo ),
                                Pointer_active( vi ),
                                Pointer_active( facexy ),
-                               Pointer_active( facexz ),
-                               Pointer_active( faceyz ),
+                               Pointer_active( facexz ) + block_y *
+                                 Dimensions_size_facexz( sweeper->dims_b, NU,
+                                                 sweeper->noctant_per_block ),
+                               Pointer_active( faceyz ) + block_x *
+                                 Dimensions_size_faceyz( sweeper->dims_b, NU,
+                                                 sweeper->noctant_per_block ),
                                Pointer_const_active( a_from_m ),
                                Pointer_const_active( m_from_a ),
                                step,
@@ -623,6 +847,27 @@ void Sweeper_sweep_block(
                                env);
 }
 
+/*===========================================================================*/
+/*---Rebuild the step schedule for a number of pipelined iterations---*/
+
+void Sweeper_set_niteration( Sweeper* sweeper,
+                             int      niteration,
+                             Env*     env )
+{
+  if( StepScheduler_niteration( &(sweeper->stepscheduler) ) == niteration )
+  {
+    return;
+  }
+
+  StepScheduler_destroy( &(sweeper->stepscheduler) );
+
+  StepScheduler_create( &(sweeper->stepscheduler), sweeper->nblock_z,
+                        sweeper->nangle_set, sweeper->nblock_x,
+                        sweeper->nblock_y, sweeper->nblock_octant,
+                        sweeper->nsemiblock, niteration,
+                        sweeper->is_octant_order_optimized, env );
+}
+
 /*===========================================================================*/
 /*---Perform a sweep---*/
 
@@ -632,29 +877,73 @@ void Sweeper_sweep(
   Pointer*               vi,
   const Quantities*      quan,
   Env*                   env )
+{
+  Sweeper_sweep_iterations( sweeper, vo, vi, 1, quan, env );
+}
+
+/*===========================================================================*/
+/*---Perform several sweep iterations as one pipeline, alternating vi/vo---*/
+
+void Sweeper_sweep_iterations(
+  Sweeper*               sweeper,
+  Pointer*               vo,
+  Pointer*               vi,
+  int                    niterations,
+  const Quantities*      quan,
+  Env*                   env )
 {
   Assert( sweeper );
   Assert( vi );
   Assert( vo );
+  Assert( niterations > 0 );
+
+  /*---Iteration k+1 starts on a proc once iteration k has finished there,
+       and so has completed the part of its result read by k+1.  With
+       octants threaded or summed across proc groups, or with device
+       block transfers, this is not the case---*/
+
+  Insist( niterations == 1 || ( sweeper->noctant_per_block == 1 &&
+                                Env_nproc_octant( env ) == 1 &&
+                                ! IS_USING_OPENMP_VO_ATOMIC &&
+                                ! Env_hip_is_using_device( env ) ) ?
+          "Pipelined iterations require one octant per block, nproc_octant 1"
+          " and a host-only run." : 0 );
+
+  /*---Callers timing the sweep set the iteration count beforehand, so
+       that the schedule is not rebuilt here---*/
+
+  Sweeper_set_niteration( sweeper, niterations, env );
+
+  const Timer time_begin = Env_get_time( env );
+
+  Profiler_begin( SWEEP );
+  Counters_begin( COUNTERS_REGION_SWEEP );
 
   /*---Declarations---*/
 
   const int nblock_z = sweeper->nblock_z;
 
   const int nstep = StepScheduler_nstep( &(sweeper->stepscheduler) );
+  const int nvblock = StepScheduler_nvblock( &(sweeper->stepscheduler) );
   int step = -1;
+  int vblock = 0;
 
-  const size_t size_state_block = Dimensions_size_state( sweeper->dims, NU )
-                                                                   / nblock_z;
+  /*---Blocks of the state vector are contiguous ranges of z planes---*/
 
-  Bool_t* is_block_init = (Bool_t*) malloc( nblock_z * sizeof( Bool_t ) );
+  const size_t size_state_plane = Dimensions_size_state( sweeper->dims, NU )
+                                                       / sweeper->dims.ncell_z;
+  const int* const iz_base_block = sweeper->iz_base_block;
 
   int i = 0;
 
-  for( i=0; i<nblock_z; ++i )
-  {
-    is_block_init[i] = 0;
-  }
+  /*---With octant groups, each group sweeps only some octants; the z blocks
+       of vo are summed across groups in block order, each as soon as
+       this proc has finished with it---*/
+
+  const Bool_t is_octant_reduce = Env_nproc_octant( env ) > 1;
+
+  Request_t* const request_reduce = sweeper->request_reduce;
+  int block_reduce_next = 0;
 
   /*---Initialize result array to zero if needed---*/
 
@@ -671,6 +960,8 @@ void Sweeper_sweep(
 
   for( step=0-1; step<nstep+1; ++step )
   {
+    Profiler_begin( STEP );
+
     const Bool_t is_sweep_step = step>=0 && step<nstep;
 
     /*---Pointers to single active block of state vector---*/
@@ -711,8 +1002,12 @@ void Sweeper_sweep(
 
     if( is_sweep_step &&  Faces_is_face_comm_async( &(sweeper->faces)) )
     {
+      const Timer t1 = Env_get_time( env );
+      Profiler_begin( FACE_RECV_WAIT );
       Faces_recv_faces_end( &(sweeper->faces), &(sweeper->stepscheduler),
                             sweeper->dims_b, step-1, env );
+      Profiler_end( FACE_RECV_WAIT );
+      sweeper->time_comm_wait += Env_get_time( env ) - t1;
     }
 
     /*====================*/
@@ -722,7 +1017,8 @@ void Sweeper_sweep(
 
     if( is_sweep_step )
     {
-      if( step == 0 )
+      /*---xy faces change between steps only if communicated along z---*/
+      if( step == 0 || Env_nproc_z( env ) > 1 )
       {
         Pointer_update_d_stream( facexy, Env_hip_stream_kernel_faces( env ) );
       }
@@ -747,16 +1043,68 @@ void Sweeper_sweep(
 
     if( is_sweep_step )
     {
-      Sweeper_sweep_block( sweeper, vo, vi, is_block_init,
-                           facexy, facexz, faceyz,
-                           & quan->a_from_m, & quan->m_from_a,
-                           step, quan, env );
+      /*---Count the step as active if any block has work on this proc---*/
+
+      Bool_t is_step_active = Bool_false;
+      for( vblock=0; vblock<nvblock; ++vblock )
+      {
+        int octant_in_block = 0;
+        for( octant_in_block=0; octant_in_block<sweeper->noctant_per_block;
+                                                            ++octant_in_block )
+        {
+          const StepInfo stepinfo = StepScheduler_stepinfo_this(
+                 &(sweeper->stepscheduler), step, vblock, octant_in_block );
+          is_step_active = is_step_active || stepinfo.is_active;
+        }
+      }
+      sweeper->nstep_active   += is_step_active ? 1 : 0;
+      sweeper->nstep_inactive += is_step_active ? 0 : 1;
+
+      const Timer t1 = Env_get_time( env );
+      Profiler_begin( BLOCK_COMPUTE );
+
+      /*---The virtual blocks active at a step are independent---*/
+
+      for( vblock=0; vblock<nvblock; ++vblock )
+      {
+        /*---Iterations alternate between reading vi, writing vo and the
+             reverse---*/
+        const int iteration = StepScheduler_stepinfo_this(
+                   &(sweeper->stepscheduler), step, vblock, 0 ).iteration;
+
+        Sweeper_sweep_block( sweeper, iteration % 2 == 0 ? vo : vi,
+                                      iteration % 2 == 0 ? vi : vo,
+                             facexy, facexz, faceyz,
+                             & quan->a_from_m, & quan->m_from_a,
+                             step, vblock, quan, env );
+      }
+      Profiler_end( BLOCK_COMPUTE );
+      sweeper->time_sweep_block += Env_get_time( env ) - t1;
+    }
+
+    /*====================*/
+    /*---Sum finished vo blocks across octant groups START---*/
+    /*====================*/
+
+    while( is_sweep_step && is_octant_reduce &&
+           block_reduce_next < nblock_z &&
+           StepScheduler_step_block_final( &(sweeper->stepscheduler),
+                                           block_reduce_next ) <= step )
+    {
+      Env_octant_asum_P( env,
+        Pointer_h( vo ) + size_state_plane * iz_base_block[block_reduce_next],
+        size_state_plane * ( iz_base_block[ block_reduce_next + 1 ] -
+                             iz_base_block[ block_reduce_next ] ),
+        &request_reduce[ block_reduce_next ] );
+      ++block_reduce_next;
     }
 
     /*====================*/
     /*---Send block to device START (i+1)---*/
     /*====================*/
 
+    Profiler_begin( BLOCK_TRANSFER );
+
     for( i=0; i<2; ++i )
     {
       /*---Determine blocks needing transfer, counting from top/bottom z---*/
@@ -771,17 +1119,21 @@ void Sweeper_sweep(
       Assert( nstep >= nblock_z );  /*---Sanity check---*/
       if( do_block_send[i] )
       {
-        Pointer_create_alias(    &vi_b, vi, size_state_block * block_to_send[i],
-                                            size_state_block );
+        const int iz_base = iz_base_block[ block_to_send[i] ];
+        Dimensions dims_block = sweeper->dims;
+        dims_block.ncell_z = iz_base_block[ block_to_send[i] + 1 ] - iz_base;
+
+        Pointer_create_alias(    &vi_b, vi, size_state_plane * iz_base,
+                                   size_state_plane * dims_block.ncell_z );
         Pointer_update_d_stream( &vi_b, Env_hip_stream_send_block( env ) );
         Pointer_destroy(         &vi_b );
 
         /*---Initialize result array to zero if needed---*/
         /*---NOTE: this is not performance-optimal---*/
 #ifdef USE_OPENMP_VO_ATOMIC
-        Pointer_create_alias(    &vo_b, vi, size_state_block * block_to_send[i],
-                                          size_state_block );
-        initialize_state_zero( Pointer_h( &vo_b ), sweeper->dims, NU );
+        Pointer_create_alias(    &vo_b, vi, size_state_plane * iz_base,
+                                   size_state_plane * dims_block.ncell_z );
+        initialize_state_zero( Pointer_h( &vo_b ), dims_block, NU );
         Pointer_update_d_stream( &vo_b, Env_hip_stream_send_block( env ) );
         Pointer_destroy(         &vo_b );
 #endif
@@ -806,8 +1158,11 @@ void Sweeper_sweep(
       Assert( nstep >= nblock_z );  /*---Sanity check---*/
       if( do_block_recv[i] )
       {
-        Pointer_create_alias(    &vo_b, vo, size_state_block * block_to_recv[i],
-                                            size_state_block );
+        const int iz_base = iz_base_block[ block_to_recv[i] ];
+        const int ncell_z = iz_base_block[ block_to_recv[i] + 1 ] - iz_base;
+
+        Pointer_create_alias(    &vo_b, vo, size_state_plane * iz_base,
+                                            size_state_plane * ncell_z );
         Pointer_update_h_stream( &vo_b, Env_hip_stream_recv_block( env ) );
         Pointer_destroy(         &vo_b );
       }
@@ -821,14 +1176,20 @@ void Sweeper_sweep(
     Env_hip_stream_wait( env, Env_hip_stream_send_block( env ) );
     Env_hip_stream_wait( env, Env_hip_stream_recv_block( env ) );
 
+    Profiler_end( BLOCK_TRANSFER );
+
     /*====================*/
     /*---Send face via MPI WAIT (i-1)---*/
     /*====================*/
 
     if( is_sweep_step && Faces_is_face_comm_async( &(sweeper->faces)) )
     {
+      const Timer t1 = Env_get_time( env );
+      Profiler_begin( FACE_SEND_WAIT );
       Faces_send_faces_end( &(sweeper->faces), &(sweeper->stepscheduler),
                             sweeper->dims_b, step-1, env );
+      Profiler_end( FACE_SEND_WAIT );
+      sweeper->time_comm_wait += Env_get_time( env ) - t1;
     }
 
     /*====================*/
@@ -844,7 +1205,7 @@ void Sweeper_sweep(
 
     if( is_sweep_step )
     {
-      if( step == nstep-1 )
+      if( step == nstep-1 || Env_nproc_z( env ) > 1 )
       {
         Pointer_update_h_stream( facexy, Env_hip_stream_kernel_faces( env ) );
       }
@@ -869,19 +1230,45 @@ void Sweeper_sweep(
 
     if( is_sweep_step && ! Faces_is_face_comm_async( &(sweeper->faces)) )
     {
+      const Timer t1 = Env_get_time( env );
+      Profiler_begin( FACE_COMM );
       Faces_communicate_faces( &(sweeper->faces), &(sweeper->stepscheduler),
                             sweeper->dims_b, step, env );
+      Profiler_end( FACE_COMM );
+      sweeper->time_comm_wait += Env_get_time( env ) - t1;
     }
 
+    Profiler_end_arg( STEP, step );
+
   } /*---step---*/
 
   /*---Increment message tag---*/
 
-  Env_increment_tag( env, sweeper->noctant_per_block );
+  Env_increment_tag( env, sweeper->noctant_per_block * nvblock );
+
+  /*---Sum finished vo blocks across octant groups WAIT---*/
+
+  Assert( block_reduce_next == ( is_octant_reduce ? nblock_z : 0 ) );
+  if( is_octant_reduce )
+  {
+    const Timer t1 = Env_get_time( env );
+    Profiler_begin( OCTANT_REDUCE );
+    for( i=0; i<block_reduce_next; ++i )
+    {
+      Env_wait( env, &request_reduce[i] );
+    }
+    Profiler_end( OCTANT_REDUCE );
+    sweeper->time_comm_wait += Env_get_time( env ) - t1;
+  }
+
+  /*---Estimate idle time recovered, from the mean time of a step---*/
 
-  /*---Finish---*/
+  sweeper->time_idle_saved += nstep == 0 ? 0 :
+    ( ( Env_get_time( env ) - time_begin ) / nstep ) *
+    StepScheduler_nstep_saved( &(sweeper->stepscheduler) );
 
-  free( (void*) is_block_init );
+  Counters_end( COUNTERS_REGION_SWEEP );
+  Profiler_end( SWEEP );
 
 } /*---sweep---*/
 
@@ -13,6 +13,7 @@
 
 #include "types_kernels.h"
 #include "env_kernels.h"
+#include "profiler_kernels.h"
 #include "definitions_kernels.h"
 #include "quantities_kernels.h"
 #include "array_accessors_kernels.h"
@@ -43,6 +44,8 @@ TARGET_HD static inline void Sweeper_sweep_cell(
   const int                      octant,
   const int                      iz_base,
   const int                      octant_in_block,
+  const int                      ia_min,
+  const int                      ia_max,
   const int                      ie,
   const int                      ix,
   const int                      iy,
@@ -70,7 +73,7 @@ TARGET_HD static inline void Sweeper_sweep_cell(
   /*---Master loop over angle blocks---*/
   /*====================*/
 
-  for( ia_base=0; ia_base<sweeper->dims_b.na; ia_base += NTHREAD_A )
+  for( ia_base=ia_min; ia_base<ia_max; ia_base += NTHREAD_A )
   {
     int im_base = 0;
 
@@ -116,7 +119,7 @@ TODO: fix vectorization for this loop.
           if( ( NM % NTHREAD_M == 0 || im < NM ) &&
               is_elt_active )
           {
-            if( ia_base == 0 ||
+            if( ia_base == ia_min ||
                 NM*1 > NTHREAD_M*1 )
             {
               int iu_base = 0;
@@ -177,7 +180,7 @@ TODO: fix vectorization for this loop.
 #endif
         {
           const int ia = ia_base + sweeper_thread_a;
-          if( ia < sweeper->dims_b.na && is_elt_active )
+          if( ia < ia_max && is_elt_active )
           {
             int im_in_block = 0;
             int iu = 0;
@@ -270,11 +273,12 @@ TODO: fix vectorization for this loop.
                         ia, sweeper_thread_a, NTHREAD_A,
                         facexy, facexz, faceyz,
                         ix, iy, iz, ie,
-                        ix+quan->ix_base, iy+quan->iy_base, iz+iz_base,
+                        ix+quan->ix_base, iy+quan->iy_base,
+                        iz+iz_base+quan->iz_base,
                         octant, octant_in_block,
                         sweeper->noctant_per_block,
                         sweeper->dims_b, sweeper->dims_g,
-                        is_elt_active );
+                        is_elt_active && ia < ia_max );
     }
 
     /*====================*/
@@ -338,7 +342,7 @@ TODO: fix vectorization for this loop.
             /*---TODO: set up logic here to run fast for all cases---*/
 
 #ifdef __MIC__
-            if( ia_base + NTHREAD_A == sweeper->dims_b.na )
+            if( ia_base + NTHREAD_A == ia_max )
 #else
             if( Bool_false )
 #endif
@@ -391,7 +395,7 @@ TODO: fix vectorization for this loop.
               for( ia_in_block=0; ia_in_block<NTHREAD_A; ++ia_in_block )
               {
                 const int ia = ia_base + ia_in_block;
-                const Bool_t mask = ia < sweeper->dims_b.na;
+                const Bool_t mask = ia < ia_max;
 
                 const P m_from_a_this = mask ? m_from_a[
                                     ind_m_from_a_flat( sweeper->dims_b.nm,
@@ -427,7 +431,7 @@ TODO: fix vectorization for this loop.
             /*---Store/update to shared memory---*/
             /*--------------------*/
 
-            if( ia_base == 0 ||
+            if( ia_base == ia_min ||
                 NM*1 > NTHREAD_M*1 )
             {
 #pragma unroll
@@ -469,7 +473,7 @@ TODO: fix vectorization for this loop.
           if( ( (NM*1) % (NTHREAD_M*1) == 0 || im < NM*1 ) &&
               is_elt_active )
           {
-            if( ia_base+NTHREAD_A >= sweeper->dims_b.na ||
+            if( ia_base+NTHREAD_A >= ia_max ||
                 NM*1 > NTHREAD_M*1 )
             {
               int iu_base = 0;
@@ -490,7 +494,7 @@ TODO: fix vectorization for this loop.
               }
 #else /*---USE_OPENMP_VO_ATOMIC---*/
               if( ( ! do_block_init_this ) ||
-                  ( NM*1 > NTHREAD_M*1 && ! ( ia_base==0 ) ) )
+                  ( NM*1 > NTHREAD_M*1 && ! ( ia_base==ia_min ) ) )
               {
 #pragma unroll
                 for( iu_base=0; iu_base<NU; iu_base += NTHREAD_U )
@@ -572,7 +576,12 @@ TARGET_HD static inline void Sweeper_sweep_subblock(
   const Quantities* RESTRICT     quan,
   const int                      octant,
   const int                      iz_base,
+  const int                      ncell_z_block,
+  const int                      ixmax_block,
+  const int                      iymax_block,
   const int                      octant_in_block,
+  const int                      ia_min,
+  const int                      ia_max,
   const int                      ixmin_subblock,
   const int                      ixmax_subblock,
   const int                      iymin_subblock,
@@ -620,6 +629,8 @@ TARGET_HD static inline void Sweeper_sweep_subblock(
   /*---First perform any required boundary initializations---*/
   /*--------------------*/
 
+  Profiler_begin( BOUNDARY_INIT );
+
   /*--------------------*/
   /*---Loop over energy groups owned by this energy thread---*/
   /*--------------------*/
@@ -637,9 +648,9 @@ TARGET_HD static inline void Sweeper_sweep_subblock(
     for( ix=ixbeg; ix!=ixend+dir_inc_x; ix+=dir_inc_x )
     {
       /*---Truncate loop region to block, semiblock and subblock---*/
-      const Bool_t is_elt_active = ix <  sweeper->dims_b.ncell_x &&
-                                   iy <  sweeper->dims_b.ncell_y &&
-                                   iz <  sweeper->dims_b.ncell_z &&
+      const Bool_t is_elt_active = ix <= ixmax_block &&
+                                   iy <= iymax_block &&
+                                   iz <  ncell_z_block &&
                                    ix <= ixmax_semiblock &&
                                    iy <= iymax_semiblock &&
                                    iz <= izmax_semiblock &&
@@ -664,7 +675,7 @@ TARGET_HD static inline void Sweeper_sweep_subblock(
         /*---Set boundary condition if needed: xy---*/
         /*--------------------*/
 
-        const int iz_g = iz + iz_base;
+        const int iz_g = iz + iz_base + quan->iz_base;
         if( ( iz_g == 0                         && dir_z == DIR_UP ) ||
             ( iz_g == sweeper->dims_g.ncell_z-1 && dir_z == DIR_DN ) )
         {
@@ -675,13 +686,13 @@ TARGET_HD static inline void Sweeper_sweep_subblock(
           for( iu=0; iu<NU; ++iu )
           {
             int ia = 0;
-          for( ia=0; ia<sweeper->dims_b.na; ++ia )
+          for( ia=ia_min; ia<ia_max; ++ia )
           {
             *ref_facexy( facexy, sweeper->dims_b, NU,  
                          sweeper->noctant_per_block,
                          ix, iy, ie, ia, iu, octant_in_block )     
                = Quantities_init_facexy( quan, ix_g, iy_g, iz_g-dir_inc_z,
-                                         ie, ia, iu, octant, sweeper->dims_g );
+                             ie+quan->ie_base, ia, iu, octant, sweeper->dims_g );
           }
           }
         }
@@ -695,19 +706,19 @@ TARGET_HD static inline void Sweeper_sweep_subblock(
             ( iy_g == sweeper->dims_g.ncell_y-1 && dir_y == DIR_DN ) )
         {
           const int ix_g = ix + quan->ix_base;
-          const int iz_g = iz +       iz_base;
+          const int iz_g = iz +       iz_base + quan->iz_base;
           /*---TODO: thread/vectorize in u, a---*/
           int iu = 0;
           for( iu=0; iu<NU; ++iu )
           {
             int ia = 0;
-          for( ia=0; ia<sweeper->dims_b.na; ++ia )
+          for( ia=ia_min; ia<ia_max; ++ia )
           {
             *ref_facexz( facexz, sweeper->dims_b, NU,  
                          sweeper->noctant_per_block,
                          ix, iz, ie, ia, iu, octant_in_block )     
                = Quantities_init_facexz( quan, ix_g, iy_g-dir_inc_y, iz_g,
-                                         ie, ia, iu, octant, sweeper->dims_g );
+                             ie+quan->ie_base, ia, iu, octant, sweeper->dims_g );
           }
           }
         }
@@ -721,19 +732,19 @@ TARGET_HD static inline void Sweeper_sweep_subblock(
             ( ix_g == sweeper->dims_g.ncell_x-1 && dir_x == DIR_DN ) )
         {
           const int iy_g = iy + quan->iy_base;
-          const int iz_g = iz +       iz_base;
+          const int iz_g = iz +       iz_base + quan->iz_base;
           /*---TODO: thread/vectorize in u, a---*/
           int iu = 0;
           for( iu=0; iu<NU; ++iu )
           {
             int ia = 0;
-          for( ia=0; ia<sweeper->dims_b.na; ++ia )
+          for( ia=ia_min; ia<ia_max; ++ia )
           {
             *ref_faceyz( faceyz, sweeper->dims_b, NU,  
                          sweeper->noctant_per_block,
                          iy, iz, ie, ia, iu, octant_in_block )     
                = Quantities_init_faceyz( quan, ix_g-dir_inc_x, iy_g, iz_g,
-                                         ie, ia, iu, octant, sweeper->dims_g );
+                             ie+quan->ie_base, ia, iu, octant, sweeper->dims_g );
           }
           }
         }
@@ -746,6 +757,8 @@ TARGET_HD static inline void Sweeper_sweep_subblock(
 
   } /*---ie---*/
 
+  Profiler_end( BOUNDARY_INIT );
+
   /*--------------------*/
   /*---Now perform actual sweep--*/
   /*--------------------*/
@@ -767,9 +780,9 @@ TARGET_HD static inline void Sweeper_sweep_subblock(
     for( ix=ixbeg; ix!=ixend+dir_inc_x; ix+=dir_inc_x )
     {
       /*---Truncate loop region to block, semiblock and subblock---*/
-      const Bool_t is_elt_active = ix <  sweeper->dims_b.ncell_x &&
-                                   iy <  sweeper->dims_b.ncell_y &&
-                                   iz <  sweeper->dims_b.ncell_z &&
+      const Bool_t is_elt_active = ix <= ixmax_block &&
+                                   iy <= iymax_block &&
+                                   iz <  ncell_z_block &&
                                    ix <= ixmax_semiblock &&
                                    iy <= iymax_semiblock &&
                                    iz <= izmax_semiblock &&
@@ -793,7 +806,8 @@ TARGET_HD static inline void Sweeper_sweep_subblock(
       /*--------------------*/
       Sweeper_sweep_cell( sweeper, vo_this, vi_this, vilocal, vslocal, volocal,
                           facexy, facexz, faceyz, a_from_m, m_from_a, quan,
-                          octant, iz_base, octant_in_block, ie, ix, iy, iz,
+                          octant, iz_base, octant_in_block, ia_min, ia_max,
+                          ie, ix, iy, iz,
                           do_block_init_this,
                           is_elt_active );
     }
@@ -829,7 +843,20 @@ TARGET_HD static inline void Sweeper_sweep_semiblock(
   /*---Calculate needed quantities---*/
 
   const int octant  = stepinfo.octant;
-  const int iz_base = stepinfo.block_z * sweeper->dims_b.ncell_z;
+  const int iz_base = stepinfo.iz_base;
+
+  /*---Cells along x, y are numbered across the virtual blocks of the proc,
+       cells along z within the z block---*/
+
+  const int ixmax_block = stepinfo.ix_base + stepinfo.ncell_x - 1;
+  const int iymax_block = stepinfo.iy_base + stepinfo.ncell_y - 1;
+
+  /*---Angles of the angle set swept on this step---*/
+
+  const int ia_min = StepInfo_ia_min( stepinfo, sweeper->dims_b.na,
+                                                sweeper->nangle_set );
+  const int ia_max = StepInfo_ia_max( stepinfo, sweeper->dims_b.na,
+                                                sweeper->nangle_set );
 
   P* RESTRICT     vilocal = Sweeper_vilocal_this_( sweeper );
   P* RESTRICT     vslocal = Sweeper_vslocal_this_( sweeper );
@@ -872,7 +899,13 @@ TARGET_HD static inline void Sweeper_sweep_semiblock(
                                              Sweeper_thread_z( sweeper ) :
                            nsubblock_z - 1 - Sweeper_thread_z( sweeper );
 
-    const Bool_t is_subblock_active = Bool_true;
+    /*---Virtual blocks narrower than the widest have fewer subblocks
+         than tasks---*/
+
+    const Bool_t is_subblock_active =
+          subblock_x >= 0 && subblock_x < nsubblock_x &&
+          subblock_y >= 0 && subblock_y < nsubblock_y &&
+          subblock_z >= 0 && subblock_z < nsubblock_z;
 
     /*---Compute subblock bounds, inclusive of endpoints---*/
 
@@ -893,10 +926,14 @@ TARGET_HD static inline void Sweeper_sweep_semiblock(
     /*---Perform sweep on subblock---*/
     /*--------------------*/
 
+    Profiler_begin( SUBBLOCK );
+
     Sweeper_sweep_subblock( sweeper, vo_this, vi_this,
                             vilocal, vslocal, volocal,
                             facexy, facexz, faceyz, a_from_m, m_from_a, quan,
-                            octant, iz_base, octant_in_block,
+                            octant, iz_base, stepinfo.ncell_z,
+                            ixmax_block, iymax_block, octant_in_block,
+                            ia_min, ia_max,
                             ixmin_subblock, ixmax_subblock,
                             iymin_subblock, iymax_subblock,
                             izmin_subblock, izmax_subblock,
@@ -908,6 +945,8 @@ TARGET_HD static inline void Sweeper_sweep_semiblock(
                             dir_inc_x, dir_inc_y, dir_inc_z,
                             do_block_init_this,
                             is_octant_active );
+
+    Profiler_end( SUBBLOCK );
   }
   else /*---if tasking---*/
   {
@@ -1011,10 +1050,13 @@ TARGET_HD static inline void Sweeper_sweep_semiblock(
       /*--------------------*/
       /*---Perform sweep on subblock---*/
       /*--------------------*/
+      Profiler_begin( SUBBLOCK );
       Sweeper_sweep_subblock( sweeper, vo_this, vi_this,
                               vilocal, vslocal, volocal,
                               facexy, facexz, faceyz, a_from_m, m_from_a, quan,
-                              octant, iz_base, octant_in_block,
+                              octant, iz_base, stepinfo.ncell_z,
+                              ixmax_block, iymax_block,
+                              octant_in_block, ia_min, ia_max,
                               ixmin_subblock, ixmax_subblock,
                               iymin_subblock, iymax_subblock,
                               izmin_subblock, izmax_subblock,
@@ -1026,6 +1068,7 @@ TARGET_HD static inline void Sweeper_sweep_semiblock(
                               dir_inc_x, dir_inc_y, dir_inc_z,
                               do_block_init_this,
                               is_octant_active );
+      Profiler_end_arg( SUBBLOCK, subblockwave );
 
       if( subblockwave != nsubblockwave-1 )
       {
@@ -1283,7 +1326,11 @@ TARGET_HD void Sweeper_sweep_block_impl(
 
         Sweeper_get_semiblock_bounds(&is_semiblock_min_x, &is_semiblock_max_x,
           &ixmin_semiblock, &ixmax_semiblock, &ixmax_semiblock_up2,
-          sweeper.dims_b.ncell_x, DIM_X, dir_x, semiblock_step, nsemiblock);
+          stepinfo.ncell_x, DIM_X, dir_x, semiblock_step, nsemiblock);
+
+        ixmin_semiblock     += stepinfo.ix_base;
+        ixmax_semiblock     += stepinfo.ix_base;
+        ixmax_semiblock_up2 += stepinfo.ix_base;
 
         /*--------------------*/
 
@@ -1292,7 +1339,11 @@ TARGET_HD void Sweeper_sweep_block_impl(
 
         Sweeper_get_semiblock_bounds(&is_semiblock_min_y, &is_semiblock_max_y,
           &iymin_semiblock, &iymax_semiblock, &iymax_semiblock_up2,
-          sweeper.dims_b.ncell_y, DIM_Y, dir_y, semiblock_step, nsemiblock);
+          stepinfo.ncell_y, DIM_Y, dir_y, semiblock_step, nsemiblock);
+
+        iymin_semiblock     += stepinfo.iy_base;
+        iymax_semiblock     += stepinfo.iy_base;
+        iymax_semiblock_up2 += stepinfo.iy_base;
 
         /*--------------------*/
 
@@ -1301,14 +1352,14 @@ TARGET_HD void Sweeper_sweep_block_impl(
 
         Sweeper_get_semiblock_bounds(&is_semiblock_min_z, &is_semiblock_max_z,
           &izmin_semiblock, &izmax_semiblock, &izmax_semiblock_up2,
-          sweeper.dims_b.ncell_z, DIM_Z, dir_z, semiblock_step, nsemiblock);
+          stepinfo.ncell_z, DIM_Z, dir_z, semiblock_step, nsemiblock);
 
         /*--------------------*/
         /*---Perform sweep over subblocks in semiblock---*/
         /*---(for tasking case, this task sweeps one subblock in semiblock---*/
         /*--------------------*/
 
-        const int iz_base = stepinfo.block_z * sweeper.dims_b.ncell_z;
+        const int iz_base = stepinfo.iz_base;
 
         const P* vi_this = const_ref_state( vi, sweeper.dims, NU, 0, 0,
                                                             iz_base, 0, 0, 0 );
@@ -1320,6 +1371,8 @@ TARGET_HD void Sweeper_sweep_block_impl(
                            ( octant_in_block + noctant_per_block *
                              semiblock_step ) ) );
 
+        Profiler_begin( SEMIBLOCK );
+
         Sweeper_sweep_semiblock( &sweeper, vo_this, vi_this,
                                  facexy, facexz, faceyz,
                                  a_from_m, m_from_a,
@@ -1330,6 +1383,8 @@ TARGET_HD void Sweeper_sweep_block_impl(
                                  do_block_init_this,
                                  is_octant_active );
 
+        Profiler_end_arg( SEMIBLOCK, semiblock_step );
+
       } /*---octant_in_block---*/
 
 #ifdef USE_OPENMP_TASKS
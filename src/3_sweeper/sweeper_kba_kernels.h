@@ -89,6 +89,7 @@ typedef struct
   int              nthread_z;
 
   int              nblock_z;
+  int              nangle_set;
   int              nblock_octant;
   int              noctant_per_block;
   int              nsemiblock;
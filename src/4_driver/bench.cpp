@@ -0,0 +1,548 @@
+/*---------------------------------------------------------------------------*/
+/*!
+ * \file   bench.c
+ * \author agent
+ * \date   Mon Oct 19 03:38:58 UTC 2026
+ * \brief  Microbenchmarks of the computational kernels of the sweep.
+ */
+/*---------------------------------------------------------------------------*/
+
+/*=============================================================================
+
+Each kernel is run on a one-block problem owned by one proc, first untimed
+for warmup and then timed for a number of repetitions.  Times are reported
+per unit of work, cell-angles per octant for the angle kernels and
+cell-moments for the state kernels, from the median repetition.  Flop
+counts follow those of the runner; bytes count each operand of a cell
+once, with the moment-angle matrices assumed resident in cache.
+
+=============================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "arguments.h"
+#include "env.h"
+#include "definitions.h"
+#include "dimensions.h"
+#include "array_accessors.h"
+#include "pointer.h"
+#include "quantities.h"
+#include "array_operations.h"
+#include "sweeper.h"
+#include "sweeper_kba_c_kernels.h"
+#include "profiler.h"
+
+/*===========================================================================*/
+/*---Kernels benchmarked---*/
+
+enum{ BENCH_SWEEP_CELL   = 0,
+      BENCH_SOLVE        = 1,
+      BENCH_A_FROM_M     = 2,
+      BENCH_M_FROM_A     = 3,
+      BENCH_FACE_PACK    = 4,
+      BENCH_FACE_UNPACK  = 5,
+      BENCH_STATE_ACCESS = 6,
+      BENCH_NORMS        = 7,
+      BENCH_COPY         = 8,
+      BENCH_NKERNEL      = 9 };
+
+/*---Kernels with angles; the rest are independent of na---*/
+
+enum{ BENCH_NKERNEL_ANGLE = BENCH_FACE_UNPACK + 1 };
+
+static const char* bench_name_[BENCH_NKERNEL] = {
+  "sweep_cell", "solve", "a_from_m", "m_from_a", "face_pack",
+  "face_unpack", "state_access", "norms", "copy_vector" };
+
+/*===========================================================================*/
+/*---Arrays and sizes for running the kernels---*/
+
+typedef struct
+{
+  SweeperLite        sweeperlite;
+  const Quantities*  quan;
+  Dimensions         dims;
+  P*                 vi;
+  P*                 vo;
+  P*                 vs;
+  P*                 facexy;
+  P*                 facexz;
+  P*                 faceyz;
+  P*                 buf;
+} Bench;
+
+/*===========================================================================*/
+/*---Run a kernel once---*/
+
+static void Bench_kernel_( Bench* bench, int kernel, Env* env )
+{
+  SweeperLite* const sweeper = &bench->sweeperlite;
+  const Dimensions dims = bench->dims;
+  const int noctant_per_block = sweeper->noctant_per_block;
+  const P* const a_from_m = Pointer_const_h( &bench->quan->a_from_m );
+  const P* const m_from_a = Pointer_const_h( &bench->quan->m_from_a );
+
+  int octant = 0;
+  int ix = 0;
+  int iy = 0;
+  int iz = 0;
+  int ie = 0;
+  int im = 0;
+  int ia = 0;
+  int iu = 0;
+
+  switch( kernel )
+  {
+    /*--------------------*/
+    case BENCH_SWEEP_CELL:
+    /*--------------------*/
+#ifndef __HIP_PLATFORM_HCC__
+      for( octant=0; octant<NOCTANT; ++octant )
+      for( ie=0; ie<dims.ne; ++ie )
+      for( iz=0; iz<dims.ncell_z; ++iz )
+      for( iy=0; iy<dims.ncell_y; ++iy )
+      for( ix=0; ix<dims.ncell_x; ++ix )
+      {
+        Sweeper_sweep_cell( sweeper, bench->vo, bench->vi,
+                            Sweeper_vilocal_this_( sweeper ),
+                            Sweeper_vslocal_this_( sweeper ),
+                            Sweeper_volocal_this_( sweeper ),
+                            bench->facexy, bench->facexz, bench->faceyz,
+                            a_from_m, m_from_a, bench->quan,
+                            octant, 0, 0, 0, dims.na, ie, ix, iy, iz,
+                            octant == 0, Bool_true );
+      }
+#endif
+      break;
+
+    /*--------------------*/
+    case BENCH_SOLVE:
+    /*--------------------*/
+      for( octant=0; octant<NOCTANT; ++octant )
+      for( ie=0; ie<dims.ne; ++ie )
+      for( iz=0; iz<dims.ncell_z; ++iz )
+      for( iy=0; iy<dims.ncell_y; ++iy )
+      for( ix=0; ix<dims.ncell_x; ++ix )
+      for( ia=0; ia<dims.na; ++ia )
+      {
+        Quantities_solve( bench->quan, bench->vs, ia, ia, dims.na,
+                          bench->facexy, bench->facexz, bench->faceyz,
+                          ix, iy, iz, ie, ix, iy, iz, octant, 0,
+                          noctant_per_block, dims, sweeper->dims_g,
+                          Bool_true );
+      }
+      break;
+
+    /*--------------------*/
+    case BENCH_A_FROM_M:
+    /*--------------------*/
+      for( octant=0; octant<NOCTANT; ++octant )
+      for( ie=0; ie<dims.ne; ++ie )
+      for( iz=0; iz<dims.ncell_z; ++iz )
+      for( iy=0; iy<dims.ncell_y; ++iy )
+      for( ix=0; ix<dims.ncell_x; ++ix )
+      for( iu=0; iu<NU; ++iu )
+      for( ia=0; ia<dims.na; ++ia )
+      {
+        P v = P_zero();
+        for( im=0; im<NM; ++im )
+        {
+          v += *const_ref_a_from_m( a_from_m, dims, im, ia, octant )
+             * *const_ref_state( bench->vi, dims, NU,
+                                 ix, iy, iz, ie, im, iu );
+        }
+        *ref_vslocal( bench->vs, dims, NU, dims.na, ia, iu ) = v;
+      }
+      break;
+
+    /*--------------------*/
+    case BENCH_M_FROM_A:
+    /*--------------------*/
+      for( octant=0; octant<NOCTANT; ++octant )
+      for( ie=0; ie<dims.ne; ++ie )
+      for( iz=0; iz<dims.ncell_z; ++iz )
+      for( iy=0; iy<dims.ncell_y; ++iy )
+      for( ix=0; ix<dims.ncell_x; ++ix )
+      for( iu=0; iu<NU; ++iu )
+      for( im=0; im<NM; ++im )
+      {
+        P v = P_zero();
+        for( ia=0; ia<dims.na; ++ia )
+        {
+          v += *const_ref_m_from_a( m_from_a, dims, im, ia, octant )
+             * *const_ref_vslocal( bench->vs, dims, NU, dims.na, ia, iu );
+        }
+        *ref_state( bench->vo, dims, NU, ix, iy, iz, ie, im, iu ) += v;
+      }
+      break;
+
+    /*--------------------*/
+    case BENCH_FACE_PACK:
+    case BENCH_FACE_UNPACK:
+    /*--------------------*/
+      Faces_copy_region_( bench->facexy, bench->buf, dims,
+                          dims.ncell_x, 0, dims.ncell_x,
+                          dims.ncell_y, 0, dims.ncell_y,
+                          0, dims.na, kernel == BENCH_FACE_PACK );
+      break;
+
+    /*--------------------*/
+    case BENCH_STATE_ACCESS:
+    /*--------------------*/
+      for( iz=0; iz<dims.ncell_z; ++iz )
+      for( iy=0; iy<dims.ncell_y; ++iy )
+      for( ix=0; ix<dims.ncell_x; ++ix )
+      for( ie=0; ie<dims.ne; ++ie )
+      for( im=0; im<dims.nm; ++im )
+      for( iu=0; iu<NU; ++iu )
+      {
+        *ref_state( bench->vo, dims, NU, ix, iy, iz, ie, im, iu ) +=
+          *const_ref_state( bench->vi, dims, NU, ix, iy, iz, ie, im, iu );
+      }
+      break;
+
+    /*--------------------*/
+    case BENCH_NORMS:
+    /*--------------------*/
+      {
+        P normsq = P_zero();
+        P normsqdiff = P_zero();
+        get_state_norms( bench->vi, bench->vo, dims, NU,
+                         &normsq, &normsqdiff, env );
+      }
+      break;
+
+    /*--------------------*/
+    case BENCH_COPY:
+    /*--------------------*/
+      copy_vector( bench->vo, bench->vi, Dimensions_size_state( dims, NU ) );
+      break;
+
+    default:
+      Insist( Bool_false ? "Invalid kernel." : 0 );
+  } /*---switch---*/
+}
+
+/*===========================================================================*/
+/*---Work of one run of a kernel: units, flops and bytes moved---*/
+
+static void Bench_work_( const Bench* bench,
+                         int          kernel,
+                         double*      nunit,
+                         double*      flops,
+                         double*      bytes )
+{
+  const Dimensions dims = bench->dims;
+  const double ncell = dims.ncell_x * (double) dims.ncell_y * dims.ncell_z
+                     * dims.ne;
+  const double na = dims.na;
+  const double flops_solve = NU * Quantities_flops_per_solve( dims );
+  const double p = sizeof( P );
+
+  *nunit = kernel < BENCH_FACE_PACK ? ncell * na * NOCTANT :
+           kernel < BENCH_NKERNEL_ANGLE ?
+                    dims.ncell_x * (double) dims.ncell_y * dims.ne * na :
+                    ncell * NM;
+
+  switch( kernel )
+  {
+    case BENCH_SWEEP_CELL:
+      *flops = *nunit * ( NU * 4. * NM + flops_solve );
+      *bytes = ncell * NOCTANT * ( 3. * NM * NU + 6. * na * NU ) * p;
+      break;
+    case BENCH_SOLVE:
+      *flops = *nunit * flops_solve;
+      *bytes = *nunit * 8. * NU * p;
+      break;
+    case BENCH_A_FROM_M:
+      *flops = *nunit * NU * 2. * NM;
+      *bytes = ncell * NOCTANT * ( NM * NU + na * NU ) * p;
+      break;
+    case BENCH_M_FROM_A:
+      *flops = *nunit * NU * 2. * NM;
+      *bytes = ncell * NOCTANT * ( na * NU + 2. * NM * NU ) * p;
+      break;
+    case BENCH_STATE_ACCESS:
+      *flops = *nunit * NU;
+      *bytes = *nunit * 3. * NU * p;
+      break;
+    case BENCH_NORMS:
+      *flops = *nunit * NU * 5.;
+      *bytes = *nunit * 2. * NU * p;
+      break;
+    default:
+      *flops = 0;
+      *bytes = *nunit * 2. * NU * p;
+  } /*---switch---*/
+}
+
+/*===========================================================================*/
+/*---Compare times, for sorting---*/
+
+static int Bench_compare_( const void* a, const void* b )
+{
+  const double ta = *(const double*)a;
+  const double tb = *(const double*)b;
+  return ta < tb ? -1 : ta > tb ? 1 : 0;
+}
+
+/*===========================================================================*/
+/*---Time a kernel, print its row on master---*/
+
+static void Bench_run_( Bench* bench,
+                        int    kernel,
+                        int    nwarmup,
+                        int    nrep,
+                        Env*   env )
+{
+  double* times = (double*) malloc( nrep * sizeof( double ) );
+  double nunit = 0;
+  double flops = 0;
+  double bytes = 0;
+  double mean = 0;
+  double var = 0;
+  int i = 0;
+
+#ifdef __HIP_PLATFORM_HCC__
+  /*---The cell kernel is compiled for the device only---*/
+  if( kernel == BENCH_SWEEP_CELL )
+  {
+    free( (void*) times );
+    return;
+  }
+#endif
+
+  for( i=0; i<nwarmup; ++i )
+  {
+    Bench_kernel_( bench, kernel, env );
+  }
+
+  for( i=0; i<nrep; ++i )
+  {
+    const long long time_begin = Profiler_time_ns();
+    Bench_kernel_( bench, kernel, env );
+    times[i] = ( Profiler_time_ns() - time_begin ) * 1.e-9;
+    mean += times[i] / nrep;
+  }
+
+  for( i=0; i<nrep; ++i )
+  {
+    var += ( times[i] - mean ) * ( times[i] - mean ) / nrep;
+  }
+
+  qsort( times, nrep, sizeof( double ), Bench_compare_ );
+
+  const double time_min = times[0];
+  const double time_med = nrep % 2 ? times[nrep/2] :
+                          .5 * ( times[nrep/2-1] + times[nrep/2] );
+
+  Bench_work_( bench, kernel, &nunit, &flops, &bytes );
+
+  if( Env_is_proc_master( env ) )
+  {
+    char bytes_per_flop[16];
+    if( flops > 0 )
+    {
+      sprintf( bytes_per_flop, "%7.3f", bytes / flops );
+    }
+    else
+    {
+      sprintf( bytes_per_flop, "%7s", "-" );
+    }
+    printf( "%-12s %4i %-11s %8.3f %8.3f %8.3f %8.3f %s %5.1f\n",
+            bench_name_[kernel],
+            bench->dims.na,
+            kernel < BENCH_FACE_PACK ? "cell-angle" :
+            kernel < BENCH_NKERNEL_ANGLE ? "face-angle" : "cell-moment",
+            time_med * 1.e9 / nunit,
+            time_min * 1.e9 / nunit,
+            time_med > 0 ? flops / time_med * 1.e-9 : 0.,
+            time_med > 0 ? bytes / time_med * 1.e-9 : 0.,
+            bytes_per_flop,
+            mean > 0 ? 100. * sqrt( var ) / mean : 0. );
+  }
+
+  free( (void*) times );
+}
+
+/*===========================================================================*/
+/*---Run the kernels for one number of angles---*/
+
+static void Bench_run_na_( Arguments* args,
+                           int        ncell_x,
+                           int        ncell_y,
+                           int        ncell_z,
+                           int        ne,
+                           int        na,
+                           int        nwarmup,
+                           int        nrep,
+                           Bool_t     is_running_state,
+                           Env*       env )
+{
+  Bench bench;
+  Quantities quan;
+  Sweeper sweeper;
+  Arguments args_sweeper = Arguments_null();
+  Dimensions dims;
+  int kernel = 0;
+  int i = 0;
+
+  dims.ncell_x = ncell_x;
+  dims.ncell_y = ncell_y;
+  dims.ncell_z = ncell_z;
+  dims.ne      = ne;
+  dims.nm      = NM;
+  dims.na      = na;
+
+  Quantities_create( &quan, dims, env );
+
+  /*---Sweeper args are consumed for each na---*/
+
+  Arguments_create_copy( &args_sweeper, args );
+  Sweeper_create( &sweeper, dims, &quan, env, &args_sweeper );
+  Insist( Arguments_are_all_consumed( &args_sweeper )
+                                        ? "Invalid argument detected." : 0 );
+  Insist( sweeper.nblock_z == 1 && sweeper.nblock_x == 1 &&
+          sweeper.nblock_y == 1 ? "Bench requires one block." : 0 );
+
+  bench.sweeperlite = Sweeper_sweeperlite( &sweeper );
+#ifdef USE_OPENMP_TASKS
+  bench.sweeperlite.thread_e = 0;
+  bench.sweeperlite.thread_octant = 0;
+  bench.sweeperlite.thread_x = 0;
+  bench.sweeperlite.thread_y = 0;
+  bench.sweeperlite.thread_z = 0;
+#endif
+  bench.quan = &quan;
+  bench.dims = bench.sweeperlite.dims_b;
+
+  const int noctant_per_block = bench.sweeperlite.noctant_per_block;
+
+  bench.vi = malloc_host_P( Dimensions_size_state( dims, NU ) );
+  bench.vo = malloc_host_P( Dimensions_size_state( dims, NU ) );
+  bench.vs = malloc_host_P( (size_t) NU * na );
+  bench.facexy = malloc_host_P( Dimensions_size_facexy( bench.dims, NU,
+                                                       noctant_per_block ) );
+  bench.facexz = malloc_host_P( Dimensions_size_facexz( bench.dims, NU,
+                                                       noctant_per_block ) );
+  bench.faceyz = malloc_host_P( Dimensions_size_faceyz( bench.dims, NU,
+                                                       noctant_per_block ) );
+  bench.buf = malloc_host_P( Dimensions_size_facexy( bench.dims, NU, 1 ) );
+
+  initialize_state( bench.vi, dims, NU, &quan );
+  initialize_state_zero( bench.vo, dims, NU );
+  for( i=0; i<NU*na; ++i )
+  {
+    bench.vs[i] = P_one();
+  }
+  memset( (void*) bench.facexy, 0, Dimensions_size_facexy( bench.dims, NU,
+                                          noctant_per_block ) * sizeof( P ) );
+  memset( (void*) bench.facexz, 0, Dimensions_size_facexz( bench.dims, NU,
+                                          noctant_per_block ) * sizeof( P ) );
+  memset( (void*) bench.faceyz, 0, Dimensions_size_faceyz( bench.dims, NU,
+                                          noctant_per_block ) * sizeof( P ) );
+
+  for( kernel=0; kernel<BENCH_NKERNEL; ++kernel )
+  {
+    if( kernel < BENCH_NKERNEL_ANGLE || is_running_state )
+    {
+      Bench_run_( &bench, kernel, nwarmup, nrep, env );
+    }
+  }
+
+  free_host_P( bench.vi );
+  free_host_P( bench.vo );
+  free_host_P( bench.vs );
+  free_host_P( bench.facexy );
+  free_host_P( bench.facexz );
+  free_host_P( bench.faceyz );
+  free_host_P( bench.buf );
+
+  Sweeper_destroy( &sweeper, env );
+  Quantities_destroy( &quan );
+  Arguments_destroy( &args_sweeper );
+}
+
+/*===========================================================================*/
+/*---Main---*/
+
+int main( int argc, char** argv )
+{
+  /*---Declarations---*/
+  Env env = Env_null();
+
+  /*---Initialize for execution---*/
+
+  Env_initialize( &env, argc, argv );
+
+  Arguments args = Arguments_null();
+
+  Arguments_create( &args, argc, argv );
+
+  Env_set_values( &env, &args );
+
+  /*---Get bench settings; other args are passed to the sweeper---*/
+
+  const int ncell_x = Arguments_consume_int_or_default( &args,
+                                                          "--ncell_x", 8 );
+  const int ncell_y = Arguments_consume_int_or_default( &args,
+                                                          "--ncell_y", 8 );
+  const int ncell_z = Arguments_consume_int_or_default( &args,
+                                                          "--ncell_z", 8 );
+  const int ne = Arguments_consume_int_or_default( &args, "--ne", 1 );
+  const char* na_list = Arguments_consume_string_or_default( &args,
+                                                    "--na_list", "8,32,64" );
+  const int nwarmup = Arguments_consume_int_or_default( &args,
+                                                          "--nwarmup", 2 );
+  const int nrep = Arguments_consume_int_or_default( &args, "--nrep", 10 );
+
+  Insist( ncell_x > 0 && ncell_y > 0 && ncell_z > 0 && ne > 0
+                                      ? "Invalid problem size supplied." : 0 );
+  Insist( nwarmup >= 0 ? "Invalid warmup count supplied." : 0 );
+  Insist( nrep > 0 ? "Invalid repetition count supplied." : 0 );
+  Insist( Env_nproc( &env ) == 1 ? "Bench requires one proc." : 0 );
+
+  if( Env_is_proc_active( &env ) )
+  {
+    if( Env_is_proc_master( &env ) )
+    {
+      printf( "Bench: NM %i  NU %i  ncell %i %i %i  ne %i  "
+              "nwarmup %i  nrep %i\n",
+              NM, NU, ncell_x, ncell_y, ncell_z, ne, nwarmup, nrep );
+      printf( "%-12s %4s %-11s %8s %8s %8s %8s %7s %5s\n",
+              "kernel", "na", "unit", "ns/unit", "ns(min)",
+              "GF/s", "GB/s", "B/flop", "rsd%" );
+    }
+
+    /*---Run for each na in the list, the state kernels only once---*/
+
+    const char* s = na_list;
+    Bool_t is_running_state = Bool_true;
+
+    while( *s )
+    {
+      char* end = NULL;
+      const int na = (int)strtol( s, &end, 10 );
+      Insist( end != s && na > 0 ? "Invalid na list supplied." : 0 );
+      s = *end == ',' ? end + 1 : end;
+
+      Bench_run_na_( &args, ncell_x, ncell_y, ncell_z, ne, na,
+                     nwarmup, nrep, is_running_state, &env );
+      is_running_state = Bool_false;
+    }
+  }
+
+  /*---Deallocations---*/
+
+  Arguments_destroy( &args );
+
+  /*---Finalize execution---*/
+
+  Env_finalize( &env );
+
+} /*---main---*/
+
+/*---------------------------------------------------------------------------*/
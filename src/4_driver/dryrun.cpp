@@ -0,0 +1,493 @@
+/*---------------------------------------------------------------------------*/
+/*!
+ * \file   dryrun.cpp
+ * \author agent
+ * \date   Mon Oct 19 03:20:24 UTC 2026
+ * \brief  Simulation of the KBA schedule of all procs on one proc.
+ */
+/*---------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arguments.h"
+#include "env.h"
+#include "definitions.h"
+#include "dimensions.h"
+#include "stepscheduler_kba.h"
+
+#include "dryrun.h"
+
+#ifdef __cplusplus_IGNORE
+extern "C"
+{
+#endif
+
+/*===========================================================================*/
+/*---Null object---*/
+
+DryRun DryRun_null()
+{
+  DryRun result;
+  memset( (void*)&result, 0, sizeof(DryRun) );
+  return result;
+}
+
+/*===========================================================================*/
+/*---Pseudo-constructor---*/
+
+void DryRun_create( DryRun* dryrun, Arguments* args )
+{
+  Dimensions* const dims_g = &(dryrun->dims_g);
+
+  dims_g->ncell_x = Arguments_consume_int_or_default( args, "--ncell_x",  5 );
+  dims_g->ncell_y = Arguments_consume_int_or_default( args, "--ncell_y",  5 );
+  dims_g->ncell_z = Arguments_consume_int_or_default( args, "--ncell_z",  5 );
+  dims_g->ne   = Arguments_consume_int_or_default( args, "--ne", 30 );
+  dims_g->na   = Arguments_consume_int_or_default( args, "--na", 33 );
+  dims_g->nm   = NM;
+
+  const int niterations = Arguments_consume_int_or_default( args,
+                                                       "--niterations", 1 );
+  const Bool_t is_iteration_pipelined = Arguments_consume_int_or_default(
+                               args, "--is_iteration_pipelined", Bool_false );
+
+  /*---The procs simulated need not be available to the run---*/
+
+  dryrun->nproc_x = Arguments_consume_int_or_default( args, "--nproc_x", 1 );
+  dryrun->nproc_y = Arguments_consume_int_or_default( args, "--nproc_y", 1 );
+  dryrun->nproc_z = Arguments_consume_int_or_default( args, "--nproc_z", 1 );
+  dryrun->nproc_e = Arguments_consume_int_or_default( args, "--nproc_e", 1 );
+  dryrun->nproc_octant = Arguments_consume_int_or_default( args,
+                                                       "--nproc_octant", 1 );
+
+  dryrun->nblock_z   = Arguments_consume_int_or_default( args,
+                                                         "--nblock_z", 1 );
+  dryrun->nblock_x   = Arguments_consume_int_or_default( args,
+                                                         "--nblock_x", 1 );
+  dryrun->nblock_y   = Arguments_consume_int_or_default( args,
+                                                         "--nblock_y", 1 );
+  dryrun->nangle_set = Arguments_consume_int_or_default( args,
+                                                         "--nangle_set", 1 );
+  dryrun->nthread_octant = Arguments_consume_int_or_default( args,
+                                                    "--nthread_octant", 1 );
+  dryrun->is_octant_order_optimized = Arguments_consume_int_or_default(
+                         args, "--is_octant_order_optimized", Bool_true );
+
+  dryrun->niteration = is_iteration_pipelined && niterations > 0 ?
+                                                         niterations : 1;
+
+  /*---Tapering changes only the cells of the blocks, not the schedule,
+       but the face sizes below assume even blocks---*/
+
+  const Bool_t is_block_z_tapered = Arguments_consume_int_or_default(
+                                  args, "--is_block_z_tapered", Bool_false );
+
+  Insist( dims_g->ncell_x > 0 ? "Invalid ncell_x supplied." : 0 );
+  Insist( dims_g->ncell_y > 0 ? "Invalid ncell_y supplied." : 0 );
+  Insist( dims_g->ncell_z > 0 ? "Invalid ncell_z supplied." : 0 );
+  Insist( dims_g->ne > 0      ? "Invalid ne supplied." : 0 );
+  Insist( dims_g->na > 0      ? "Invalid na supplied." : 0 );
+  Insist( dryrun->nproc_x > 0 && dryrun->nproc_x <= dims_g->ncell_x ?
+                                        "Invalid nproc_x supplied." : 0 );
+  Insist( dryrun->nproc_y > 0 && dryrun->nproc_y <= dims_g->ncell_y ?
+                                        "Invalid nproc_y supplied." : 0 );
+  Insist( dryrun->nproc_z > 0 && dryrun->nproc_z <= dims_g->ncell_z ?
+                                        "Invalid nproc_z supplied." : 0 );
+  Insist( dryrun->nproc_e > 0 && dryrun->nproc_e <= dims_g->ne ?
+                                        "Invalid nproc_e supplied." : 0 );
+  Insist( dryrun->nproc_octant > 0 && dryrun->nproc_octant <= NOCTANT &&
+          ( dryrun->nproc_octant & ( dryrun->nproc_octant - 1 ) ) == 0
+                                    ? "Invalid nproc_octant supplied." : 0 );
+  Insist( dryrun->nblock_z > 0 &&
+          dryrun->nblock_z <= dims_g->ncell_z / dryrun->nproc_z ?
+                                  "Invalid z blocking factor supplied." : 0 );
+  Insist( dryrun->nblock_x > 0 &&
+          dryrun->nblock_x <= dims_g->ncell_x / dryrun->nproc_x &&
+          dryrun->nblock_y > 0 &&
+          dryrun->nblock_y <= dims_g->ncell_y / dryrun->nproc_y ?
+                          "Invalid x or y blocking factor supplied." : 0 );
+  Insist( dryrun->nangle_set > 0 && dryrun->nangle_set <= dims_g->na ?
+                                     "Invalid angle set count supplied" : 0 );
+  Insist( dryrun->nthread_octant > 0 && dryrun->nthread_octant <= NOCTANT &&
+          ( dryrun->nthread_octant & ( dryrun->nthread_octant - 1 ) ) == 0
+                                       ? "Invalid thread count supplied" : 0 );
+
+  /*---Combinations the scheduler would reject later---*/
+
+  Insist( dryrun->nthread_octant * dryrun->nproc_octant <= NOCTANT ?
+          "Octant thread count times nproc_octant must not exceed 8." : 0 );
+  Insist( dryrun->niteration == 1 || dryrun->nproc_octant == 1 ?
+          "Pipelined iterations currently require nproc_octant 1." : 0 );
+  Insist( ! is_block_z_tapered ?
+          "Tapered z blocks are not simulated by the dry run." : 0 );
+}
+
+/*===========================================================================*/
+/*---Pseudo-destructor---*/
+
+void DryRun_destroy( DryRun* dryrun )
+{
+}
+
+/*===========================================================================*/
+/*---Cells of a part of an axis split as evenly as possible---*/
+/*---pseudo-private member function---*/
+
+static int DryRun_ncell_part_( int ncell, int npart, int part )
+{
+  return ( ( part + 1 ) * ncell ) / npart - ( part * ncell ) / npart;
+}
+
+/*===========================================================================*/
+/*---Simulate the schedule of all procs---*/
+
+Bool_t DryRun_run( DryRun* dryrun, int verbosity )
+{
+  const Dimensions dims_g = dryrun->dims_g;
+
+  const int nproc_x      = dryrun->nproc_x;
+  const int nproc_y      = dryrun->nproc_y;
+  const int nproc_z      = dryrun->nproc_z;
+  const int nproc_e      = dryrun->nproc_e;
+  const int nproc_octant = dryrun->nproc_octant;
+  const int nblock_z     = dryrun->nblock_z;
+  const int nblock_x     = dryrun->nblock_x;
+  const int nblock_y     = dryrun->nblock_y;
+  const int nangle_set   = dryrun->nangle_set;
+  const int niteration   = dryrun->niteration;
+  const int nblock_g     = nblock_z * nproc_z;
+
+  const int nblock_octant     = NOCTANT / dryrun->nthread_octant;
+  const int noctant_per_block = dryrun->nthread_octant;
+
+  /*---Procs of one energy group; the others repeat its schedule---*/
+
+  const int nproc_xyz = nproc_x * nproc_y * nproc_z;
+  const int nproc_sim = nproc_xyz * nproc_octant;
+
+  /*---Virtual blocks are scheduled as procs of their own, as the sweeper
+       does---*/
+
+  const int nvproc_x = nproc_x * nblock_x;
+  const int nvproc_y = nproc_y * nblock_y;
+  const int nvblock  = nblock_x * nblock_y;
+
+  /*---Schedule of each octant group of procs---*/
+
+  StepScheduler* stepschedulers = (StepScheduler*)
+                    malloc( nproc_octant * sizeof(StepScheduler) );
+
+  int nstep = 0;
+  int proc_octant = 0;
+
+  for( proc_octant=0; proc_octant<nproc_octant; ++proc_octant )
+  {
+    StepScheduler* const stepscheduler = &stepschedulers[proc_octant];
+    *stepscheduler = StepScheduler_null();
+    StepScheduler_create_model( stepscheduler, nblock_z, nangle_set,
+                                nvproc_x, nvproc_y, nproc_z, nblock_octant,
+                                nproc_octant, proc_octant, niteration,
+                                dryrun->is_octant_order_optimized );
+    const int nstep_this = StepScheduler_nstep( stepscheduler );
+    nstep = nstep_this > nstep ? nstep_this : nstep;
+  }
+
+  /*---Step at which each block of each octant, angle set and iteration
+       is swept on each virtual block column, or -1---*/
+
+  const size_t nentry = (size_t)nvproc_x * nvproc_y * nblock_g * NOCTANT *
+                                                   nangle_set * niteration;
+  int* step_swept = (int*) malloc( nentry * sizeof(int) );
+
+  int*    nstep_active = (int*) malloc( nproc_sim * sizeof(int) );
+  int*    nmsg_step    = (int*) malloc( nstep * sizeof(int) );
+  double* nbyte_step   = (double*) malloc( nstep * sizeof(double) );
+
+  size_t i = 0;
+  for( i=0; i<nentry; ++i )
+  {
+    step_swept[i] = -1;
+  }
+  for( i=0; i<(size_t)nproc_sim; ++i )
+  {
+    nstep_active[i] = 0;
+  }
+  for( i=0; i<(size_t)nstep; ++i )
+  {
+    nmsg_step[i]  = 0;
+    nbyte_step[i] = 0;
+  }
+
+  /*---Messages of all energy groups together carry all energies---*/
+
+  const double nvalue_row = (double)dims_g.ne * NU;
+
+  int nsend_unmatched = 0;
+  int nrecv_unmatched = 0;
+  int nblock_swept_twice = 0;
+  int nblock_unswept = 0;
+  int ndep_violated = 0;
+
+  /*---Sweep the schedule of every proc, step by step---*/
+
+  for( proc_octant=0; proc_octant<nproc_octant; ++proc_octant )
+  {
+  const StepScheduler* const stepscheduler = &stepschedulers[proc_octant];
+  const int nstep_this = StepScheduler_nstep( stepscheduler );
+
+  int proc_x = 0;
+  int proc_y = 0;
+  int proc_z = 0;
+  int step = 0;
+
+  for( proc_z=0; proc_z<nproc_z; ++proc_z )
+  for( proc_y=0; proc_y<nproc_y; ++proc_y )
+  for( proc_x=0; proc_x<nproc_x; ++proc_x )
+  {
+    const int proc_sim = proc_x + nproc_x * ( proc_y + nproc_y *
+                                ( proc_z + nproc_z * proc_octant ) );
+
+    /*---Face rows of this proc, as sized by the sweeper---*/
+
+    const int ncell_x = DryRun_ncell_part_( dims_g.ncell_x, nproc_x, proc_x );
+    const int ncell_y = DryRun_ncell_part_( dims_g.ncell_y, nproc_y, proc_y );
+    const int ncell_z = iceil( DryRun_ncell_part_( dims_g.ncell_z, nproc_z,
+                                                   proc_z ), nblock_z );
+
+    for( step=0; step<nstep_this; ++step )
+    {
+      Bool_t is_step_active = Bool_false;
+      int vblock = 0;
+
+      for( vblock=0; vblock<nvblock; ++vblock )
+      {
+        const int block_x = vblock % nblock_x;
+        const int block_y = vblock / nblock_x;
+        const int vproc_x = block_x + nblock_x * proc_x;
+        const int vproc_y = block_y + nblock_y * proc_y;
+
+        const int ncell_x_vb = DryRun_ncell_part_( ncell_x, nblock_x,
+                                                   block_x );
+        const int ncell_y_vb = DryRun_ncell_part_( ncell_y, nblock_y,
+                                                   block_y );
+        int octant_in_block = 0;
+
+        for( octant_in_block=0; octant_in_block<noctant_per_block;
+                                                        ++octant_in_block )
+        {
+          const StepInfo stepinfo = StepScheduler_stepinfo( stepscheduler,
+                           step, octant_in_block, vproc_x, vproc_y, proc_z );
+
+          if( ! stepinfo.is_active )
+          {
+            continue;
+          }
+          is_step_active = Bool_true;
+
+          /*---Record the block swept---*/
+
+          const int block_g = stepinfo.block_z + nblock_z * proc_z;
+          const size_t entry = vproc_x + nvproc_x * ( vproc_y + nvproc_y *
+                     ( block_g + nblock_g * ( stepinfo.octant + NOCTANT *
+                     ( stepinfo.angle_set + nangle_set * (size_t)
+                       stepinfo.iteration ) ) ) );
+
+          if( step_swept[entry] >= 0 )
+          {
+            ++nblock_swept_twice;
+          }
+          step_swept[entry] = step;
+
+          /*---Faces sent, each matched by a recv of the target; a recv
+               needs an active source, so all recvs are seen here---*/
+
+          const int na_set =
+                       StepInfo_ia_max( stepinfo, dims_g.na, nangle_set )
+                     - StepInfo_ia_min( stepinfo, dims_g.na, nangle_set );
+
+          int axis = 0;
+          for( axis=0; axis<NDIM; ++axis )
+          {
+            int dir_ind = 0;
+            for( dir_ind=0; dir_ind<2; ++dir_ind )
+            {
+              const int inc = dir_ind==0 ? Dir_inc( DIR_UP )
+                                         : Dir_inc( DIR_DN );
+              const int inc_x = axis==0 ? inc : 0;
+              const int inc_y = axis==1 ? inc : 0;
+              const int inc_z = axis==2 ? inc : 0;
+
+              const Bool_t do_send = StepScheduler_must_do_send_proc(
+                stepscheduler, step, axis, dir_ind, octant_in_block,
+                vproc_x, vproc_y, proc_z );
+              const Bool_t do_recv = StepScheduler_must_do_recv_proc(
+                stepscheduler, step, axis, dir_ind, octant_in_block,
+                vproc_x + inc_x, vproc_y + inc_y, proc_z + inc_z );
+
+              nsend_unmatched += do_send && ! do_recv;
+              nrecv_unmatched += do_recv && ! do_send;
+
+              /*---A face between virtual blocks of one proc is copied,
+                   not sent; as in the sweeper, each remote virtual block
+                   face is its own message---*/
+
+              const Bool_t is_remote = axis==2 ||
+                block_x + inc_x < 0 || block_x + inc_x >= nblock_x ||
+                block_y + inc_y < 0 || block_y + inc_y >= nblock_y;
+
+              if( do_send && is_remote )
+              {
+                const double nrow = nvalue_row *
+                  ( axis==0 ? ncell_y_vb * ncell_z :
+                    axis==1 ? ncell_x_vb * ncell_z :
+                              ncell_x_vb * ncell_y_vb );
+                nmsg_step[step] += nproc_e;
+                nbyte_step[step] += nrow * na_set * sizeof(P);
+              }
+            }
+          }
+        } /*---octant_in_block---*/
+      } /*---vblock---*/
+
+      nstep_active[proc_sim] += is_step_active;
+
+    } /*---step---*/
+  } /*---proc---*/
+  } /*---proc_octant---*/
+
+  /*---Every block must be swept, after the blocks upstream of it; a face
+       from another proc is only available at the step after it is sent---*/
+
+  const int nentry_block = nvproc_x * nvproc_y * nblock_g;
+
+  for( i=0; i<nentry; ++i )
+  {
+    const int step = step_swept[i];
+
+    if( step < 0 )
+    {
+      ++nblock_unswept;
+      continue;
+    }
+
+    const int octant  = ( i / nentry_block ) % NOCTANT;
+    const int vproc_x = i % nvproc_x;
+    const int vproc_y = ( i / nvproc_x ) % nvproc_y;
+    const int block_g = ( i / ( nvproc_x * nvproc_y ) ) % nblock_g;
+
+    const int inc_x = Dir_inc( Dir_x( octant ) );
+    const int inc_y = Dir_inc( Dir_y( octant ) );
+    const int inc_z = Dir_inc( Dir_z( octant ) );
+
+    if( vproc_x-inc_x >= 0 && vproc_x-inc_x < nvproc_x )
+    {
+      ndep_violated += step_swept[ i - inc_x ] != step - 1;
+    }
+    if( vproc_y-inc_y >= 0 && vproc_y-inc_y < nvproc_y )
+    {
+      ndep_violated += step_swept[ i - inc_y * nvproc_x ] != step - 1;
+    }
+    if( block_g-inc_z >= 0 && block_g-inc_z < nblock_g )
+    {
+      const int step_up = step_swept[ i - inc_z * nvproc_x * nvproc_y ];
+      const Bool_t is_same_proc = ( block_g-inc_z ) / nblock_z ==
+                                    block_g / nblock_z;
+      ndep_violated += is_same_proc ? step_up < 0 || step_up >= step
+                                    : step_up != step - 1;
+    }
+  }
+
+  /*---Summarize---*/
+
+  int nstep_active_min = nstep;
+  int nstep_active_max = 0;
+  double nstep_active_sum = 0;
+  int nmsg_step_max = 0;
+  double nmsg = 0;
+  double nbyte = 0;
+  double nbyte_step_max = 0;
+
+  for( i=0; i<(size_t)nproc_sim; ++i )
+  {
+    nstep_active_min = nstep_active[i] < nstep_active_min ?
+                       nstep_active[i] : nstep_active_min;
+    nstep_active_max = nstep_active[i] > nstep_active_max ?
+                       nstep_active[i] : nstep_active_max;
+    nstep_active_sum += nstep_active[i];
+  }
+
+  for( i=0; i<(size_t)nstep; ++i )
+  {
+    nmsg += nmsg_step[i];
+    nbyte += nbyte_step[i];
+    nmsg_step_max = nmsg_step[i] > nmsg_step_max ?
+                    nmsg_step[i] : nmsg_step_max;
+    nbyte_step_max = nbyte_step[i] > nbyte_step_max ?
+                     nbyte_step[i] : nbyte_step_max;
+  }
+
+  const Bool_t is_pass = nsend_unmatched == 0 && nrecv_unmatched == 0 &&
+                         nblock_swept_twice == 0 && nblock_unswept == 0 &&
+                         ndep_violated == 0;
+
+  if( verbosity >= 2 )
+  {
+    for( i=0; i<(size_t)nproc_sim; ++i )
+    {
+      printf( "proc_x %i proc_y %i proc_z %i proc_octant %i"
+              "  active steps %i  idle steps %i\n",
+              (int)( i % nproc_x ), (int)( ( i / nproc_x ) % nproc_y ),
+              (int)( ( i / ( nproc_x * nproc_y ) ) % nproc_z ),
+              (int)( i / nproc_xyz ), nstep_active[i],
+              nstep - nstep_active[i] );
+    }
+    for( i=0; i<(size_t)nstep; ++i )
+    {
+      printf( "step %i  messages %i  bytes %.0f\n",
+              (int)i, nmsg_step[i], nbyte_step[i] );
+    }
+  }
+
+  printf( "Dry run: procs %i x %i x %i x %i x %i  nblock_z %i"
+          "  virtual blocks %i x %i  nangle_set %i  nthread_octant %i"
+          "  nstep %i\n",
+          nproc_x, nproc_y, nproc_z, nproc_e, nproc_octant, nblock_z,
+          nblock_x, nblock_y, nangle_set, noctant_per_block, nstep );
+  printf( "Active steps per proc: min %i  max %i  mean %.2f"
+          "  idle steps: min %i  max %i\n",
+          nstep_active_min, nstep_active_max, nstep_active_sum / nproc_sim,
+          nstep - nstep_active_max, nstep - nstep_active_min );
+  printf( "Messages: %.0f  bytes: %.0f  per step max: %i  bytes %.0f\n",
+          nmsg, nbyte, nmsg_step_max, nbyte_step_max );
+  printf( "Pipeline efficiency: %.3f\n",
+          nstep_active_sum / ( (double)nproc_sim * nstep ) );
+  printf( "Schedule check: unmatched sends %i  unmatched recvs %i"
+          "  blocks unswept %i  swept twice %i  dependences violated %i"
+          "  %s\n",
+          nsend_unmatched, nrecv_unmatched, nblock_unswept,
+          nblock_swept_twice, ndep_violated, is_pass ? "PASS" : "FAIL" );
+
+  /*---Deallocations---*/
+
+  for( proc_octant=0; proc_octant<nproc_octant; ++proc_octant )
+  {
+    StepScheduler_destroy( &stepschedulers[proc_octant] );
+  }
+  free( (void*) stepschedulers );
+  free( (void*) step_swept );
+  free( (void*) nstep_active );
+  free( (void*) nmsg_step );
+  free( (void*) nbyte_step );
+
+  return is_pass;
+}
+
+/*===========================================================================*/
+
+#ifdef __cplusplus_IGNORE
+} /*---extern "C"---*/
+#endif
+
+/*---------------------------------------------------------------------------*/
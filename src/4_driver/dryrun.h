@@ -0,0 +1,73 @@
+/*---------------------------------------------------------------------------*/
+/*!
+ * \file   dryrun.h
+ * \author agent
+ * \date   Mon Oct 19 03:20:24 UTC 2026
+ * \brief  Simulation of the KBA schedule of all procs on one proc, header.
+ */
+/*---------------------------------------------------------------------------*/
+
+#ifndef _dryrun_h_
+#define _dryrun_h_
+
+#include "arguments.h"
+#include "env.h"
+#include "definitions.h"
+#include "dimensions.h"
+
+#ifdef __cplusplus_IGNORE
+extern "C"
+{
+#endif
+
+/*===========================================================================*/
+/*---Struct with the decomposition simulated---*/
+
+typedef struct
+{
+  Dimensions dims_g;
+  int        nproc_x;
+  int        nproc_y;
+  int        nproc_z;
+  int        nproc_e;
+  int        nproc_octant;
+  int        nblock_z;
+  int        nblock_x;        /*---Virtual blocks of each proc---*/
+  int        nblock_y;
+  int        nangle_set;
+  int        nthread_octant;
+  int        niteration;      /*---Iterations pipelined in one schedule---*/
+  Bool_t     is_octant_order_optimized;
+} DryRun;
+
+/*===========================================================================*/
+/*---Null object---*/
+
+DryRun DryRun_null(void);
+
+/*===========================================================================*/
+/*---Pseudo-constructor: consume the problem and decomposition settings,
+     leaving the environment to be set up for one proc---*/
+
+void DryRun_create( DryRun* dryrun, Arguments* args );
+
+/*===========================================================================*/
+/*---Pseudo-destructor---*/
+
+void DryRun_destroy( DryRun* dryrun );
+
+/*===========================================================================*/
+/*---Simulate the schedule of all procs, print the results; verbosity 2
+     adds a line per proc and per step---*/
+
+Bool_t DryRun_run( DryRun* dryrun, int verbosity );
+
+/*===========================================================================*/
+
+#ifdef __cplusplus_IGNORE
+} /*---extern "C"---*/
+#endif
+
+#endif /*---_dryrun_h_---*/
+
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,472 @@
+/*---------------------------------------------------------------------------*/
+/*!
+ * \file   perfmodel.cpp
+ * \author agent
+ * \date   Mon Oct 19 03:16:57 UTC 2026
+ * \brief  Analytic performance model of the KBA sweep, definitions.
+ */
+/*---------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arguments.h"
+#include "env.h"
+#include "definitions.h"
+#include "dimensions.h"
+#include "stepscheduler_kba.h"
+
+#include "runner.h"
+#include "perfmodel.h"
+
+#ifdef __cplusplus_IGNORE
+extern "C"
+{
+#endif
+
+/*===========================================================================*/
+/*---Null object---*/
+
+PerfModel PerfModel_null()
+{
+  PerfModel result;
+  memset( (void*)&result, 0, sizeof(PerfModel) );
+  return result;
+}
+
+/*===========================================================================*/
+/*---Measure message latency and bandwidth between procs 0 and 1---*/
+/*---pseudo-private member function---*/
+
+static void PerfModel_measure_comm_( PerfModel* model,
+                                     Env*       env )
+{
+  const int nrep = 100;
+  const size_t n_large = ( (size_t) 1 ) << 18;
+  const int proc_this = Env_proc_this( env );
+  const int tag = Env_tag( env );
+
+  P* const buf = malloc_host_P( n_large );
+  memset( (void*)buf, 0, n_large * sizeof(P) );
+
+  double time_msg[2];
+  int i = 0;
+  int rep = 0;
+
+  /*---Ping-pong a single value, then a large message---*/
+
+  for( i=0; i<2; ++i )
+  {
+    const size_t n = i == 0 ? 1 : n_large;
+
+    Env_mpi_barrier( env );
+    const Timer t1 = Env_get_time( env );
+
+    for( rep=0; rep<nrep; ++rep )
+    {
+      if( proc_this == 0 )
+      {
+        Env_send_P( env, buf, n, 1, tag );
+        Env_recv_P( env, buf, n, 1, tag );
+      }
+      else if( proc_this == 1 )
+      {
+        Env_recv_P( env, buf, n, 0, tag );
+        Env_send_P( env, buf, n, 0, tag );
+      }
+    }
+
+    time_msg[i] = ( Env_get_time( env ) - t1 ) / ( 2. * nrep );
+  }
+
+  Env_increment_tag( env, 1 );
+
+  free_host_P( buf );
+
+  model->latency = time_msg[0];
+  model->bandwidth = time_msg[1] > time_msg[0] ?
+           ( n_large - 1 ) * sizeof(P) / ( time_msg[1] - time_msg[0] ) : 0;
+}
+
+/*===========================================================================*/
+/*---Measure time per solve by sweeping a small problem on one proc---*/
+/*---pseudo-private member function---*/
+
+static void PerfModel_measure_solve_( PerfModel*  model,
+                                      Dimensions  dims_g,
+                                      PerfConfig  config,
+                                      Env*        env )
+{
+  /*---The problem keeps the energies and angles of one proc of the
+       configuration; its cells fill one z block---*/
+
+  const int ncell = 8;
+  const int ncell_x = dims_g.ncell_x < ncell ? dims_g.ncell_x : ncell;
+  const int ncell_y = dims_g.ncell_y < ncell ? dims_g.ncell_y : ncell;
+  const int ncell_z = dims_g.ncell_z < ncell ? dims_g.ncell_z : ncell;
+  const int ne = iceil( dims_g.ne, config.nproc_e );
+
+  /*---Rerun with more iterations until the time can be resolved---*/
+
+  int niterations = 1;
+  Runner runner = Runner_null();
+
+  while( Bool_true )
+  {
+    char argstring[512];
+    sprintf( argstring, "--ncell_x %i --ncell_y %i --ncell_z %i --ne %i"
+             " --na %i --niterations %i --nthread_octant %i"
+             " --nthread_e %i --nthread_y %i --nthread_z %i",
+             ncell_x, ncell_y, ncell_z, ne, dims_g.na, niterations,
+             config.nthread_octant, config.nthread_e, config.nthread_y,
+             config.nthread_z );
+
+    Arguments args_run = Arguments_null();
+    Arguments_create_from_string( &args_run, argstring );
+    Runner_create( &runner );
+    Runner_run_case( &runner, &args_run, env );
+    Runner_destroy( &runner );
+    Arguments_destroy( &args_run );
+
+    if( runner.time >= .1 || niterations >= 1024 )
+    {
+      break;
+    }
+    niterations *= 2;
+  }
+
+  model->time_solve = runner.time / ( niterations * (double)ncell_x *
+                      ncell_y * ncell_z * ne * dims_g.na * NOCTANT );
+}
+
+/*===========================================================================*/
+/*---Pseudo-constructor---*/
+
+void PerfModel_create( PerfModel*  model,
+                       Dimensions  dims_g,
+                       PerfConfig  config,
+                       Arguments*  args,
+                       Env*        env )
+{
+  model->time_solve = Arguments_consume_double_or_default( args,
+                                                   "--model_time_solve", 0 );
+  model->latency    = Arguments_consume_double_or_default( args,
+                                                   "--model_latency", 0 );
+  model->bandwidth  = Arguments_consume_double_or_default( args,
+                                                   "--model_bandwidth", 0 );
+
+  /*---Messages are timed between the procs given---*/
+
+  if( ( model->latency <= 0 || model->bandwidth <= 0 ) &&
+      Env_is_proc_active( env ) && Env_nproc( env ) > 1 )
+  {
+    PerfModel_measure_comm_( model, env );
+  }
+
+  /*---Without a second proc, assume a typical interconnect---*/
+
+  if( model->latency <= 0 )
+  {
+    model->latency = 2.e-6;
+  }
+  if( model->bandwidth <= 0 )
+  {
+    model->bandwidth = 1.e10;
+  }
+
+  /*---Solves are timed on the first proc alone, in an environment of
+       its own---*/
+
+  if( model->time_solve <= 0 )
+  {
+    Arguments args_env = Arguments_null();
+    Arguments_create_from_string( &args_env,
+      "--nproc_x 1 --nproc_y 1 --nproc_z 1 --nproc_e 1 --nproc_octant 1" );
+    Env env_solve = Env_null();
+    Env_create_copy( &env_solve, env, &args_env );
+    Arguments_destroy( &args_env );
+
+    if( Env_is_proc_active( &env_solve ) )
+    {
+      PerfModel_measure_solve_( model, dims_g, config, &env_solve );
+    }
+
+    Env_destroy_copy( &env_solve );
+  }
+}
+
+/*===========================================================================*/
+/*---Pseudo-destructor---*/
+
+void PerfModel_destroy( PerfModel* model )
+{
+}
+
+/*===========================================================================*/
+/*---Predict the time of a run---*/
+
+PerfPrediction PerfModel_predict( const PerfModel* model,
+                                  Dimensions       dims_g,
+                                  int              niterations,
+                                  PerfConfig       config )
+{
+  PerfPrediction result;
+  memset( (void*)&result, 0, sizeof(PerfPrediction) );
+
+  const int nblock_octant     = NOCTANT / config.nthread_octant;
+  const int noctant_per_block = config.nthread_octant;
+  int proc_octant = 0;
+
+  /*---Steps of the schedule the sweeper would build, for the slowest
+       octant group of procs---*/
+
+  for( proc_octant=0; proc_octant<config.nproc_octant; ++proc_octant )
+  {
+    StepScheduler stepscheduler = StepScheduler_null();
+    StepScheduler_create_model( &stepscheduler, config.nblock_z, 1,
+                                config.nproc_x, config.nproc_y,
+                                config.nproc_z, nblock_octant,
+                                config.nproc_octant, proc_octant, 1,
+                                Bool_true );
+    const int nstep = StepScheduler_nstep( &stepscheduler );
+    result.nstep = nstep > result.nstep ? nstep : result.nstep;
+    StepScheduler_destroy( &stepscheduler );
+  }
+
+  /*---Every step costs as much as the largest block of the largest
+       proc---*/
+
+  const int ncell_x = iceil( dims_g.ncell_x, config.nproc_x );
+  const int ncell_y = iceil( dims_g.ncell_y, config.nproc_y );
+  const int ncell_z = iceil( iceil( dims_g.ncell_z, config.nproc_z ),
+                             config.nblock_z );
+  const int ne      = iceil( dims_g.ne, config.nproc_e );
+
+  const double nvalue_face = (double)ne * dims_g.na * NU * noctant_per_block;
+
+  result.time_block = model->time_solve * ncell_x * ncell_y * ncell_z *
+                      ne * dims_g.na * noctant_per_block;
+
+  /*---The step's faces are sent along each decomposed axis in turn;
+       along z only once per z block of the proc---*/
+
+  if( config.nproc_x > 1 )
+  {
+    result.time_comm += model->latency +
+      ncell_y * ncell_z * nvalue_face * sizeof(P) / model->bandwidth;
+  }
+  if( config.nproc_y > 1 )
+  {
+    result.time_comm += model->latency +
+      ncell_x * ncell_z * nvalue_face * sizeof(P) / model->bandwidth;
+  }
+  if( config.nproc_z > 1 )
+  {
+    result.time_comm += ( model->latency +
+      ncell_x * ncell_y * nvalue_face * sizeof(P) / model->bandwidth )
+                                                          / config.nblock_z;
+  }
+
+  result.time = niterations * result.nstep *
+                ( result.time_block + result.time_comm );
+
+  /*---Efficiency against the solves spread evenly with no idle steps---*/
+
+  const int nproc = config.nproc_x * config.nproc_y * config.nproc_z *
+                    config.nproc_e * config.nproc_octant;
+  const double time_ideal = niterations * model->time_solve *
+         (double)dims_g.ncell_x * dims_g.ncell_y * dims_g.ncell_z *
+                 dims_g.ne * dims_g.na * NOCTANT / nproc;
+
+  result.efficiency = result.time > 0 ? time_ideal / result.time : 0;
+
+  return result;
+}
+
+/*===========================================================================*/
+/*---Configuration with its prediction, for ranking---*/
+
+typedef struct
+{
+  PerfConfig     config;
+  PerfPrediction prediction;
+} PerfModel_case_;
+
+/*---------------------------------------------------------------------------*/
+
+static int PerfModel_compare_cases_( const void* p1, const void* p2 )
+{
+  const double time1 = ( (const PerfModel_case_*)p1 )->prediction.time;
+  const double time2 = ( (const PerfModel_case_*)p2 )->prediction.time;
+  return time1 < time2 ? -1 : time1 > time2 ? 1 : 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void PerfModel_print_case_( const char*            label,
+                                   const PerfModel_case_* c )
+{
+  printf( "%-8s nproc_x %5i  nproc_y %5i  nproc_z %4i  nblock_z %4i"
+          "  nstep %6i  time %.3e  efficiency %.3f\n",
+          label, c->config.nproc_x, c->config.nproc_y, c->config.nproc_z,
+          c->config.nblock_z, c->prediction.nstep, c->prediction.time,
+          c->prediction.efficiency );
+}
+
+/*===========================================================================*/
+/*---Rank the decompositions of a number of procs by predicted time---*/
+
+void PerfModel_advise( Arguments* args, Env* env )
+{
+  Dimensions dims_g;
+  PerfModel model = PerfModel_null();
+  PerfConfig config;
+
+  dims_g.ncell_x = Arguments_consume_int_or_default( args, "--ncell_x",  5 );
+  dims_g.ncell_y = Arguments_consume_int_or_default( args, "--ncell_y",  5 );
+  dims_g.ncell_z = Arguments_consume_int_or_default( args, "--ncell_z",  5 );
+  dims_g.ne   = Arguments_consume_int_or_default( args, "--ne", 30 );
+  dims_g.na   = Arguments_consume_int_or_default( args, "--na", 33 );
+  dims_g.nm   = NM;
+  const int niterations = Arguments_consume_int_or_default( args,
+                                                       "--niterations", 1 );
+
+  Insist( dims_g.ncell_x > 0 ? "Invalid ncell_x supplied." : 0 );
+  Insist( dims_g.ncell_y > 0 ? "Invalid ncell_y supplied." : 0 );
+  Insist( dims_g.ncell_z > 0 ? "Invalid ncell_z supplied." : 0 );
+  Insist( dims_g.ne > 0      ? "Invalid ne supplied." : 0 );
+  Insist( dims_g.na > 0      ? "Invalid na supplied." : 0 );
+  Insist( niterations >= 0   ? "Invalid iteration count supplied." : 0 );
+
+  /*---The configuration given is the first candidate---*/
+
+  config.nproc_x      = Env_nproc_x( env );
+  config.nproc_y      = Env_nproc_y( env );
+  config.nproc_z      = Env_nproc_z( env );
+  config.nproc_e      = Env_nproc_e( env );
+  config.nproc_octant = Env_nproc_octant( env );
+  config.nblock_z     = Arguments_consume_int_or_default( args,
+                                                         "--nblock_z", 1 );
+  config.nthread_octant = Arguments_consume_int_or_default( args,
+                                                    "--nthread_octant", 1 );
+  config.nthread_e    = Arguments_consume_int_or_default( args,
+                                                         "--nthread_e", 1 );
+  config.nthread_y    = Arguments_consume_int_or_default( args,
+                                                         "--nthread_y", 1 );
+  config.nthread_z    = Arguments_consume_int_or_default( args,
+                                                         "--nthread_z", 1 );
+
+  Insist( config.nblock_z > 0 ? "Invalid z blocking factor supplied." : 0 );
+  Insist( config.nthread_octant > 0 && NOCTANT % config.nthread_octant == 0
+          && NOCTANT % ( config.nthread_octant * config.nproc_octant ) == 0
+          ? "Invalid octant thread count supplied." : 0 );
+
+  /*---Procs to be decomposed along x, y and z---*/
+
+  const int nproc_xyz = Arguments_consume_int_or_default( args,
+      "--advise_nproc", config.nproc_x * config.nproc_y * config.nproc_z );
+  const int ntop = Arguments_consume_int_or_default( args,
+                                                     "--advise_ntop", 10 );
+
+  Insist( nproc_xyz > 0 ? "Invalid advise_nproc supplied." : 0 );
+
+  PerfModel_create( &model, dims_g, config, args, env );
+
+  Insist( Arguments_are_all_consumed( args )
+                                          ? "Invalid argument detected." : 0 );
+
+  if( ! Env_is_proc_master( env ) )
+  {
+    PerfModel_destroy( &model );
+    return;
+  }
+
+  /*---Enumerate decompositions and z blockings---*/
+
+  int ncase = 0;
+  int ncase_max = 64;
+  PerfModel_case_* cases = (PerfModel_case_*)
+                           malloc( ncase_max * sizeof(PerfModel_case_) );
+
+  int nproc_x = 0;
+  int nproc_y = 0;
+
+  for( nproc_x=1; nproc_x<=nproc_xyz; ++nproc_x )
+  for( nproc_y=1; nproc_y<=nproc_xyz/nproc_x; ++nproc_y )
+  {
+    if( nproc_xyz % ( nproc_x * nproc_y ) != 0 )
+    {
+      continue;
+    }
+    const int nproc_z = nproc_xyz / ( nproc_x * nproc_y );
+
+    if( nproc_x > dims_g.ncell_x || nproc_y > dims_g.ncell_y ||
+        nproc_z > dims_g.ncell_z )
+    {
+      continue;
+    }
+
+    /*---Candidate nblock_z: the powers of two up to ncell_z per proc,
+         plus ncell_z per proc itself---*/
+
+    const int ncell_z = dims_g.ncell_z / nproc_z;
+    int nblock_z = 1;
+
+    while( nblock_z <= ncell_z )
+    {
+      if( ncase == ncase_max )
+      {
+        ncase_max *= 2;
+        cases = (PerfModel_case_*)
+                realloc( cases, ncase_max * sizeof(PerfModel_case_) );
+      }
+
+      PerfModel_case_* const c = &cases[ncase++];
+      c->config          = config;
+      c->config.nproc_x  = nproc_x;
+      c->config.nproc_y  = nproc_y;
+      c->config.nproc_z  = nproc_z;
+      c->config.nblock_z = nblock_z;
+      c->prediction = PerfModel_predict( &model, dims_g, niterations,
+                                         c->config );
+
+      nblock_z = nblock_z == ncell_z ? ncell_z + 1 :
+                 2 * nblock_z > ncell_z ? ncell_z : 2 * nblock_z;
+    }
+  }
+
+  qsort( (void*)cases, ncase, sizeof(PerfModel_case_),
+                                                PerfModel_compare_cases_ );
+
+  /*---Output---*/
+
+  PerfModel_case_ case_given;
+  case_given.config = config;
+  case_given.prediction = PerfModel_predict( &model, dims_g, niterations,
+                                             config );
+
+  printf( "Model: time_solve %.3e  latency %.3e  bandwidth %.3e\n",
+          model.time_solve, model.latency, model.bandwidth );
+  PerfModel_print_case_( "given", &case_given );
+
+  int i = 0;
+  for( i=0; i<ncase && i<ntop; ++i )
+  {
+    char label[16];
+    sprintf( label, "rank %i", i+1 );
+    PerfModel_print_case_( label, &cases[i] );
+  }
+
+  free( (void*) cases );
+
+  PerfModel_destroy( &model );
+}
+
+/*===========================================================================*/
+
+#ifdef __cplusplus_IGNORE
+} /*---extern "C"---*/
+#endif
+
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,103 @@
+/*---------------------------------------------------------------------------*/
+/*!
+ * \file   perfmodel.h
+ * \author agent
+ * \date   Mon Oct 19 03:16:57 UTC 2026
+ * \brief  Analytic performance model of the KBA sweep, header.
+ */
+/*---------------------------------------------------------------------------*/
+
+#ifndef _perfmodel_h_
+#define _perfmodel_h_
+
+#include "arguments.h"
+#include "env.h"
+#include "definitions.h"
+#include "dimensions.h"
+
+#ifdef __cplusplus_IGNORE
+extern "C"
+{
+#endif
+
+/*===========================================================================*/
+/*---Struct with measured machine parameters of the model---*/
+
+typedef struct
+{
+  double time_solve;   /*---Secs per cell, energy, angle, octant solved---*/
+  double latency;      /*---Secs per face message---*/
+  double bandwidth;    /*---Bytes per sec of face messages---*/
+} PerfModel;
+
+/*===========================================================================*/
+/*---Struct with a configuration of a run to be modeled---*/
+
+typedef struct
+{
+  int nproc_x;
+  int nproc_y;
+  int nproc_z;
+  int nproc_e;
+  int nproc_octant;
+  int nblock_z;
+  int nthread_octant;
+  int nthread_e;        /*---Other threads, used only to measure solves---*/
+  int nthread_y;
+  int nthread_z;
+} PerfConfig;
+
+/*===========================================================================*/
+/*---Struct with predicted performance of a configuration---*/
+
+typedef struct
+{
+  int    nstep;        /*---KBA steps per iteration---*/
+  double time_block;   /*---Secs to compute the block of one step---*/
+  double time_comm;    /*---Secs to communicate the faces of one step---*/
+  double time;         /*---Secs for all iterations---*/
+  double efficiency;   /*---Parallel efficiency---*/
+} PerfPrediction;
+
+/*===========================================================================*/
+/*---Null object---*/
+
+PerfModel PerfModel_null(void);
+
+/*===========================================================================*/
+/*---Pseudo-constructor: take machine parameters from args, or measure
+     those not given---*/
+
+void PerfModel_create( PerfModel*  model,
+                       Dimensions  dims_g,
+                       PerfConfig  config,
+                       Arguments*  args,
+                       Env*        env );
+
+/*===========================================================================*/
+/*---Pseudo-destructor---*/
+
+void PerfModel_destroy( PerfModel* model );
+
+/*===========================================================================*/
+/*---Predict the time of a run---*/
+
+PerfPrediction PerfModel_predict( const PerfModel* model,
+                                  Dimensions       dims_g,
+                                  int              niterations,
+                                  PerfConfig       config );
+
+/*===========================================================================*/
+/*---Rank the decompositions of a number of procs by predicted time---*/
+
+void PerfModel_advise( Arguments* args, Env* env );
+
+/*===========================================================================*/
+
+#ifdef __cplusplus_IGNORE
+} /*---extern "C"---*/
+#endif
+
+#endif /*---_perfmodel_h_---*/
+
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,296 @@
+/*---------------------------------------------------------------------------*/
+/*!
+ * \file   results.cpp
+ * \author agent
+ * \date   Mon Oct 19 03:44:45 UTC 2026
+ * \brief  Writing of run results as JSON.
+ */
+/*---------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arguments.h"
+#include "env.h"
+#include "definitions.h"
+#include "sweeper.h"
+#include "profiler.h"
+#include "counters.h"
+#include "runner.h"
+
+#include "results.h"
+
+/*===========================================================================*/
+/*---Write a number as a JSON value, null if not finite---*/
+
+static void Results_write_json_number_( FILE* file, double value )
+{
+  if( value - value == 0 )
+  {
+    fprintf( file, "%.17g", value );
+  }
+  else
+  {
+    fprintf( file, "null" );
+  }
+}
+
+/*===========================================================================*/
+/*---Write a string as a JSON value, null if NULL---*/
+
+void Results_write_json_string( FILE* file, const char* s )
+{
+  Assert( file );
+
+  if( ! s )
+  {
+    fprintf( file, "null" );
+    return;
+  }
+
+  fputc( '"', file );
+  for( ; *s; ++s )
+  {
+    if( *s == '"' || *s == '\\' )
+    {
+      fprintf( file, "\\%c", *s );
+    }
+    else if( (unsigned char)*s < 0x20 )
+    {
+      fprintf( file, "\\u%04x", (unsigned char)*s );
+    }
+    else
+    {
+      fputc( *s, file );
+    }
+  }
+  fputc( '"', file );
+}
+
+/*===========================================================================*/
+/*---Write a member with a flag value---*/
+
+static void Results_write_json_flag_( FILE*       file,
+                                      const char* name,
+                                      Bool_t      value )
+{
+  fprintf( file, ",\n    \"%s\": %s", name, value ? "true" : "false" );
+}
+
+/*===========================================================================*/
+/*---Begin a JSON results object: the program, the build settings and the
+     args consumed, including those defaulted---*/
+
+void Results_write_json_begin( FILE*            file,
+                               const char*      program,
+                               const Arguments* args )
+{
+  Assert( file );
+  Assert( program );
+  Assert( args );
+
+  int i = 0;
+
+  fprintf( file, "{\n  \"program\": " );
+  Results_write_json_string( file, program );
+
+  /*---Build settings---*/
+
+  fprintf( file, ",\n  \"build\": {" );
+  fprintf( file, "\n    \"NM\": %i,\n    \"NU\": %i", NM, NU );
+  fprintf( file, ",\n    \"sizeof_P\": %i", (int)sizeof(P) );
+#ifdef SWEEPER_KBA
+  fprintf( file, ",\n    \"sweeper\": \"kba\"" );
+#endif
+#ifdef SWEEPER_SIMPLE
+  fprintf( file, ",\n    \"sweeper\": \"simple\"" );
+#endif
+#ifdef SWEEPER_TILEOCTANTS
+  fprintf( file, ",\n    \"sweeper\": \"tileoctants\"" );
+#endif
+
+#ifdef USE_MPI
+  Results_write_json_flag_( file, "USE_MPI", Bool_true );
+#else
+  Results_write_json_flag_( file, "USE_MPI", Bool_false );
+#endif
+#ifdef USE_OPENMP
+  Results_write_json_flag_( file, "USE_OPENMP", Bool_true );
+#else
+  Results_write_json_flag_( file, "USE_OPENMP", Bool_false );
+#endif
+#ifdef USE_OPENMP_THREADS
+  Results_write_json_flag_( file, "USE_OPENMP_THREADS", Bool_true );
+#else
+  Results_write_json_flag_( file, "USE_OPENMP_THREADS", Bool_false );
+#endif
+#ifdef USE_OPENMP_TASKS
+  Results_write_json_flag_( file, "USE_OPENMP_TASKS", Bool_true );
+#else
+  Results_write_json_flag_( file, "USE_OPENMP_TASKS", Bool_false );
+#endif
+#ifdef USE_OPENMP_VO_ATOMIC
+  Results_write_json_flag_( file, "USE_OPENMP_VO_ATOMIC", Bool_true );
+#else
+  Results_write_json_flag_( file, "USE_OPENMP_VO_ATOMIC", Bool_false );
+#endif
+#ifdef USE_HIP
+  Results_write_json_flag_( file, "USE_HIP", Bool_true );
+#else
+  Results_write_json_flag_( file, "USE_HIP", Bool_false );
+#endif
+  Results_write_json_flag_( file, "USE_PROFILER", IS_USING_PROFILER );
+  Results_write_json_flag_( file, "USE_PERF_EVENT", IS_USING_PERF_EVENT );
+#ifdef NDEBUG
+  Results_write_json_flag_( file, "NDEBUG", Bool_true );
+#else
+  Results_write_json_flag_( file, "NDEBUG", Bool_false );
+#endif
+  fprintf( file, "\n  }" );
+
+  /*---Args, numbers where they parse as such; if an arg was consumed
+       more than once the first is kept---*/
+
+  fprintf( file, ",\n  \"args\": {" );
+  for( i=0; i<Arguments_nconsumed( args ); ++i )
+  {
+    const char* name = Arguments_consumed_name( args, i );
+    const char* value = Arguments_consumed_value( args, i );
+    Bool_t is_repeated = Bool_false;
+    int j = 0;
+    for( j=0; j<i; ++j )
+    {
+      is_repeated = is_repeated ||
+                    strcmp( name, Arguments_consumed_name( args, j ) ) == 0;
+    }
+    if( is_repeated )
+    {
+      continue;
+    }
+
+    fprintf( file, "%s\n    ", i == 0 ? "" : "," );
+    Results_write_json_string( file, name );
+    fprintf( file, ": " );
+
+    char* end = NULL;
+    const double value_number = value ? strtod( value, &end ) : 0;
+    if( value && *value && ! *end )
+    {
+      Results_write_json_number_( file, value_number );
+    }
+    else
+    {
+      Results_write_json_string( file, value );
+    }
+  }
+  fprintf( file, "\n  }" );
+}
+
+/*===========================================================================*/
+/*---Write the result of a run as a member of the object---*/
+
+void Results_write_json_runner( FILE*         file,
+                                const char*   key,
+                                const Runner* runner )
+{
+  Assert( file );
+  Assert( key );
+  Assert( runner );
+
+  int i = 0;
+
+  fprintf( file, ",\n  " );
+  Results_write_json_string( file, key );
+  fprintf( file, ": {\n    \"normsq\": " );
+  Results_write_json_number_( file, (double)runner->normsq );
+  fprintf( file, ",\n    \"normsqdiff\": " );
+  Results_write_json_number_( file, (double)runner->normsqdiff );
+  fprintf( file, ",\n    \"pass\": %s",
+           runner->normsqdiff == P_zero() ? "true" : "false" );
+  fprintf( file, ",\n    \"time\": " );
+  Results_write_json_number_( file, (double)runner->time );
+  fprintf( file, ",\n    \"flops\": " );
+  Results_write_json_number_( file, runner->flops );
+  fprintf( file, ",\n    \"floprate\": " );
+  Results_write_json_number_( file, runner->floprate );
+  fprintf( file, ",\n    \"bytes\": " );
+  Results_write_json_number_( file, runner->bytes );
+  fprintf( file, ",\n    \"bytes_comm\": " );
+  Results_write_json_number_( file, runner->bytes_comm );
+  fprintf( file, ",\n    \"byterate\": " );
+  Results_write_json_number_( file, runner->byterate );
+  fprintf( file, ",\n    \"mem_bandwidth\": " );
+  Results_write_json_number_( file, runner->mem_bandwidth );
+  fprintf( file, ",\n    \"time_idle_saved\": " );
+  Results_write_json_number_( file, (double)runner->time_idle_saved );
+  fprintf( file, ",\n    \"time_rebalance\": " );
+  Results_write_json_number_( file, (double)runner->time_rebalance );
+  fprintf( file, ",\n    \"nrebalance\": %i", runner->nrebalance );
+  fprintf( file, ",\n    \"niterations\": %i", runner->niterations );
+  fprintf( file, ",\n    \"time_iter\": { \"min\": " );
+  Results_write_json_number_( file, (double)runner->time_iter_min );
+  fprintf( file, ", \"median\": " );
+  Results_write_json_number_( file, (double)runner->time_iter_median );
+  fprintf( file, ", \"mean\": " );
+  Results_write_json_number_( file, (double)runner->time_iter_mean );
+  fprintf( file, ", \"stddev\": " );
+  Results_write_json_number_( file, (double)runner->time_iter_stddev );
+  fprintf( file, ", \"max\": " );
+  Results_write_json_number_( file, (double)runner->time_iter_max );
+  fprintf( file, " }" );
+  fprintf( file, ",\n    \"time_proc\": { \"min\": " );
+  Results_write_json_number_( file, (double)runner->time_proc_min );
+  fprintf( file, ", \"mean\": " );
+  Results_write_json_number_( file, (double)runner->time_proc_mean );
+  fprintf( file, ", \"stddev\": " );
+  Results_write_json_number_( file, (double)runner->time_proc_stddev );
+  fprintf( file, ", \"max\": " );
+  Results_write_json_number_( file, (double)runner->time_proc_max );
+  fprintf( file, " }" );
+  fprintf( file, ",\n    \"balance\": { \"time_compute_mean\": " );
+  Results_write_json_number_( file, (double)runner->time_compute_mean );
+  fprintf( file, ", \"time_compute_max\": " );
+  Results_write_json_number_( file, (double)runner->time_compute_max );
+  fprintf( file, ", \"proc_compute_max\": %i", runner->proc_compute_max );
+  fprintf( file, ", \"time_wait_mean\": " );
+  Results_write_json_number_( file, (double)runner->time_wait_mean );
+  fprintf( file, ", \"time_wait_max\": " );
+  Results_write_json_number_( file, (double)runner->time_wait_max );
+  fprintf( file, ", \"step_idle_fraction\": " );
+  Results_write_json_number_( file, runner->step_idle_fraction );
+  fprintf( file, " }" );
+
+  fprintf( file, ",\n    \"comm\": { \"nmsg_axis\": [" );
+  for( i=0; i<ENV_COMM_NAXIS; ++i )
+  {
+    fprintf( file, "%s%.0f", i == 0 ? "" : ", ", runner->comm.nmsg_axis[i] );
+  }
+  fprintf( file, "], \"bytes_axis\": [" );
+  for( i=0; i<ENV_COMM_NAXIS; ++i )
+  {
+    fprintf( file, "%s%.0f", i == 0 ? "" : ", ", runner->comm.bytes_axis[i] );
+  }
+  fprintf( file, "],\n      \"nmsg_bin\": [" );
+  for( i=0; i<ENV_COMM_NBIN; ++i )
+  {
+    fprintf( file, "%s%.0f", i == 0 ? "" : ", ", runner->comm.nmsg_bin[i] );
+  }
+  fprintf( file, "],\n      \"bytes_peer_max\": %.0f",
+           runner->comm.bytes_peer_max );
+  fprintf( file, ", \"proc_peer_max\": %i, \"peer_max\": %i }",
+           runner->comm.proc_peer_max, runner->comm.peer_max );
+  fprintf( file, "\n  }" );
+}
+
+/*===========================================================================*/
+/*---End the JSON results object---*/
+
+void Results_write_json_end( FILE* file )
+{
+  Assert( file );
+
+  fprintf( file, "\n}\n" );
+}
+
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,58 @@
+/*---------------------------------------------------------------------------*/
+/*!
+ * \file   results.h
+ * \author agent
+ * \date   Mon Oct 19 03:44:45 UTC 2026
+ * \brief  Writing of run results as JSON, header.
+ */
+/*---------------------------------------------------------------------------*/
+
+#ifndef _results_h_
+#define _results_h_
+
+#include <stdio.h>
+
+#include "arguments.h"
+#include "env.h"
+#include "definitions.h"
+#include "runner.h"
+
+#ifdef __cplusplus_IGNORE
+extern "C"
+{
+#endif
+
+/*===========================================================================*/
+/*---Write a string as a JSON value, null if NULL---*/
+
+void Results_write_json_string( FILE* file, const char* s );
+
+/*===========================================================================*/
+/*---Begin a JSON results object: the program, the build settings and the
+     args consumed, including those defaulted---*/
+
+void Results_write_json_begin( FILE*            file,
+                               const char*      program,
+                               const Arguments* args );
+
+/*===========================================================================*/
+/*---Write the result of a run as a member of the object---*/
+
+void Results_write_json_runner( FILE*         file,
+                                const char*   key,
+                                const Runner* runner );
+
+/*===========================================================================*/
+/*---End the JSON results object---*/
+
+void Results_write_json_end( FILE* file );
+
+/*===========================================================================*/
+
+#ifdef __cplusplus_IGNORE
+} /*---extern "C"---*/
+#endif
+
+#endif /*---_results_h_---*/
+
+/*---------------------------------------------------------------------------*/
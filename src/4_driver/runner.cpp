@@ -9,15 +9,22 @@
 /*---------------------------------------------------------------------------*/
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
 
 #include "arguments.h"
 #include "env.h"
 #include "definitions.h"
 #include "dimensions.h"
+#include "array_accessors.h"
 #include "pointer.h"
 #include "quantities.h"
 #include "array_operations.h"
 #include "sweeper.h"
+#include "profiler.h"
+#include "counters.h"
+#include "memtracker.h"
 
 #include "runner.h"
 
@@ -43,6 +50,631 @@ void Runner_create( Runner* runner )
 
 void Runner_destroy( Runner* runner )
 {
+  Pointer_destroy( &runner->vi );
+  Pointer_destroy( &runner->vo );
+  runner->size_state = 0;
+}
+
+/*===========================================================================*/
+/*---Parse a comma-separated list of values---*/
+
+static void Runner_parse_list_( double*     values,
+                                int         n,
+                                const char* string )
+{
+  const char* s = string;
+  int i = 0;
+
+  for( i=0; i<n; ++i )
+  {
+    char* end = NULL;
+    values[i] = strtod( s, &end );
+    Insist( end != s ? "Invalid value list supplied." : 0 );
+    s = *end == ',' ? end + 1 : end;
+  }
+
+  Insist( *s == 0 ? "Invalid value list length supplied." : 0 );
+}
+
+/*===========================================================================*/
+/*---Read the decomposition file on master proc, broadcast to all---*/
+
+static char* Runner_read_decomp_file_( const char* filename,
+                                       Env*        env )
+{
+  FILE* file = NULL;
+  int len = 0;
+
+  if( Env_is_proc_master( env ) )
+  {
+    file = fopen( filename, "r" );
+    Insist( file ? "Unable to open decomposition file." : 0 );
+    fseek( file, 0, SEEK_END );
+    len = (int)ftell( file );
+    fseek( file, 0, SEEK_SET );
+  }
+  Env_bcast_int( env, &len, 0 );
+
+  char* contents = (char*) malloc( ( len + 1 ) * sizeof( char ) );
+
+  if( Env_is_proc_master( env ) )
+  {
+    const size_t nread = fread( contents, sizeof( char ), len, file );
+    Insist( nread == (size_t)len ? "Error reading decomposition file." : 0 );
+    fclose( file );
+  }
+  Env_bcast_string( env, contents, len, 0 );
+  contents[len] = 0;
+
+  return contents;
+}
+
+/*===========================================================================*/
+/*---Look up entry of decomposition file, e.g. "weights_x 1 2 1"---*/
+
+static Bool_t Runner_find_decomp_entry_( double*     values,
+                                         int         n,
+                                         const char* contents,
+                                         const char* key )
+{
+  const char* s = contents;
+  char token[64];
+  int len = 0;
+  int i = 0;
+
+  while( sscanf( s, "%63s%n", token, &len ) == 1 )
+  {
+    s += len;
+    if( strcmp( token, key ) == 0 )
+    {
+      for( i=0; i<n; ++i )
+      {
+        Insist( sscanf( s, "%lf%n", &values[i], &len ) == 1
+                                  ? "Invalid decomposition file entry." : 0 );
+        s += len;
+      }
+      return Bool_true;
+    }
+  }
+
+  return Bool_false;
+}
+
+/*===========================================================================*/
+/*---Set cut positions along an axis so part sizes follow the weights---*/
+
+static void Runner_set_cuts_from_weights_( int*          cuts,
+                                           int           ncell,
+                                           int           nproc,
+                                           const double* weights )
+{
+  Insist( ncell >= nproc ? "Too few cells for weighted decomposition." : 0 );
+
+  double weight_sum = 0;
+  double weight_partial = 0;
+  int i = 0;
+
+  for( i=0; i<nproc; ++i )
+  {
+    Insist( weights[i] > 0 ? "Invalid decomposition weight supplied." : 0 );
+    weight_sum += weights[i];
+  }
+
+  cuts[0] = 0;
+  for( i=1; i<nproc; ++i )
+  {
+    weight_partial += weights[i-1];
+    const int cut = (int)( ncell * ( weight_partial / weight_sum ) + .5 );
+
+    /*---Keep every part nonempty---*/
+    const int cut_min = cuts[i-1] + 1;
+    const int cut_max = ncell - ( nproc - i );
+    cuts[i] = cut < cut_min ? cut_min : cut > cut_max ? cut_max : cut;
+  }
+  cuts[nproc] = ncell;
+}
+
+/*===========================================================================*/
+/*---Set cut positions along an axis from args, file or even split---*/
+
+static void Runner_set_cuts_( int*        cuts,
+                              int         ncell,
+                              int         nproc,
+                              const char* axis_name,
+                              const char* contents,
+                              Arguments*  args )
+{
+  char name[64];
+  double* values = (double*) malloc( nproc * sizeof( double ) );
+  int i = 0;
+
+  sprintf( name, "--cuts_%s", axis_name );
+  const char* cuts_string = Arguments_consume_string_or_default(
+                                                           args, name, NULL );
+  sprintf( name, "--weights_%s", axis_name );
+  const char* weights_string = Arguments_consume_string_or_default(
+                                                           args, name, NULL );
+
+  sprintf( name, "cuts_%s", axis_name );
+  Bool_t is_cuts = Bool_false;
+  if( cuts_string )
+  {
+    Runner_parse_list_( values, nproc-1, cuts_string );
+    is_cuts = Bool_true;
+  }
+  else if( ! weights_string && contents )
+  {
+    is_cuts = Runner_find_decomp_entry_( values, nproc-1, contents, name );
+  }
+
+  sprintf( name, "weights_%s", axis_name );
+  Bool_t is_weights = Bool_false;
+  if( ! is_cuts && weights_string )
+  {
+    Runner_parse_list_( values, nproc, weights_string );
+    is_weights = Bool_true;
+  }
+  else if( ! is_cuts && contents )
+  {
+    is_weights = Runner_find_decomp_entry_( values, nproc, contents, name );
+  }
+
+  if( is_cuts )
+  {
+    /*---Interior cut positions given explicitly---*/
+    cuts[0] = 0;
+    for( i=1; i<nproc; ++i )
+    {
+      cuts[i] = (int)values[i-1];
+    }
+    cuts[nproc] = ncell;
+    for( i=0; i<nproc; ++i )
+    {
+      Insist( cuts[i] < cuts[i+1] ? "Invalid cut positions supplied." : 0 );
+    }
+  }
+  else if( is_weights )
+  {
+    Runner_set_cuts_from_weights_( cuts, ncell, nproc, values );
+  }
+  else
+  {
+    /*---Default: split as evenly as possible---*/
+    for( i=0; i<=nproc; ++i )
+    {
+      cuts[i] = ( i * ncell ) / nproc;
+    }
+  }
+
+  free( (void*) values );
+}
+
+/*===========================================================================*/
+/*---Set cut positions along x and y, return the dims of the part of the
+     problem on this proc---*/
+
+static Dimensions Runner_dims_this_( int*        cuts_x,
+                                     int*        cuts_y,
+                                     Dimensions  dims_g,
+                                     const char* decomp_file,
+                                     Arguments*  args,
+                                     Env*        env )
+{
+  Dimensions dims = dims_g;
+
+  char* decomp_contents = decomp_file ?
+                          Runner_read_decomp_file_( decomp_file, env ) : NULL;
+
+  Runner_set_cuts_( cuts_x, dims_g.ncell_x, Env_nproc_x( env ), "x",
+                                                     decomp_contents, args );
+  Runner_set_cuts_( cuts_y, dims_g.ncell_y, Env_nproc_y( env ), "y",
+                                                     decomp_contents, args );
+
+  if( decomp_contents )
+  {
+    free( (void*) decomp_contents );
+  }
+
+  dims.ncell_x = cuts_x[ Env_proc_x_this( env ) + 1 ]
+               - cuts_x[ Env_proc_x_this( env )     ];
+
+  dims.ncell_y = cuts_y[ Env_proc_y_this( env ) + 1 ]
+               - cuts_y[ Env_proc_y_this( env )     ];
+
+  dims.ncell_z =
+      ( ( Env_proc_z_this( env ) + 1 ) * dims_g.ncell_z ) / Env_nproc_z( env )
+    - ( ( Env_proc_z_this( env )     ) * dims_g.ncell_z ) / Env_nproc_z( env );
+
+  /*---Energy groups are split across groups of procs, each group having
+       its own spatial decomposition---*/
+
+  Insist( dims_g.ne >= Env_nproc_e( env ) ?
+                             "Too few energy groups for nproc_e." : 0 );
+
+  dims.ne =
+      ( ( Env_proc_e_this( env ) + 1 ) * dims_g.ne ) / Env_nproc_e( env )
+    - ( ( Env_proc_e_this( env )     ) * dims_g.ne ) / Env_nproc_e( env );
+
+  return dims;
+}
+
+/*===========================================================================*/
+/*---Compute new cut positions along an axis from the measured time of
+     each slab of procs along it---*/
+
+static Bool_t Runner_rebalance_cuts_( int*          cuts_new,
+                                      const int*    cuts,
+                                      int           nproc,
+                                      const double* times_slab )
+{
+  double* weights = (double*) malloc( nproc * sizeof( double ) );
+  Bool_t is_time_valid = Bool_true;
+  Bool_t is_changed = Bool_false;
+  double rate_sum = 0;
+  int i = 0;
+
+  /*---Processing rate of each slab of procs along the axis---*/
+
+  for( i=0; i<nproc; ++i )
+  {
+    is_time_valid = is_time_valid && times_slab[i] > 0;
+    weights[i] = is_time_valid ? ( cuts[i+1] - cuts[i] ) / times_slab[i] : 0;
+    rate_sum += weights[i];
+  }
+
+  for( i=0; i<=nproc; ++i )
+  {
+    cuts_new[i] = cuts[i];
+  }
+
+  if( is_time_valid )
+  {
+    /*---Move halfway toward the measured rates to damp oscillation---*/
+    for( i=0; i<nproc; ++i )
+    {
+      weights[i] = .5 * weights[i] / rate_sum
+                 + .5 * ( cuts[i+1] - cuts[i] ) / (double)cuts[nproc];
+    }
+    Runner_set_cuts_from_weights_( cuts_new, cuts[nproc], nproc, weights );
+  }
+
+  for( i=0; i<=nproc; ++i )
+  {
+    is_changed = is_changed || cuts_new[i] != cuts[i];
+  }
+
+  free( (void*) weights );
+
+  return is_changed;
+}
+
+/*===========================================================================*/
+/*---Copy cell range along an axis between state array and buffer---*/
+
+static size_t Runner_copy_state_range_( P*         buf,
+                                        P*         v,
+                                        Dimensions dims,
+                                        int        axis,
+                                        int        i_min,
+                                        int        i_max,
+                                        Bool_t     is_to_buf )
+{
+  const int ix_min = axis == 0 ? i_min : 0;
+  const int ix_max = axis == 0 ? i_max : dims.ncell_x;
+  const int iy_min = axis == 1 ? i_min : 0;
+  const int iy_max = axis == 1 ? i_max : dims.ncell_y;
+
+  const size_t n = ( ix_max - ix_min ) * (size_t)( dims.nm * NU );
+  size_t offset = 0;
+
+  int iz = 0;
+  int ie = 0;
+  int iy = 0;
+
+  /*---Cells contiguous in x, along with all moments and unknowns---*/
+
+  for( iz=0;      iz<dims.ncell_z; ++iz )
+  for( ie=0;      ie<dims.ne;      ++ie )
+  for( iy=iy_min; iy<iy_max;       ++iy )
+  {
+    P* const v_cells = ref_state( v, dims, NU, ix_min, iy, iz, ie, 0, 0 );
+    if( is_to_buf )
+    {
+      memcpy( buf + offset, v_cells, n * sizeof( P ) );
+    }
+    else
+    {
+      memcpy( v_cells, buf + offset, n * sizeof( P ) );
+    }
+    offset += n;
+  }
+
+  return offset;
+}
+
+/*===========================================================================*/
+/*---Move state array to a new decomposition along one axis---*/
+
+static void Runner_migrate_state_( Pointer*   v,
+                                   Dimensions dims,
+                                   Dimensions dims_new,
+                                   const int* cuts,
+                                   const int* cuts_new,
+                                   int        axis,
+                                   Env*       env )
+{
+  const int nproc     = axis == 0 ? Env_nproc_x( env ) : Env_nproc_y( env );
+  const int proc_this = axis == 0 ? Env_proc_x_this( env )
+                                  : Env_proc_y_this( env );
+  const int tag = Env_tag( env );
+
+  Pointer v_new = Pointer_null();
+  Pointer_create( &v_new, Dimensions_size_state( dims_new, NU ),
+                                            Env_hip_is_using_device( env ) );
+  Pointer_set_pinned( &v_new, Bool_true );
+  Pointer_set_category( &v_new, MEMTRACKER_STATE );
+  Pointer_allocate( &v_new );
+
+  P* const buf_send = malloc_host_P( Dimensions_size_state( dims, NU ) );
+  P* const buf_recv = malloc_host_P( Dimensions_size_state( dims_new, NU ) );
+  const size_t nbyte_bufs = sizeof(P) * ( Dimensions_size_state( dims, NU ) +
+                                      Dimensions_size_state( dims_new, NU ) );
+  MemTracker_allocate( MEMTRACKER_STATE, nbyte_bufs, Bool_false );
+
+  Request_t* request_send = (Request_t*) malloc( nproc * sizeof( Request_t ) );
+  Request_t* request_recv = (Request_t*) malloc( nproc * sizeof( Request_t ) );
+
+  size_t offset_send = 0;
+  size_t offset_recv = 0;
+  int p = 0;
+
+  /*---Exchange overlaps of old and new cell ranges with each proc---*/
+
+  for( p=0; p<nproc; ++p )
+  {
+    const int proc = axis == 0 ?
+      Env_proc( env, p, Env_proc_y_this( env ), Env_proc_z_this( env ) ) :
+      Env_proc( env, Env_proc_x_this( env ), p, Env_proc_z_this( env ) );
+
+    const int send_min = cuts[proc_this] > cuts_new[p] ?
+                         cuts[proc_this] : cuts_new[p];
+    const int send_max = cuts[proc_this+1] < cuts_new[p+1] ?
+                         cuts[proc_this+1] : cuts_new[p+1];
+    const int recv_min = cuts_new[proc_this] > cuts[p] ?
+                         cuts_new[proc_this] : cuts[p];
+    const int recv_max = cuts_new[proc_this+1] < cuts[p+1] ?
+                         cuts_new[proc_this+1] : cuts[p+1];
+
+    if( recv_min < recv_max )
+    {
+      const size_t n = ( Dimensions_size_state( dims_new, NU ) /
+                         ( cuts_new[proc_this+1] - cuts_new[proc_this] ) ) *
+                       ( recv_max - recv_min );
+      Env_arecv_P( env, buf_recv + offset_recv, n, proc, tag,
+                                                          &request_recv[p] );
+      offset_recv += n;
+    }
+
+    if( send_min < send_max )
+    {
+      const size_t n = Runner_copy_state_range_( buf_send + offset_send,
+        Pointer_h( v ), dims, axis, send_min - cuts[proc_this],
+                                    send_max - cuts[proc_this], Bool_true );
+      Env_asend_P( env, buf_send + offset_send, n, proc, tag,
+                                                          &request_send[p] );
+      offset_send += n;
+    }
+  }
+
+  offset_recv = 0;
+
+  for( p=0; p<nproc; ++p )
+  {
+    const int recv_min = cuts_new[proc_this] > cuts[p] ?
+                         cuts_new[proc_this] : cuts[p];
+    const int recv_max = cuts_new[proc_this+1] < cuts[p+1] ?
+                         cuts_new[proc_this+1] : cuts[p+1];
+
+    if( recv_min < recv_max )
+    {
+      Env_wait( env, &request_recv[p] );
+      offset_recv += Runner_copy_state_range_( buf_recv + offset_recv,
+        Pointer_h( &v_new ), dims_new, axis, recv_min - cuts_new[proc_this],
+                               recv_max - cuts_new[proc_this], Bool_false );
+    }
+  }
+
+  for( p=0; p<nproc; ++p )
+  {
+    const int send_min = cuts[proc_this] > cuts_new[p] ?
+                         cuts[proc_this] : cuts_new[p];
+    const int send_max = cuts[proc_this+1] < cuts_new[p+1] ?
+                         cuts[proc_this+1] : cuts_new[p+1];
+
+    if( send_min < send_max )
+    {
+      Env_wait( env, &request_send[p] );
+    }
+  }
+
+  Env_increment_tag( env, 1 );
+
+  free( (void*) request_send );
+  free( (void*) request_recv );
+  free_host_P( buf_send );
+  free_host_P( buf_recv );
+  MemTracker_free( MEMTRACKER_STATE, nbyte_bufs, Bool_false );
+
+  Pointer_destroy( v );
+  *v = v_new;
+}
+
+/*===========================================================================*/
+/*---Bytes moved by this proc per iteration, by an analytic model---*/
+
+/*---For each octant the state is read and the result read and written,
+     the xz and yz face arrays are read and written once, the xy face
+     array once per z block, the moment-angle matrices are loaded once per
+     z block, and the faces leaving the proc for its downstream neighbors
+     are sent---*/
+
+static void Runner_traffic_( double*     bytes,
+                             double*     bytes_comm,
+                             Dimensions  dims,
+                             int         nblock_z,
+                             Env*        env )
+{
+  const double size_facexy = Dimensions_size_facexy( dims, NU, 1 );
+  const double size_facexz = Dimensions_size_facexz( dims, NU, 1 );
+  const double size_faceyz = Dimensions_size_faceyz( dims, NU, 1 );
+
+  int octant = 0;
+
+  *bytes      = 0;
+  *bytes_comm = 0;
+
+  for( octant=0; octant<NOCTANT; ++octant )
+  {
+    *bytes += sizeof(P) * ( 3. * Dimensions_size_state( dims, NU )
+                          + 2. * size_facexy * nblock_z
+                          + 2. * size_facexz
+                          + 2. * size_faceyz
+                          + 2. * NM * dims.na * nblock_z );
+
+    const Bool_t is_sending_x = Dir_x( octant ) == DIR_UP ?
+      Env_proc_x_this( env ) < Env_nproc_x( env ) - 1 :
+      Env_proc_x_this( env ) > 0;
+    const Bool_t is_sending_y = Dir_y( octant ) == DIR_UP ?
+      Env_proc_y_this( env ) < Env_nproc_y( env ) - 1 :
+      Env_proc_y_this( env ) > 0;
+    const Bool_t is_sending_z = Dir_z( octant ) == DIR_UP ?
+      Env_proc_z_this( env ) < Env_nproc_z( env ) - 1 :
+      Env_proc_z_this( env ) > 0;
+
+    *bytes_comm += sizeof(P) * ( ( is_sending_x ? size_faceyz : 0 )
+                               + ( is_sending_y ? size_facexz : 0 )
+                               + ( is_sending_z ? size_facexy : 0 ) );
+  }
+}
+
+/*===========================================================================*/
+/*---Measure memory bandwidth of this proc, in bytes per sec, by a
+     STREAM-like triad run by all procs at once---*/
+
+static double Runner_measure_mem_bandwidth_( Env* env )
+{
+  /*---Arrays well beyond cache size---*/
+  enum{ N = 1 << 22 };
+  enum{ NREP = 5 };
+
+  P* const a = malloc_host_P( N );
+  P* const b = malloc_host_P( N );
+  P* const c = malloc_host_P( N );
+  const P scalar = (P)3;
+
+  Timer time_min = 0;
+  int i = 0;
+  int rep = 0;
+
+  for( i=0; i<N; ++i )
+  {
+    a[i] = P_zero();
+    b[i] = P_one();
+    c[i] = P_one() + P_one();
+  }
+
+  for( rep=0; rep<NREP; ++rep )
+  {
+    const Timer t1 = Env_get_synced_time( env );
+#ifdef USE_OPENMP
+#pragma omp parallel for
+#endif
+    for( i=0; i<N; ++i )
+    {
+      a[i] = b[i] + scalar * c[i];
+    }
+    const Timer time = Env_get_time( env ) - t1;
+    time_min = rep == 0 || time < time_min ? time : time_min;
+  }
+
+  free_host_P( a );
+  free_host_P( b );
+  free_host_P( c );
+
+  return time_min <= (Timer)0 ? 0 : 3. * N * sizeof(P) / time_min;
+}
+
+/*===========================================================================*/
+/*---Compare times, for sorting---*/
+
+static int Runner_compare_times_( const void* a, const void* b )
+{
+  const Timer ta = *(const Timer*)a;
+  const Timer tb = *(const Timer*)b;
+  return ta < tb ? -1 : ta > tb ? 1 : 0;
+}
+
+/*===========================================================================*/
+/*---Mean and sample standard deviation of iteration times---*/
+
+static void Runner_mean_stddev_( Timer*       mean,
+                                 Timer*       stddev,
+                                 const Timer* times,
+                                 int          n )
+{
+  Timer sum = 0;
+  Timer sumsq = 0;
+  int i = 0;
+
+  for( i=0; i<n; ++i )
+  {
+    sum += times[i];
+  }
+  *mean = n > 0 ? sum / n : 0;
+
+  for( i=0; i<n; ++i )
+  {
+    sumsq += ( times[i] - *mean ) * ( times[i] - *mean );
+  }
+  *stddev = n > 1 ? sqrt( sumsq / ( n - 1 ) ) : 0;
+}
+
+/*===========================================================================*/
+/*---Whether the 95% confidence interval of the mean iteration time is
+     within the given fraction of the mean---*/
+
+static Bool_t Runner_is_confident_( const Timer* times,
+                                    int          n,
+                                    double       rel_confidence )
+{
+  Timer mean = 0;
+  Timer stddev = 0;
+
+  if( n < 2 )
+  {
+    return Bool_false;
+  }
+
+  Runner_mean_stddev_( &mean, &stddev, times, n );
+
+  return 1.96 * stddev / sqrt( (double)n ) <= rel_confidence * mean;
+}
+
+/*===========================================================================*/
+/*---Add the load balance counts of a sweeper to those of this proc---*/
+
+static void Runner_add_balance_( Timer*         time_compute,
+                                 Timer*         time_wait,
+                                 double*        nstep_active,
+                                 double*        nstep_inactive,
+                                 const Sweeper* sweeper )
+{
+#ifdef SWEEPER_KBA
+  *time_compute   += sweeper->time_sweep_block;
+  *time_wait      += sweeper->time_comm_wait;
+  *nstep_active   += sweeper->nstep_active;
+  *nstep_inactive += sweeper->nstep_inactive;
+#endif
 }
 
 /*===========================================================================*/
@@ -60,20 +692,62 @@ void Runner_run_case( Runner* runner, Arguments* args, Env* env )
   Pointer vi = Pointer_null();
   Pointer vo = Pointer_null();
 
+  Arguments args_sweeper = Arguments_null();
+
   runner->normsq     = P_zero();
   runner->normsqdiff = P_zero();
 
   int iteration   = 0;
   int niterations = 0;
+  int niterations_sequential = 0;
+  int i = 0;
+  int nwarmup     = 0;
+  int niterations_max = 0;
+  int niterations_reduced = 0;
+  double rel_confidence = 0;
 
   Timer t1             = 0;
   Timer t2             = 0;
+  Timer time_compute   = 0;
+  Timer time_stop_test = 0;
+
+  Timer  time_compute_proc   = 0;
+  Timer  time_wait_proc      = 0;
+  double nstep_active_proc   = 0;
+  double nstep_inactive_proc = 0;
 
   runner->time       = 0;
+  runner->time_idle_saved = 0;
+  runner->time_rebalance = 0;
+  runner->nrebalance = 0;
+  runner->bytes      = 0;
+  runner->bytes_comm = 0;
+  runner->byterate   = 0;
+  runner->mem_bandwidth = 0;
   runner->flops      = 0;
   runner->floprate   = 0;
   runner->normsq     = 0;
   runner->normsqdiff = 0;
+  runner->niterations = 0;
+  runner->time_iter_min    = 0;
+  runner->time_iter_median = 0;
+  runner->time_iter_mean   = 0;
+  runner->time_iter_stddev = 0;
+  runner->time_iter_max    = 0;
+  runner->time_proc_min    = 0;
+  runner->time_proc_mean   = 0;
+  runner->time_proc_stddev = 0;
+  runner->time_proc_max    = 0;
+  runner->time_compute_mean = 0;
+  runner->time_compute_max  = 0;
+  runner->proc_compute_max  = 0;
+  runner->time_wait_mean    = 0;
+  runner->time_wait_max     = 0;
+  runner->step_idle_fraction = 0;
+
+  /*---Memory peaks are of this run---*/
+
+  MemTracker_reset_peak();
 
   /*---Define problem specs---*/
 
@@ -83,8 +757,25 @@ void Runner_run_case( Runner* runner, Arguments* args, Env* env )
   dims_g.ne   = Arguments_consume_int_or_default( args, "--ne", 30 );
   dims_g.na   = Arguments_consume_int_or_default( args, "--na", 33 );
   niterations = Arguments_consume_int_or_default( args, "--niterations", 1 );
+  nwarmup     = Arguments_consume_int_or_default( args, "--nwarmup", 0 );
+  rel_confidence = Arguments_consume_double_or_default( args,
+                                                     "--rel_confidence", 0 );
+  niterations_max = Arguments_consume_int_or_default( args,
+                                                 "--niterations_max", 1000 );
+  niterations_sequential = niterations;
   dims_g.nm   = NM;
 
+  const Bool_t is_rebalancing = Arguments_consume_int_or_default( args,
+                                             "--is_rebalancing", Bool_false );
+  const char* decomp_file = Arguments_consume_string_or_default( args,
+                                                      "--decomp_file", NULL );
+  const Bool_t is_iteration_pipelined = Arguments_consume_int_or_default(
+                               args, "--is_iteration_pipelined", Bool_false );
+  const Bool_t is_measuring_mem_bandwidth = Arguments_consume_int_or_default(
+                           args, "--is_measuring_mem_bandwidth", Bool_false );
+  const double mem_bandwidth = Arguments_consume_double_or_default( args,
+                                                      "--mem_bandwidth", 0 );
+
   Insist( dims_g.ncell_x > 0 ? "Invalid ncell_x supplied." : 0 );
   Insist( dims_g.ncell_y > 0 ? "Invalid ncell_y supplied." : 0 );
   Insist( dims_g.ncell_z > 0 ? "Invalid ncell_z supplied." : 0 );
@@ -92,34 +783,68 @@ void Runner_run_case( Runner* runner, Arguments* args, Env* env )
   Insist( dims_g.nm > 0      ? "Invalid nm supplied." : 0 );
   Insist( dims_g.na > 0      ? "Invalid na supplied." : 0 );
   Insist( niterations >= 0   ? "Invalid iteration count supplied." : 0 );
+  Insist( nwarmup >= 0       ? "Invalid warmup count supplied." : 0 );
+  Insist( rel_confidence >= 0 ? "Invalid confidence supplied." : 0 );
+  Insist( rel_confidence == 0 || niterations_max >= niterations ?
+          "Invalid maximum iteration count supplied." : 0 );
+  Insist( mem_bandwidth >= 0 ? "Invalid memory bandwidth supplied." : 0 );
+  Insist( ! is_iteration_pipelined || ! is_rebalancing ?
+          "Pipelined iterations cannot be rebalanced." : 0 );
+  Insist( rel_confidence == 0 || ! ( is_iteration_pipelined ||
+                                     is_rebalancing ) ?
+          "Confidence target requires plain iterations." : 0 );
+#ifndef SWEEPER_KBA
+  Insist( ! is_iteration_pipelined ?
+          "Pipelined iterations require the KBA sweeper." : 0 );
+#endif
 
   /*---Initialize (local) dimensions - domain decomposition---*/
 
-  dims = dims_g;
+  /*---Cut positions along x and y are either given as weights or explicit
+       positions, on the command line or in a file, or split evenly---*/
 
-  dims.ncell_x =
-      ( ( Env_proc_x_this( env ) + 1 ) * dims_g.ncell_x ) / Env_nproc_x( env )
-    - ( ( Env_proc_x_this( env )     ) * dims_g.ncell_x ) / Env_nproc_x( env );
+  int* cuts_x     = malloc_host_int( Env_nproc_x( env ) + 1 );
+  int* cuts_y     = malloc_host_int( Env_nproc_y( env ) + 1 );
+  int* cuts_x_new = malloc_host_int( Env_nproc_x( env ) + 1 );
+  int* cuts_y_new = malloc_host_int( Env_nproc_y( env ) + 1 );
+  double* times_slab = (double*) malloc( ( Env_nproc_x( env ) +
+                                 Env_nproc_y( env ) ) * sizeof( double ) );
 
-  dims.ncell_y =
-      ( ( Env_proc_y_this( env ) + 1 ) * dims_g.ncell_y ) / Env_nproc_y( env )
-    - ( ( Env_proc_y_this( env )     ) * dims_g.ncell_y ) / Env_nproc_y( env );
+  dims = Runner_dims_this_( cuts_x, cuts_y, dims_g, decomp_file, args, env );
 
   /*---Initialize quantities---*/
 
   Quantities_create( &quan, dims, env );
 
-  /*---Allocate arrays---*/
+  /*---Allocate arrays, or take those of the previous run if the same
+       size, as for repeated runs of a problem---*/
 
-  Pointer_create( &vi, Dimensions_size_state( dims, NU ),
-                                            Env_hip_is_using_device( env ) );
-  Pointer_set_pinned( &vi, Bool_true );
-  Pointer_allocate( &vi );
+  const Bool_t is_using_device = Env_hip_is_using_device( env );
 
-  Pointer_create( &vo, Dimensions_size_state( dims, NU ),
-                                            Env_hip_is_using_device( env ) );
-  Pointer_set_pinned( &vo, Bool_true );
-  Pointer_allocate( &vo );
+  if( runner->size_state == Dimensions_size_state( dims, NU ) &&
+      runner->is_using_device == is_using_device )
+  {
+    vi = runner->vi;
+    vo = runner->vo;
+    runner->vi = Pointer_null();
+    runner->vo = Pointer_null();
+  }
+  else
+  {
+    Pointer_destroy( &runner->vi );
+    Pointer_destroy( &runner->vo );
+
+    Pointer_create( &vi, Dimensions_size_state( dims, NU ), is_using_device );
+    Pointer_set_pinned( &vi, Bool_true );
+    Pointer_set_category( &vi, MEMTRACKER_STATE );
+    Pointer_allocate( &vi );
+
+    Pointer_create( &vo, Dimensions_size_state( dims, NU ), is_using_device );
+    Pointer_set_pinned( &vo, Bool_true );
+    Pointer_set_category( &vo, MEMTRACKER_STATE );
+    Pointer_allocate( &vo );
+  }
+  runner->size_state = 0;
 
   /*---Initialize input state array---*/
 
@@ -134,6 +859,9 @@ void Runner_run_case( Runner* runner, Arguments* args, Env* env )
 
   /*---Initialize sweeper---*/
 
+  /*---Keep sweeper args in case sweeper is rebuilt after rebalancing---*/
+  Arguments_create_copy( &args_sweeper, args );
+
   Sweeper_create( &sweeper, dims, &quan, env, args );
 
   /*---Check that all command line args used---*/
@@ -141,46 +869,412 @@ void Runner_run_case( Runner* runner, Arguments* args, Env* env )
   Insist( Arguments_are_all_consumed( args )
                                           ? "Invalid argument detected." : 0 );
 
+  /*---Memory bandwidth of all procs, for comparing the traffic to---*/
+
+  runner->mem_bandwidth = Env_sum_d( env, is_measuring_mem_bandwidth ?
+                                 Runner_measure_mem_bandwidth_( env ) :
+                                 mem_bandwidth * 1.e9 ) / 1e9;
+
+  /*---Untimed iterations, to take first touch and cold caches out of the
+       timings; vi is left unchanged so results do not depend on these---*/
+
+  for( iteration=0; iteration<nwarmup; ++iteration )
+  {
+    Sweeper_sweep( &sweeper, &vo, &vi, &quan, env );
+  }
+
+#ifdef SWEEPER_KBA
+  sweeper.time_sweep_block = 0;
+  sweeper.time_comm_wait   = 0;
+  sweeper.nstep_active     = 0;
+  sweeper.nstep_inactive   = 0;
+
+  /*---The schedule for pipelined iterations is built before timing---*/
+
+  if( is_iteration_pipelined && niterations > 0 )
+  {
+    Sweeper_set_niteration( &sweeper, niterations, env );
+  }
+#endif
+
+  /*---Times of iterations on this proc, and of the slowest proc---*/
+
+  const int ntime = rel_confidence > 0 ? niterations_max : niterations;
+  Timer* times_proc = (Timer*) malloc( ( ntime + 1 ) * sizeof( Timer ) );
+  Timer* times      = (Timer*) malloc( ( ntime + 1 ) * sizeof( Timer ) );
+
   /*---Call sweeper---*/
 
   t1 = Env_get_synced_time( env );
 
-  for( iteration=0; iteration<niterations; ++iteration )
+  /*---Timers and trace events are taken from here---*/
+
+  Profiler_reset();
+  Counters_reset();
+  Env_comm_reset( env );
+
+#ifdef SWEEPER_KBA
+  /*---Run all iterations as one pipeline, each starting on a proc as
+       soon as the previous one has finished there---*/
+
+  if( is_iteration_pipelined && niterations > 0 )
   {
+    Sweeper_sweep_iterations( &sweeper, &vo, &vi, niterations, &quan, env );
+    runner->time_idle_saved = sweeper.time_idle_saved;
+    niterations_sequential = 0;
+  }
+#endif
+
+  for( iteration=0; iteration<niterations_sequential; ++iteration )
+  {
+    const Timer time_iter = Env_get_time( env );
+#ifdef SWEEPER_KBA
+    time_compute = sweeper.time_sweep_block;
+#else
+    time_compute = Env_get_time( env );
+#endif
+
     Sweeper_sweep( &sweeper,
                    iteration%2==0 ? &vo : &vi,
                    iteration%2==0 ? &vi : &vo,
                    &quan,
                    env );
+
+#ifdef SWEEPER_KBA
+    time_compute = sweeper.time_sweep_block - time_compute;
+#else
+    time_compute = Env_get_time( env ) - time_compute;
+#endif
+
+    times_proc[iteration] = Env_get_time( env ) - time_iter;
+
+    /*---Add iterations until the mean time is known closely enough.  The
+         slowest proc's times are needed, so the test is made only at the
+         end of each round of iterations, doubling the round each time,
+         and is timed apart from the sweeps---*/
+
+    if( rel_confidence > 0 && iteration == niterations_sequential-1 &&
+        niterations_sequential < niterations_max )
+    {
+      const Timer time_stop_test_begin = Env_get_synced_time( env );
+
+      for( ; niterations_reduced<niterations_sequential;
+                                                   ++niterations_reduced )
+      {
+        times[niterations_reduced] = Env_max_d( env,
+                                       times_proc[niterations_reduced] );
+      }
+
+      if( ! Runner_is_confident_( times, niterations_sequential,
+                                  rel_confidence ) )
+      {
+        niterations_sequential = imin( 2 * niterations_sequential,
+                                       niterations_max );
+      }
+
+      time_stop_test += Env_get_synced_time( env ) - time_stop_test_begin;
+    }
+
+    /*---Rebalance x/y decomposition from measured per-proc times; this is
+         timed apart from the sweeps---*/
+
+    if( ! is_rebalancing || iteration == niterations-1 )
+    {
+      continue;
+    }
+
+    const Timer time_rebalance_begin = Env_get_synced_time( env );
+
+    /*---Times of the slabs along x then y, summed in one reduction---*/
+
+    for( i=0; i<Env_nproc_x( env ) + Env_nproc_y( env ); ++i )
+    {
+      times_slab[i] = 0;
+    }
+    times_slab[ Env_proc_x_this( env ) ] = time_compute;
+    times_slab[ Env_nproc_x( env ) + Env_proc_y_this( env ) ] = time_compute;
+    Env_sum_d_vector( env, times_slab, Env_nproc_x( env ) +
+                                       Env_nproc_y( env ) );
+
+    const Bool_t is_changed_x = Runner_rebalance_cuts_( cuts_x_new, cuts_x,
+          Env_nproc_x( env ), times_slab );
+    const Bool_t is_changed_y = Runner_rebalance_cuts_( cuts_y_new, cuts_y,
+          Env_nproc_y( env ), times_slab + Env_nproc_x( env ) );
+
+    if( is_changed_x || is_changed_y )
+    {
+      Dimensions dims_new = dims;
+
+      /*---Migrate state columns along x, then along y---*/
+
+      if( is_changed_x )
+      {
+        dims_new.ncell_x = cuts_x_new[ Env_proc_x_this( env ) + 1 ]
+                         - cuts_x_new[ Env_proc_x_this( env )     ];
+        Runner_migrate_state_( &vi, dims, dims_new, cuts_x, cuts_x_new, 0,
+                               env );
+        Runner_migrate_state_( &vo, dims, dims_new, cuts_x, cuts_x_new, 0,
+                               env );
+        memcpy( cuts_x, cuts_x_new, ( Env_nproc_x( env ) + 1 ) * sizeof(int) );
+        dims = dims_new;
+      }
+
+      if( is_changed_y )
+      {
+        dims_new.ncell_y = cuts_y_new[ Env_proc_y_this( env ) + 1 ]
+                         - cuts_y_new[ Env_proc_y_this( env )     ];
+        Runner_migrate_state_( &vi, dims, dims_new, cuts_y, cuts_y_new, 1,
+                               env );
+        Runner_migrate_state_( &vo, dims, dims_new, cuts_y, cuts_y_new, 1,
+                               env );
+        memcpy( cuts_y, cuts_y_new, ( Env_nproc_y( env ) + 1 ) * sizeof(int) );
+        dims = dims_new;
+      }
+
+      /*---Rebuild quantities and sweeper for the new decomposition---*/
+
+      Runner_add_balance_( &time_compute_proc, &time_wait_proc,
+                           &nstep_active_proc, &nstep_inactive_proc,
+                           &sweeper );
+
+      Sweeper_destroy( &sweeper, env );
+      Quantities_destroy( &quan );
+
+      Quantities_create( &quan, dims, env );
+
+      Arguments args_sweeper_this = Arguments_null();
+      Arguments_create_copy( &args_sweeper_this, &args_sweeper );
+      sweeper = Sweeper_null();
+      Sweeper_create( &sweeper, dims, &quan, env, &args_sweeper_this );
+      Arguments_destroy( &args_sweeper_this );
+
+      ++runner->nrebalance;
+    }
+
+    runner->time_rebalance += Env_get_synced_time( env ) -
+                              time_rebalance_begin;
   }
 
   t2 = Env_get_synced_time( env );
-  runner->time = t2 - t1;
+  runner->time = t2 - t1 - runner->time_rebalance - time_stop_test;
+
+  if( rel_confidence > 0 )
+  {
+    niterations = niterations_sequential;
+  }
+  runner->niterations = niterations;
+
+  /*---Iteration time statistics, over iterations and over procs---*/
+
+  if( niterations_sequential > 0 )
+  {
+    const int n = niterations_sequential;
+    Timer time_proc = 0;
+
+    for( iteration=0; iteration<n; ++iteration )
+    {
+      if( iteration >= niterations_reduced )
+      {
+        times[iteration] = Env_max_d( env, times_proc[iteration] );
+      }
+      time_proc += times_proc[iteration];
+    }
+
+    Runner_mean_stddev_( &runner->time_iter_mean, &runner->time_iter_stddev,
+                         times, n );
+    qsort( times, n, sizeof( Timer ), Runner_compare_times_ );
+    runner->time_iter_min    = times[0];
+    runner->time_iter_max    = times[n-1];
+    runner->time_iter_median = n % 2 ? times[n/2] :
+                               .5 * ( times[n/2-1] + times[n/2] );
+
+    const int nproc = Env_nproc( env );
+    runner->time_proc_min  = Env_min_d( env, time_proc );
+    runner->time_proc_max  = Env_max_d( env, time_proc );
+    runner->time_proc_mean = Env_sum_d( env, time_proc ) / nproc;
+    const Timer var = Env_sum_d( env, ( time_proc - runner->time_proc_mean ) *
+                                      ( time_proc - runner->time_proc_mean ) );
+    runner->time_proc_stddev = nproc > 1 ? sqrt( var / ( nproc - 1 ) ) : 0;
+  }
+
+  free( (void*) times_proc );
+  free( (void*) times );
+
+  /*---Load balance: spread of compute and wait times over procs, and the
+       share of steps, summed over procs, in which a proc has no work---*/
+
+  Runner_add_balance_( &time_compute_proc, &time_wait_proc,
+                       &nstep_active_proc, &nstep_inactive_proc, &sweeper );
+
+  {
+    const int nproc = Env_nproc( env );
+    const double nstep_sum = Env_sum_d( env, nstep_active_proc +
+                                             nstep_inactive_proc );
+
+    runner->time_compute_max  = Env_max_d( env, time_compute_proc );
+    runner->time_compute_mean = Env_sum_d( env, time_compute_proc ) / nproc;
+    runner->proc_compute_max  = (int)Env_min_d( env,
+                      time_compute_proc == runner->time_compute_max ?
+                      Env_proc_this( env ) : nproc );
+    runner->time_wait_max     = Env_max_d( env, time_wait_proc );
+    runner->time_wait_mean    = Env_sum_d( env, time_wait_proc ) / nproc;
+    runner->step_idle_fraction = nstep_sum == 0 ? 0 :
+                         Env_sum_d( env, nstep_inactive_proc ) / nstep_sum;
+  }
+
+  /*---Message counts by axis and size, summed onto master---*/
+
+  Env_comm_summarize( env, &runner->comm );
 
   /*---Compute flops used---*/
 
+  /*---Each octant group performs its share of the octants---*/
+
   runner->flops = Env_sum_d( env, niterations *
          ( Dimensions_size_state( dims, NU ) * NOCTANT * 2. * dims.na
          + Dimensions_size_state_angles( dims, NU )
                                         * Quantities_flops_per_solve( dims )
-         + Dimensions_size_state( dims, NU ) * NOCTANT * 2. * dims.na ) );
+         + Dimensions_size_state( dims, NU ) * NOCTANT * 2. * dims.na ) )
+                                                 / Env_nproc_octant( env );
 
   runner->floprate = runner->time <= (Timer)0 ?
                                    0 : runner->flops / runner->time / 1e9;
 
+  /*---Compute bytes moved---*/
+
+  {
+#ifdef SWEEPER_KBA
+    const int nblock_z = sweeper.nblock_z;
+#else
+    const int nblock_z = 1;
+#endif
+    double bytes = 0;
+    double bytes_comm = 0;
+
+    Runner_traffic_( &bytes, &bytes_comm, dims, nblock_z, env );
+
+    runner->bytes = Env_sum_d( env, niterations * bytes )
+                                                 / Env_nproc_octant( env );
+    runner->bytes_comm = Env_sum_d( env, niterations * bytes_comm )
+                                                 / Env_nproc_octant( env );
+  }
+
+  runner->byterate = runner->time <= (Timer)0 ?
+                                   0 : runner->bytes / runner->time / 1e9;
+
   /*---Compute, print norm squared of result---*/
 
+  Profiler_begin( NORMS );
   get_state_norms( Pointer_h( &vi ), Pointer_h( &vo ),
                      dims, NU, &runner->normsq, &runner->normsqdiff, env );
+  Profiler_end( NORMS );
+
+  /*---Keep the state arrays for the next run---*/
+  runner->vi = vi;
+  runner->vo = vo;
+  runner->size_state = Dimensions_size_state( dims, NU );
+  runner->is_using_device = is_using_device;
 
   /*---Deallocations---*/
-  Pointer_destroy( &vi );
-  Pointer_destroy( &vo );
+
+  Arguments_destroy( &args_sweeper );
+
+  free_host_int( cuts_x );
+  free_host_int( cuts_y );
+  free_host_int( cuts_x_new );
+  free_host_int( cuts_y_new );
+  free( (void*) times_slab );
 
   Sweeper_destroy( &sweeper, env );
   Quantities_destroy( &quan );
 }
 
+/*===========================================================================*/
+/*---Register with the memory tracker the arrays a run would allocate on
+     this proc, without allocating them---*/
+
+/*---The sweeper arrays are sized by the sweeper from the same settings
+     as Sweeper_create, so the prediction follows its defaults---*/
+
+void Runner_predict_memory( Arguments* args, Env* env )
+{
+  Dimensions dims_g;
+  Dimensions dims;
+
+  size_t nbyte[MEMTRACKER_NCATEGORY];
+  size_t nbyte_device[MEMTRACKER_NCATEGORY];
+  size_t nbyte_transient = 0;
+  int category = 0;
+
+  dims_g.ncell_x = Arguments_consume_int_or_default( args, "--ncell_x",  5 );
+  dims_g.ncell_y = Arguments_consume_int_or_default( args, "--ncell_y",  5 );
+  dims_g.ncell_z = Arguments_consume_int_or_default( args, "--ncell_z",  5 );
+  dims_g.ne   = Arguments_consume_int_or_default( args, "--ne", 30 );
+  dims_g.na   = Arguments_consume_int_or_default( args, "--na", 33 );
+  dims_g.nm   = NM;
+
+  const char* decomp_file = Arguments_consume_string_or_default( args,
+                                                      "--decomp_file", NULL );
+
+  Insist( dims_g.ncell_x > 0 ? "Invalid ncell_x supplied." : 0 );
+  Insist( dims_g.ncell_y > 0 ? "Invalid ncell_y supplied." : 0 );
+  Insist( dims_g.ncell_z > 0 ? "Invalid ncell_z supplied." : 0 );
+  Insist( dims_g.ne > 0      ? "Invalid ne supplied." : 0 );
+  Insist( dims_g.na > 0      ? "Invalid na supplied." : 0 );
+
+  int* cuts_x = malloc_host_int( Env_nproc_x( env ) + 1 );
+  int* cuts_y = malloc_host_int( Env_nproc_y( env ) + 1 );
+
+  dims = Runner_dims_this_( cuts_x, cuts_y, dims_g, decomp_file, args, env );
+
+  free_host_int( cuts_x );
+  free_host_int( cuts_y );
+
+  const Bool_t is_using_device = Env_hip_is_using_device( env );
+
+  for( category=0; category<MEMTRACKER_NCATEGORY; ++category )
+  {
+    nbyte[category] = 0;
+    nbyte_device[category] = 0;
+  }
+
+  /*---State arrays vi, vo and moment-angle matrices a_from_m, m_from_a---*/
+
+  nbyte[MEMTRACKER_STATE] = 2 * sizeof(P) * Dimensions_size_state( dims, NU );
+  nbyte[MEMTRACKER_ANGLE] = 2 * sizeof(P) * dims.nm * dims.na * NOCTANT;
+
+#ifdef SWEEPER_KBA
+  /*---Faces, staging buffers and scratch, sized by the sweeper itself---*/
+
+  Sweeper_predict_memory( nbyte, nbyte_device, &nbyte_transient, dims, env,
+                          args );
+#endif
+
+  if( is_using_device )
+  {
+    nbyte_device[MEMTRACKER_STATE] = nbyte[MEMTRACKER_STATE];
+    nbyte_device[MEMTRACKER_ANGLE] = nbyte[MEMTRACKER_ANGLE];
+  }
+
+  /*---Register all as allocated, then the buffers made at a step, then
+       free all---*/
+
+  for( category=0; category<MEMTRACKER_NCATEGORY; ++category )
+  {
+    MemTracker_allocate( category, nbyte[category], Bool_false );
+    MemTracker_allocate( category, nbyte_device[category], Bool_true );
+  }
+
+  MemTracker_allocate( MEMTRACKER_FACE_BUFS, nbyte_transient, Bool_false );
+  MemTracker_free( MEMTRACKER_FACE_BUFS, nbyte_transient, Bool_false );
+
+  for( category=0; category<MEMTRACKER_NCATEGORY; ++category )
+  {
+    MemTracker_free( category, nbyte[category], Bool_false );
+    MemTracker_free( category, nbyte_device[category], Bool_true );
+  }
+}
+
 /*===========================================================================*/
 /*---Utility function: perform two runs, compare results---*/
 
@@ -14,6 +14,7 @@
 #include "arguments.h"
 #include "env.h"
 #include "definitions.h"
+#include "pointer.h"
 
 #ifdef __cplusplus_IGNORE
 extern "C"
@@ -29,7 +30,40 @@ typedef struct
   P      normsqdiff;
   double flops;
   double floprate;
+  double bytes;             /*---Memory traffic, by analytic model---*/
+  double bytes_comm;        /*---Face message traffic, by analytic model---*/
+  double byterate;          /*---GB/s of memory traffic---*/
+  double mem_bandwidth;     /*---GB/s of all procs, measured or given---*/
   Timer  time;
+  Timer  time_idle_saved;   /*---Estimated by pipelining iterations---*/
+  Timer  time_rebalance;    /*---Not included in time---*/
+  int    nrebalance;        /*---Times the decomposition was changed---*/
+  int    niterations;       /*---Iterations timed, after any warmup---*/
+  /*---Over iterations, of the slowest proc; not kept when pipelined---*/
+  Timer  time_iter_min;
+  Timer  time_iter_median;
+  Timer  time_iter_mean;
+  Timer  time_iter_stddev;
+  Timer  time_iter_max;
+  /*---Over procs, of the sum of the iterations on each---*/
+  Timer  time_proc_min;
+  Timer  time_proc_mean;
+  Timer  time_proc_stddev;
+  Timer  time_proc_max;
+  /*---Load balance over procs, from block compute times, message wait
+       times and steps without work for the proc; KBA sweeper only---*/
+  Timer  time_compute_mean;
+  Timer  time_compute_max;
+  int    proc_compute_max;  /*---Proc with the most compute time---*/
+  Timer  time_wait_mean;
+  Timer  time_wait_max;
+  double step_idle_fraction;
+  CommSummary comm;         /*---Messages of all procs, on master---*/
+  /*---State arrays, kept for a next run of the same size on this proc---*/
+  Pointer vi;
+  Pointer vo;
+  size_t size_state;
+  Bool_t is_using_device;
 } Runner;
 
 /*===========================================================================*/
@@ -52,6 +86,12 @@ void Runner_destroy( Runner* runner );
 
 void Runner_run_case( Runner* runner, Arguments* args, Env* env );
 
+/*===========================================================================*/
+/*---Register the memory a run would allocate on this proc, without
+     allocating it---*/
+
+void Runner_predict_memory( Arguments* args, Env* env );
+
 /*===========================================================================*/
 /*---Utility function: perform two runs, compare results---*/
 
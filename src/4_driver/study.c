@@ -0,0 +1,375 @@
+/*---------------------------------------------------------------------------*/
+/*!
+ * \file   study.c
+ * \author agent
+ * \date   Mon Oct 19 03:51:47 UTC 2026
+ * \brief  Performance study of sweep over a grid of settings.
+ */
+/*---------------------------------------------------------------------------*/
+
+/*=============================================================================
+
+Each argument is a sweep setting with a comma-separated list of values,
+e.g. "--nblock_z 1,2,4".  The problem settings (cell counts, ne, na)
+define the problems, and all other settings the configurations; every
+configuration is run for every problem, all in this one process, a
+number of times each.  The runs of a problem share one Runner, so the
+state arrays are reused whenever the local dimensions match.  For each
+problem a table of the configurations is printed, then the best of them.
+Settings of the decomposition can be varied like any other, giving strong
+scaling studies within a problem and weak scaling studies across problems.
+
+=============================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arguments.h"
+#include "env.h"
+#include "definitions.h"
+#include "sweeper.h"
+
+#include "runner.h"
+
+#define MAX_LINE_LEN 1024
+
+/*===========================================================================*/
+/*---Settings varied---*/
+
+enum{ STUDY_NAXIS_MAX = 32 };
+enum{ STUDY_VALUE_LEN = 64 };
+
+typedef struct
+{
+  const char* name;
+  const char* values;       /*---Comma-separated list---*/
+  int         nvalue;
+  Bool_t      is_problem;
+} StudyAxis;
+
+/*---Settings that define a problem rather than a configuration---*/
+
+static const char* study_problem_names_[] = {
+  "--ncell_x", "--ncell_y", "--ncell_z", "--ne", "--na", NULL };
+
+/*===========================================================================*/
+/*---Get a value of a comma-separated list---*/
+
+static void Study_value_( char* value, const char* values, int index )
+{
+  const char* s = values;
+  int i = 0;
+
+  for( i=0; i<index; ++i )
+  {
+    s = strchr( s, ',' );
+    Assert( s );
+    ++s;
+  }
+
+  const char* end = strchr( s, ',' );
+  const int len = end ? (int)( end - s ) : (int)strlen( s );
+  Insist( len > 0 && len < STUDY_VALUE_LEN ? "Invalid value supplied." : 0 );
+
+  memcpy( value, s, len );
+  value[len] = 0;
+}
+
+/*===========================================================================*/
+/*---Append the settings for given problem and configuration numbers---*/
+
+static void Study_argstring_( char*            argstring,
+                              const StudyAxis* axes,
+                              int              naxis,
+                              Bool_t           is_problem,
+                              int              index )
+{
+  char value[STUDY_VALUE_LEN];
+  int value_index[STUDY_NAXIS_MAX];
+  int axis = 0;
+
+  /*---The last setting given varies fastest---*/
+
+  for( axis=naxis-1; axis>=0; --axis )
+  {
+    if( axes[axis].is_problem == is_problem )
+    {
+      value_index[axis] = index % axes[axis].nvalue;
+      index /= axes[axis].nvalue;
+    }
+  }
+
+  for( axis=0; axis<naxis; ++axis )
+  {
+    if( axes[axis].is_problem != is_problem )
+    {
+      continue;
+    }
+    Study_value_( value, axes[axis].values, value_index[axis] );
+
+    Insist( strlen( argstring ) + strlen( axes[axis].name ) + strlen( value )
+            + 3 < MAX_LINE_LEN ? "Settings too long." : 0 );
+    sprintf( argstring + strlen( argstring ), " %s %s",
+             axes[axis].name, value );
+  }
+}
+
+/*===========================================================================*/
+/*---Compare times, for sorting---*/
+
+static int Study_compare_( const void* a, const void* b )
+{
+  const Timer ta = *(const Timer*)a;
+  const Timer tb = *(const Timer*)b;
+  return ta < tb ? -1 : ta > tb ? 1 : 0;
+}
+
+/*===========================================================================*/
+/*---Run a problem with each configuration, print its table on master---*/
+
+static void Study_run_problem_( char*            best,
+                                const StudyAxis* axes,
+                                int              naxis,
+                                int              problem,
+                                int              nconfig,
+                                int              nrep,
+                                Env*             env )
+{
+  char argstring_problem[MAX_LINE_LEN];
+  char argstring_config[MAX_LINE_LEN];
+  char argstring[MAX_LINE_LEN];
+
+  Runner runner = Runner_null();
+  Timer* times = (Timer*) malloc( nrep * sizeof( Timer ) );
+
+  Timer time_best = 0;
+  Timer time_first = 0;
+  int nproc_first = 0;
+  int nproc_best = 0;
+  int config = 0;
+  int rep = 0;
+
+  Runner_create( &runner );
+
+  argstring_problem[0] = 0;
+  Study_argstring_( argstring_problem, axes, naxis, Bool_true, problem );
+
+  if( Env_is_proc_master( env ) )
+  {
+    printf( "Problem:%s\n", argstring_problem );
+    printf( "%-6s %10s %10s %8s %10s %-4s %s\n", "nproc", "time(min)",
+            "time(med)", "GF/s", "GF/s/proc", "", "configuration" );
+  }
+
+  best[0] = 0;
+
+  for( config=0; config<nconfig; ++config )
+  {
+    argstring_config[0] = 0;
+    Study_argstring_( argstring_config, axes, naxis, Bool_false, config );
+    const int len = snprintf( argstring, MAX_LINE_LEN, "%s%s",
+                              argstring_problem, argstring_config );
+    Insist( len >= 0 && len < MAX_LINE_LEN ? "Settings too long." : 0 );
+
+    Bool_t pass = Bool_true;
+    double flops = 0;
+    int nproc = 0;
+
+    for( rep=0; rep<nrep; ++rep )
+    {
+      Arguments args = Arguments_null();
+      Arguments_create_from_string( &args, argstring );
+      Env_set_values( env, &args );
+      nproc = Env_nproc( env );
+
+      if( Env_is_proc_active( env ) )
+      {
+        Runner_run_case( &runner, &args, env );
+      }
+
+      times[rep] = runner.time;
+      flops = runner.flops;
+      pass = pass && runner.normsqdiff == P_zero();
+
+      Arguments_destroy( &args );
+    }
+
+    qsort( times, nrep, sizeof( Timer ), Study_compare_ );
+
+    const Timer time_min = times[0];
+    const Timer time_med = nrep % 2 ? times[nrep/2] :
+                           .5 * ( times[nrep/2-1] + times[nrep/2] );
+    const double floprate = time_min > 0 ? flops / time_min / 1e9 : 0;
+
+    if( config == 0 || time_min < time_best )
+    {
+      time_best = time_min;
+      nproc_best = nproc;
+      const int len_best = snprintf( best, MAX_LINE_LEN,
+                                     "%s  time %.6f  GF/s %.3f",
+                                     argstring_config, (double)time_min,
+                                     floprate );
+      Insist( len_best >= 0 && len_best < MAX_LINE_LEN ?
+              "Settings too long." : 0 );
+    }
+    if( config == 0 )
+    {
+      time_first = time_min;
+      nproc_first = nproc;
+    }
+
+    if( Env_is_proc_master( env ) )
+    {
+      printf( "%-6i %10.6f %10.6f %8.3f %10.3f %-4s %s\n", nproc,
+              (double)time_min, (double)time_med, floprate,
+              floprate / nproc, pass ? "PASS" : "FAIL", argstring_config );
+    }
+  }
+
+  /*---Speedup of the best configuration over the first, and parallel
+       efficiency if they differ in proc count---*/
+
+  if( Env_is_proc_master( env ) )
+  {
+    printf( "Best:%s\n", best );
+    if( time_best > 0 )
+    {
+      printf( "Speedup over first configuration: %.3f  efficiency: %.3f\n",
+              (double)( time_first / time_best ),
+              (double)( time_first * nproc_first /
+                        ( time_best * nproc_best ) ) );
+    }
+    printf( "\n" );
+  }
+
+  free( (void*) times );
+
+  Runner_destroy( &runner );
+}
+
+/*===========================================================================*/
+/*---Main---*/
+
+int main( int argc, char** argv )
+{
+  /*---Declarations---*/
+  Env env = Env_null();
+
+  StudyAxis axes[STUDY_NAXIS_MAX];
+  int naxis = 0;
+  int nproblem = 1;
+  int nconfig = 1;
+  int nrep = 3;
+  int i = 0;
+  int problem = 0;
+
+  /*---Initialize for execution---*/
+
+  Env_initialize( &env, argc, argv );
+
+  /*---Read settings and their values; --nrep is the number of runs of
+       each configuration---*/
+
+  for( i=1; i<argc; i+=2 )
+  {
+    Insist( i+1 < argc ? "Invalid argument detected." : 0 );
+
+    if( strcmp( argv[i], "--nrep" ) == 0 )
+    {
+      nrep = atoi( argv[i+1] );
+      Insist( nrep > 0 ? "Invalid repetition count supplied." : 0 );
+      continue;
+    }
+
+    Insist( naxis < STUDY_NAXIS_MAX ? "Too many settings supplied." : 0 );
+    Insist( strncmp( argv[i], "--", 2 ) == 0 ?
+            "Invalid argument detected." : 0 );
+
+    StudyAxis* axis = &axes[naxis];
+    const char* s = NULL;
+    int j = 0;
+
+    axis->name = argv[i];
+    axis->values = argv[i+1];
+    axis->nvalue = 1;
+    for( s=axis->values; *s; ++s )
+    {
+      axis->nvalue += *s == ',' ? 1 : 0;
+    }
+    axis->is_problem = Bool_false;
+    for( j=0; study_problem_names_[j]; ++j )
+    {
+      axis->is_problem = axis->is_problem ||
+                         strcmp( axis->name, study_problem_names_[j] ) == 0;
+    }
+
+    if( axis->is_problem )
+    {
+      nproblem *= axis->nvalue;
+    }
+    else
+    {
+      nconfig *= axis->nvalue;
+    }
+    ++naxis;
+  }
+
+  /*---Set up environment on all procs, for output from master---*/
+
+  {
+    Arguments args = Arguments_null();
+    Arguments_create( &args, 1, argv );
+    Env_set_values( &env, &args );
+    Arguments_destroy( &args );
+  }
+
+  if( Env_is_proc_master( &env ) )
+  {
+    printf( "Study: NM %i  NU %i  problems %i  configurations %i  "
+            "nrep %i\n\n", NM, NU, nproblem, nconfig, nrep );
+  }
+
+  /*---Run each problem, keep the best configuration of each---*/
+
+  char* best = (char*) malloc( nproblem * MAX_LINE_LEN * sizeof( char ) );
+
+  for( problem=0; problem<nproblem; ++problem )
+  {
+    Study_run_problem_( &best[problem*MAX_LINE_LEN], axes, naxis,
+                        problem, nconfig, nrep, &env );
+  }
+
+  /*---Summary---*/
+
+  {
+    Arguments args = Arguments_null();
+    Arguments_create( &args, 1, argv );
+    Env_set_values( &env, &args );
+    Arguments_destroy( &args );
+  }
+
+  if( Env_is_proc_master( &env ) )
+  {
+    char argstring_problem[MAX_LINE_LEN];
+
+    printf( "Best configuration per problem:\n" );
+    for( problem=0; problem<nproblem; ++problem )
+    {
+      argstring_problem[0] = 0;
+      Study_argstring_( argstring_problem, axes, naxis, Bool_true, problem );
+      printf( "%s //%s\n", argstring_problem, &best[problem*MAX_LINE_LEN] );
+    }
+  }
+
+  /*---Deallocations---*/
+
+  free( (void*) best );
+
+  /*---Finalize execution---*/
+
+  Env_finalize( &env );
+
+} /*---main---*/
+
+/*---------------------------------------------------------------------------*/
@@ -9,6 +9,7 @@
 /*---------------------------------------------------------------------------*/
 
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "arguments.h"
 #include "env.h"
@@ -18,8 +19,15 @@
 #include "quantities.h"
 #include "array_operations.h"
 #include "sweeper.h"
+#include "profiler.h"
+#include "counters.h"
+#include "memtracker.h"
+#include "pool.h"
 
 #include "runner.h"
+#include "results.h"
+#include "perfmodel.h"
+#include "dryrun.h"
 
 /*===========================================================================*/
 /*---Main---*/
@@ -39,21 +47,157 @@ int main( int argc, char** argv )
   Arguments_create( &args, argc, argv );
   Runner_create( &runner );
 
+  /*---A dry run takes the decomposition simulated from the args, so
+       that the environment is set up for one proc---*/
+
+  DryRun dryrun = DryRun_null();
+
+  const int dry_run = Arguments_consume_int_or_default( &args,
+                                                        "--dry_run", 0 );
+  if( dry_run )
+  {
+    DryRun_create( &dryrun, &args );
+  }
+
   Env_set_values( &env, &args );
 
-  /*---Perform run---*/
+  /*---Perform run, or only simulate its schedule, rank decompositions
+       by predicted time or predict its memory---*/
+
+  const Bool_t is_advising = Arguments_consume_int_or_default( &args,
+                                                     "--advise", Bool_false );
+  const Bool_t is_predicting_memory = Arguments_consume_int_or_default(
+                                    &args, "--predict_memory", Bool_false );
+
+  /*---Optionally record a timeline of the run---*/
+
+  const char* trace_file = Arguments_consume_string_or_default( &args,
+                                                      "--trace_file", NULL );
+  const int trace_nevent = Arguments_consume_int_or_default( &args,
+                                                "--trace_nevent", 1 << 16 );
+  if( trace_file )
+  {
+    Profiler_trace_start( trace_nevent );
+  }
+
+  /*---Optionally write results as JSON---*/
+
+  const char* json_file = Arguments_consume_string_or_default( &args,
+                                                            "--json", NULL );
+
+  /*---Optionally count hardware events---*/
+
+  const int counters = Arguments_consume_int_or_default( &args,
+                                                          "--counters", 0 );
+  const char* counters_raw = Arguments_consume_string_or_default( &args,
+                                                    "--counters_raw", NULL );
+  if( counters )
+  {
+    Counters_start( counters, counters_raw ?
+                              strtoll( counters_raw, NULL, 0 ) : 0 );
+  }
 
-  if( Env_is_proc_active( &env ) )
+  if( dry_run )
+  {
+    if( Env_is_proc_master( &env ) )
+    {
+      DryRun_run( &dryrun, dry_run );
+    }
+  }
+  else if( is_advising )
+  {
+    PerfModel_advise( &args, &env );
+  }
+  else if( is_predicting_memory )
+  {
+    if( Env_is_proc_active( &env ) )
+    {
+      Runner_predict_memory( &args, &env );
+      MemTracker_print( &env, Bool_true );
+    }
+  }
+  else if( Env_is_proc_active( &env ) )
   {
     Runner_run_case( &runner, &args, &env );
   }
 
-  if( Env_is_proc_master( &env ) )
+  if( ! dry_run && ! is_advising && ! is_predicting_memory &&
+      Env_is_proc_master( &env ) )
   {
     printf( "Normsq result: %.8e  diff: %.3e  %s  time: %.3f  GF/s: %.3f\n",
             (double)runner.normsq, (double)runner.normsqdiff,
             runner.normsqdiff==P_zero() ? "PASS" : "FAIL",
             (double)runner.time, runner.floprate );
+    printf( "Traffic: GB: %.3f  GB/s: %.3f  flops/byte: %.3f  "
+            "face msg GB: %.3f",
+            runner.bytes * 1e-9, runner.byterate,
+            runner.bytes > 0 ? runner.flops / runner.bytes : 0.,
+            runner.bytes_comm * 1e-9 );
+    if( runner.mem_bandwidth > 0 )
+    {
+      printf( "  of bandwidth %.3f: %.1f%%", runner.mem_bandwidth,
+              100. * runner.byterate / runner.mem_bandwidth );
+    }
+    printf( "\n" );
+    if( runner.time_iter_max > 0 )
+    {
+      printf( "Iterations: %i  time min: %.6f  median: %.6f  mean: %.6f  "
+              "stddev: %.6f  max: %.6f\n", runner.niterations,
+              (double)runner.time_iter_min, (double)runner.time_iter_median,
+              (double)runner.time_iter_mean, (double)runner.time_iter_stddev,
+              (double)runner.time_iter_max );
+      printf( "Procs: time min: %.6f  mean: %.6f  stddev: %.6f  max: %.6f\n",
+              (double)runner.time_proc_min, (double)runner.time_proc_mean,
+              (double)runner.time_proc_stddev, (double)runner.time_proc_max );
+    }
+    if( runner.time_compute_max > 0 )
+    {
+      printf( "Balance: compute mean: %.6f  max: %.6f  max/mean: %.3f  "
+              "(proc %i)\n", (double)runner.time_compute_mean,
+              (double)runner.time_compute_max,
+              (double)( runner.time_compute_max / runner.time_compute_mean ),
+              runner.proc_compute_max );
+      printf( "Balance: wait mean: %.6f  max: %.6f  idle steps: %.1f%%\n",
+              (double)runner.time_wait_mean, (double)runner.time_wait_max,
+              100. * runner.step_idle_fraction );
+    }
+    if( runner.comm.nmsg_axis[ENV_COMM_AXIS_X] +
+        runner.comm.nmsg_axis[ENV_COMM_AXIS_Y] +
+        runner.comm.nmsg_axis[ENV_COMM_AXIS_Z] +
+        runner.comm.nmsg_axis[ENV_COMM_AXIS_OTHER] > 0 )
+    {
+      const char* axis_name[ENV_COMM_NAXIS] = { "x", "y", "z", "other" };
+      int i = 0;
+      printf( "Messages:" );
+      for( i=0; i<ENV_COMM_NAXIS; ++i )
+      {
+        printf( "  %s: %.0f  GB: %.3f", axis_name[i],
+                runner.comm.nmsg_axis[i], runner.comm.bytes_axis[i] * 1e-9 );
+      }
+      printf( "\nMessages: most to one peer: proc %i to %i  GB: %.3f\n",
+              runner.comm.proc_peer_max, runner.comm.peer_max,
+              runner.comm.bytes_peer_max * 1e-9 );
+      printf( "Message sizes, log2 bytes: count:" );
+      for( i=0; i<ENV_COMM_NBIN; ++i )
+      {
+        if( runner.comm.nmsg_bin[i] > 0 )
+        {
+          printf( "  %i: %.0f", i, runner.comm.nmsg_bin[i] );
+        }
+      }
+      printf( "\n" );
+    }
+    if( runner.time_rebalance > 0 )
+    {
+      printf( "Rebalancing: decomposition changes: %i  time, not in the "
+              "above: %.3f\n", runner.nrebalance,
+              (double)runner.time_rebalance );
+    }
+    if( runner.time_idle_saved > 0 )
+    {
+      printf( "Pipelined iterations: idle time recovered: %.3f\n",
+              (double)runner.time_idle_saved );
+    }
     /*---If invoked with no arguments as part of tester, then ouptut
          pass/fail count banner to be parsed by testing script---*/
     if( argc == 1 )
@@ -65,8 +209,62 @@ int main( int argc, char** argv )
     }
   }
 
+  /*---Print hardware counts if requested, memory peaks and pool use, phase
+       timings if built with the profiler---*/
+
+  FILE* json = NULL;
+
+  if( json_file && Env_is_proc_master( &env ) )
+  {
+    json = fopen( json_file, "w" );
+    Insist( json ? "Unable to open JSON file." : 0 );
+    Results_write_json_begin( json, "sweep", &args );
+    if( ! dry_run && ! is_advising && ! is_predicting_memory )
+    {
+      Results_write_json_runner( json, "result", &runner );
+    }
+  }
+
+  if( ! dry_run && ! is_advising && ! is_predicting_memory &&
+      Env_is_proc_active( &env ) )
+  {
+    Counters_print( &env );
+    MemTracker_print( &env, Bool_false );
+    if( Env_is_proc_master( &env ) )
+    {
+      printf( "Pool, rank 0: %.0f host allocations, %.0f from the cache,"
+              " %.3f MB cached\n", (double) Pool_nallocate(),
+              (double) Pool_nreuse(), (double) Pool_nbyte_cached() * 1e-6 );
+    }
+    Profiler_print( &env );
+    if( json_file )
+    {
+      Profiler_write_json( &env, json );
+    }
+    if( trace_file )
+    {
+      Profiler_trace_write( &env, trace_file );
+    }
+  }
+
+  if( json )
+  {
+    Results_write_json_end( json );
+    fclose( json );
+  }
+
+  if( trace_file )
+  {
+    Profiler_trace_stop();
+  }
+  if( counters )
+  {
+    Counters_stop();
+  }
+
   /*---Deallocations---*/
 
+  DryRun_destroy( &dryrun );
   Runner_destroy( &runner );
   Arguments_destroy( &args );
 
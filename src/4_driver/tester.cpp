@@ -15,14 +15,44 @@
 #include "definitions.h"
 #include "dimensions.h"
 #include "pointer.h"
+#include "memtracker.h"
 #include "quantities.h"
 #include "array_operations.h"
 #include "sweeper.h"
 
 #include "runner.h"
+#include "results.h"
+#include "dryrun.h"
+#include "pool.h"
 
 #define MAX_LINE_LEN 1024
 
+/*---File to which test results are written as JSON, on master only---*/
+
+static FILE* tester_json_ = NULL;
+
+/*===========================================================================*/
+/*---Count a test, and record it in the JSON file---*/
+
+static void record_test_helper( int* ntest, int* ntest_passed,
+    const char* argstring1, const char* argstring2, Bool_t result )
+{
+  if( tester_json_ )
+  {
+    fprintf( tester_json_, "%s\n    { \"args1\": ", *ntest == 0 ? "" : "," );
+    Results_write_json_string( tester_json_, argstring1 );
+    if( argstring2 )
+    {
+      fprintf( tester_json_, ", \"args2\": " );
+      Results_write_json_string( tester_json_, argstring2 );
+    }
+    fprintf( tester_json_, ", \"pass\": %s }", result ? "true" : "false" );
+  }
+
+  *ntest += 1;
+  *ntest_passed += result ? 1 : 0;
+}
+
 /*===========================================================================*/
 
 static void compare_runs_helper( Env* env, int* ntest,
@@ -36,8 +66,246 @@ static void compare_runs_helper( Env* env, int* ntest,
 
   const Bool_t result = compare_runs( argstring1, argstring2, env );
 
-  *ntest += 1;
-  *ntest_passed += result ? 1 : 0;
+  record_test_helper( ntest, ntest_passed, argstring1, argstring2, result );
+}
+
+/*===========================================================================*/
+/*---Perform one run---*/
+
+static void run_case_helper( Env* env, Runner* runner, const char* argstring )
+{
+  Arguments args = Arguments_null();
+
+  Arguments_create_from_string( &args, argstring );
+  Env_set_values( env, &args );
+
+  if( Env_is_proc_master( env ) )
+  {
+    printf( "%s // ", argstring );
+  }
+  if( Env_is_proc_active( env ) )
+  {
+    Runner_run_case( runner, &args, env );
+  }
+
+  Arguments_destroy( &args );
+}
+
+/*===========================================================================*/
+/*---Compare a run without rebalancing to one that changes the
+     decomposition at least once---*/
+
+static void rebalancing_helper( Env* env, int* ntest,
+    int* ntest_passed, const char* string_common, const char* string1, const char* string2 )
+{
+  char argstring1[MAX_LINE_LEN];
+  char argstring2[MAX_LINE_LEN];
+  Runner runner1 = Runner_null();
+  Runner runner2 = Runner_null();
+
+  sprintf( argstring1, "%s %s", string_common, string1 );
+  sprintf( argstring2, "%s %s --is_rebalancing 1", string_common, string2 );
+
+  Runner_create( &runner1 );
+  Runner_create( &runner2 );
+
+  run_case_helper( env, &runner1, argstring1 );
+  run_case_helper( env, &runner2, argstring2 );
+
+  const Bool_t result = Env_is_proc_master( env ) ?
+                        runner1.normsqdiff == P_zero() &&
+                        runner2.normsqdiff == P_zero() &&
+                        runner1.normsq == runner2.normsq &&
+                        runner2.nrebalance > 0 : Bool_false;
+
+  if( Env_is_proc_master( env ) )
+  {
+    printf( "%e %e // rebalanced %i // %s\n", runner1.normsq, runner2.normsq,
+            runner2.nrebalance, result ? "PASS" : "FAIL" );
+  }
+
+  Runner_destroy( &runner1 );
+  Runner_destroy( &runner2 );
+
+  record_test_helper( ntest, ntest_passed, argstring1, argstring2, result );
+}
+
+/*===========================================================================*/
+/*---Run with a confidence target; the iterations performed must lie
+     within the bounds given, and the result must be correct---*/
+
+static void confidence_helper( Env* env, int* ntest,
+    int* ntest_passed, const char* string_common, const char* string1,
+    int niterations_min, int niterations_max )
+{
+  char argstring1[MAX_LINE_LEN];
+  Runner runner1 = Runner_null();
+
+  sprintf( argstring1, "%s %s", string_common, string1 );
+
+  Runner_create( &runner1 );
+
+  run_case_helper( env, &runner1, argstring1 );
+
+  const Bool_t result = Env_is_proc_master( env ) ?
+                        runner1.normsqdiff == P_zero() &&
+                        runner1.niterations >= niterations_min &&
+                        runner1.niterations <= niterations_max : Bool_false;
+
+  if( Env_is_proc_master( env ) )
+  {
+    printf( "%e // iterations %i // %s\n", runner1.normsq,
+            runner1.niterations, result ? "PASS" : "FAIL" );
+  }
+
+  Runner_destroy( &runner1 );
+
+  record_test_helper( ntest, ntest_passed, argstring1, NULL, result );
+}
+
+/*===========================================================================*/
+/*---Predict the memory of a run, then perform it; the peak of the bytes
+     tracked must be as predicted---*/
+
+static void memory_helper( Env* env, int* ntest,
+    int* ntest_passed, const char* string_common, const char* string1 )
+{
+  char argstring1[MAX_LINE_LEN];
+  Arguments args = Arguments_null();
+  Runner runner1 = Runner_null();
+
+  sprintf( argstring1, "%s %s", string_common, string1 );
+
+  size_t nbyte_predicted        = 0;
+  size_t nbyte_device_predicted = 0;
+
+  Arguments_create_from_string( &args, argstring1 );
+  Env_set_values( env, &args );
+
+  if( Env_is_proc_active( env ) )
+  {
+    MemTracker_reset_peak();
+    Runner_predict_memory( &args, env );
+    nbyte_predicted =
+      MemTracker_nbyte_peak( MEMTRACKER_NCATEGORY, Bool_false ) -
+      MemTracker_nbyte( MEMTRACKER_NCATEGORY, Bool_false );
+    nbyte_device_predicted =
+      MemTracker_nbyte_peak( MEMTRACKER_NCATEGORY, Bool_true ) -
+      MemTracker_nbyte( MEMTRACKER_NCATEGORY, Bool_true );
+  }
+
+  Arguments_destroy( &args );
+
+  /*---The run restarts the peaks when it begins; it keeps the state
+       arrays afterward, so the peaks are taken over the bytes before---*/
+
+  Runner_create( &runner1 );
+
+  const size_t nbyte_before =
+    MemTracker_nbyte( MEMTRACKER_NCATEGORY, Bool_false );
+  const size_t nbyte_device_before =
+    MemTracker_nbyte( MEMTRACKER_NCATEGORY, Bool_true );
+
+  run_case_helper( env, &runner1, argstring1 );
+
+  const size_t nbyte_peak =
+    MemTracker_nbyte_peak( MEMTRACKER_NCATEGORY, Bool_false ) -
+    nbyte_before;
+  const size_t nbyte_device_peak =
+    MemTracker_nbyte_peak( MEMTRACKER_NCATEGORY, Bool_true ) -
+    nbyte_device_before;
+
+  const Bool_t result = Env_is_proc_master( env ) ?
+                        runner1.normsqdiff == P_zero() &&
+                        nbyte_predicted == nbyte_peak &&
+                        nbyte_device_predicted == nbyte_device_peak :
+                        Bool_false;
+
+  if( Env_is_proc_master( env ) )
+  {
+    printf( "%e // bytes predicted %.0f  peak %.0f // %s\n",
+            runner1.normsq, (double)nbyte_predicted, (double)nbyte_peak,
+            result ? "PASS" : "FAIL" );
+  }
+
+  Runner_destroy( &runner1 );
+
+  record_test_helper( ntest, ntest_passed, argstring1, NULL, result );
+}
+
+/*===========================================================================*/
+/*---Free a block and allocate one of the same size; the pool must serve it
+     from the cache exactly when caching is on---*/
+
+static void pool_helper( Env* env, int* ntest, int* ntest_passed,
+    const char* argstring1, Bool_t is_reuse_expected )
+{
+  Arguments args = Arguments_null();
+  const size_t nbyte = 100000;
+
+  Arguments_create_from_string( &args, argstring1 );
+  Pool_set_values( &args );
+  Arguments_destroy( &args );
+
+  void* p = Pool_allocate( nbyte );
+  Pool_free( p );
+
+  const size_t nreuse = Pool_nreuse();
+  const size_t nbyte_cached = Pool_nbyte_cached();
+
+  p = Pool_allocate( nbyte );
+  const size_t nreuse_this = Pool_nreuse() - nreuse;
+  Pool_free( p );
+
+  const Bool_t result = is_reuse_expected ?
+                        nreuse_this == 1 && nbyte_cached >= nbyte :
+                        nreuse_this == 0 && nbyte_cached == 0;
+
+  if( Env_is_proc_master( env ) )
+  {
+    printf( "%s // pool reuses %i  bytes cached %.0f // %s\n", argstring1,
+            (int)nreuse_this, (double)nbyte_cached,
+            result ? "PASS" : "FAIL" );
+  }
+
+  /*---Back to the default settings---*/
+
+  args = Arguments_null();
+  Arguments_create_from_string( &args, "--pool_cache_mb 1024" );
+  Pool_set_values( &args );
+  Arguments_destroy( &args );
+
+  record_test_helper( ntest, ntest_passed, argstring1, NULL, result );
+}
+
+/*===========================================================================*/
+/*---Simulate the schedule of all procs of a decomposition; the dry run
+     must find it consistent---*/
+
+static void dry_run_helper( Env* env, int* ntest,
+    int* ntest_passed, const char* string_common, const char* string1 )
+{
+  char argstring1[MAX_LINE_LEN];
+  Arguments args = Arguments_null();
+  DryRun dryrun = DryRun_null();
+
+  sprintf( argstring1, "%s %s", string_common, string1 );
+
+  Arguments_create_from_string( &args, argstring1 );
+  DryRun_create( &dryrun, &args );
+
+  Bool_t result = Bool_false;
+
+  if( Env_is_proc_master( env ) )
+  {
+    printf( "%s // dry run\n", argstring1 );
+    result = DryRun_run( &dryrun, 1 );
+  }
+
+  DryRun_destroy( &dryrun );
+  Arguments_destroy( &args );
+
+  record_test_helper( ntest, ntest_passed, argstring1, NULL, result );
 }
 
 /*===========================================================================*/
@@ -95,6 +363,58 @@ static void test_serial( Env* env, int* ntest, int* ntest_passed )
       }
       }
     }
+
+    /*---Memory predicted without allocating---*/
+
+    const char* string_common_mem = "--ncell_x 6 --ncell_y 5 --ncell_z 7"
+                                    " --ne 3 --na 7";
+
+    memory_helper( env, ntest, ntest_passed, string_common_mem, "" );
+    memory_helper( env, ntest, ntest_passed, string_common_mem,
+      "--nblock_z 3 --is_block_z_tapered 1" );
+    memory_helper( env, ntest, ntest_passed, string_common_mem,
+      "--nblock_x 2 --nblock_y 2" );
+    memory_helper( env, ntest, ntest_passed, string_common_mem,
+      "--nblock_z 2 --nangle_set 3" );
+    memory_helper( env, ntest, ntest_passed, string_common_mem,
+      "--is_face_comm_async 0 --nangle_set 2" );
+
+    /*---Host memory pool---*/
+
+    pool_helper( env, ntest, ntest_passed, "--pool_cache_mb 1", Bool_true );
+    pool_helper( env, ntest, ntest_passed, "--pool_cache_mb 0", Bool_false );
+
+    /*---Iterations added for a confidence target stay within bounds; a
+         target never met stops at the maximum, a loose one at the
+         minimum---*/
+
+    confidence_helper( env, ntest, ntest_passed, "--ncell_x 5 --ncell_y 4 "
+      "--ncell_z 5 --ne 3 --na 7", "--niterations 3 --niterations_max 5 "
+      "--rel_confidence 1e-12", 5, 5 );
+    confidence_helper( env, ntest, ntest_passed, "--ncell_x 5 --ncell_y 4 "
+      "--ncell_z 5 --ne 3 --na 7", "--niterations 2 --niterations_max 5 "
+      "--rel_confidence 100", 2, 2 );
+
+    /*---Schedules of procs this run does not have---*/
+
+    char string_common[] = "--ncell_x 8 --ncell_y 6 --ncell_z 8 --ne 3 "
+                           "--na 7 --nproc_x 2 --nproc_y 2";
+
+    dry_run_helper( env, ntest, ntest_passed, string_common,
+      "--nproc_z 2 --nblock_z 2" );
+    dry_run_helper( env, ntest, ntest_passed, string_common,
+      "--nblock_z 2 --nangle_set 3" );
+    dry_run_helper( env, ntest, ntest_passed, string_common,
+      "--nblock_z 2 --nproc_octant 4" );
+    dry_run_helper( env, ntest, ntest_passed, string_common,
+      "--nblock_z 2 --nproc_octant 2 --nthread_octant 2" );
+    dry_run_helper( env, ntest, ntest_passed, string_common,
+      "--nblock_z 2 --is_iteration_pipelined 1 --niterations 3" );
+    dry_run_helper( env, ntest, ntest_passed, string_common,
+      "--nblock_z 2 --nblock_x 2 --nblock_y 3" );
+    dry_run_helper( env, ntest, ntest_passed, string_common,
+      "--nproc_z 2 --nblock_z 2 --nblock_x 2 --nangle_set 2 "
+      "--is_iteration_pipelined 1 --niterations 2" );
   }
 }
 
@@ -439,6 +759,25 @@ static void test_mpi( Env* env, int* ntest, int* ntest_passed )
         "--nproc_x 1 --nproc_y 1 --nblock_z 1",
         "--nproc_x 4 --nproc_y 4 --nblock_z 2" );
 
+    compare_runs_helper( env, ntest, ntest_passed, string_common_2,
+        "--nproc_x 4 --nproc_y 4 --nblock_z 2",
+        "--nproc_x 4 --nproc_y 4 --nblock_z 2 --is_face_comm_shm 1" );
+
+    compare_runs_helper( env, ntest, ntest_passed, string_common_2,
+        "--nproc_x 2 --nproc_y 2 --nproc_z 4 --nblock_z 1",
+        "--nproc_x 2 --nproc_y 2 --nproc_z 4 --nblock_z 1"
+                                                " --is_face_comm_shm 1" );
+
+    compare_runs_helper( env, ntest, ntest_passed, string_common_2,
+        "--nproc_x 4 --nproc_y 4 --nblock_z 2 --nangle_set 3",
+        "--nproc_x 4 --nproc_y 4 --nblock_z 2 --nangle_set 3"
+                                                " --is_face_comm_shm 1" );
+
+    compare_runs_helper( env, ntest, ntest_passed, string_common_2,
+        "--nproc_x 2 --nproc_y 2 --nproc_octant 4 --nblock_z 2",
+        "--nproc_x 2 --nproc_y 2 --nproc_octant 4 --nblock_z 2"
+                                                " --is_face_comm_shm 1" );
+
     const char* string_common_4 = "--ncell_x 5 --ncell_y 8 --ncell_z 16"
                                   " --ne 9 --na 12";
 
@@ -449,6 +788,108 @@ static void test_mpi( Env* env, int* ntest, int* ntest_passed )
     compare_runs_helper( env, ntest, ntest_passed, string_common_4,
         "--nproc_x 4 --nproc_y 4 --nblock_z 2",
         "--nproc_x 4 --nproc_y 4 --nblock_z 4" );
+
+    const char* string_common_5 = "--ncell_x  5 --ncell_y  4 --ncell_z 16"
+                                  " --ne 7 --na 10";
+
+    compare_runs_helper( env, ntest, ntest_passed, string_common_5,
+        "--nproc_x 1 --nproc_y 1 --nproc_z 1 --nblock_z 1",
+        "--nproc_x 2 --nproc_y 2 --nproc_z 4 --nblock_z 2" );
+
+    compare_runs_helper( env, ntest, ntest_passed, string_common_5,
+        "--nproc_x 4 --nproc_y 4 --nblock_z 4 --is_face_comm_async 0",
+        "--nproc_x 1 --nproc_y 4 --nproc_z 4 --nblock_z 2"
+                                        " --is_face_comm_async 0" );
+
+    const char* string_common_6 = "--ncell_x 12 --ncell_y  8 --ncell_z  4"
+                                  " --ne 5 --na 10 --nblock_z 2";
+
+    compare_runs_helper( env, ntest, ntest_passed, string_common_6,
+        "--nproc_x 4 --nproc_y 4",
+        "--nproc_x 4 --nproc_y 4 --weights_x 1,3,1,2 --cuts_y 1,2,5" );
+
+    compare_runs_helper( env, ntest, ntest_passed, string_common_6,
+        "--nproc_x 4 --nproc_y 4 --niterations 3",
+        "--nproc_x 4 --nproc_y 4 --niterations 3 --weights_y 5,1,1,1"
+                                                     " --is_rebalancing 1" );
+
+    rebalancing_helper( env, ntest, ntest_passed, string_common_6,
+        "--nproc_x 4 --nproc_y 4 --niterations 3",
+        "--nproc_x 4 --nproc_y 4 --niterations 3 --weights_x 1,1,1,5"
+                                                  " --weights_y 5,1,1,1" );
+
+    memory_helper( env, ntest, ntest_passed, string_common_5,
+        "--nproc_x 2 --nproc_y 2 --nproc_z 2 --nblock_z 2 --nangle_set 2" );
+
+    memory_helper( env, ntest, ntest_passed, string_common_6,
+        "--nproc_x 2 --nproc_y 4 --nblock_x 2 --nblock_y 2" );
+
+    memory_helper( env, ntest, ntest_passed, string_common_6,
+        "--nproc_x 4 --nproc_y 4 --is_face_comm_async 0" );
+
+    confidence_helper( env, ntest, ntest_passed, string_common_6,
+        "--nproc_x 4 --nproc_y 4 --niterations 2 --niterations_max 4"
+                                           " --rel_confidence 1e-3", 2, 4 );
+
+    compare_runs_helper( env, ntest, ntest_passed, string_common_2,
+        "--nproc_x 1 --nproc_y 1 --nblock_z 1",
+        "--nproc_x 2 --nproc_y 2 --nproc_e 4 --nblock_z 2" );
+
+    compare_runs_helper( env, ntest, ntest_passed, string_common_5,
+        "--nproc_x 4 --nproc_y 4 --nblock_z 2",
+        "--nproc_x 2 --nproc_y 2 --nproc_z 2 --nproc_e 2 --nblock_z 2" );
+
+    compare_runs_helper( env, ntest, ntest_passed, string_common_4,
+        "--nproc_x 4 --nproc_y 4 --nblock_z 2",
+        "--nproc_x 2 --nproc_y 2 --nproc_octant 4 --nblock_z 2" );
+
+    compare_runs_helper( env, ntest, ntest_passed, string_common_5,
+        "--nproc_x 1 --nproc_y 1 --nblock_z 1 --niterations 2",
+        "--nproc_x 1 --nproc_y 2 --nproc_z 2 --nproc_octant 2 --nblock_z 4"
+                                                         " --niterations 2" );
+
+    compare_runs_helper( env, ntest, ntest_passed, string_common_2,
+        "--nproc_x 4 --nproc_y 4 --nblock_z 2",
+        "--nproc_x 4 --nproc_y 4 --nblock_z 2 --nangle_set 3" );
+
+    compare_runs_helper( env, ntest, ntest_passed, string_common_5,
+        "--nproc_x 1 --nproc_y 1 --nproc_z 1 --nblock_z 1",
+        "--nproc_x 2 --nproc_y 2 --nproc_z 4 --nblock_z 2 --nangle_set 2"
+                                                " --is_face_comm_async 0" );
+
+    compare_runs_helper( env, ntest, ntest_passed, string_common_5,
+        "--nproc_x 2 --nproc_y 2 --nproc_z 4 --nblock_z 2"
+                                          " --is_octant_order_optimized 0",
+        "--nproc_x 2 --nproc_y 2 --nproc_z 4 --nblock_z 2" );
+
+    compare_runs_helper( env, ntest, ntest_passed, string_common_5,
+        "--nproc_x 2 --nproc_y 4 --nblock_z 2"
+                                          " --is_octant_order_optimized 0",
+        "--nproc_x 2 --nproc_y 4 --nblock_z 2" );
+
+    compare_runs_helper( env, ntest, ntest_passed, string_common_5,
+        "--nproc_x 1 --nproc_y 1 --nproc_z 1 --nblock_z 1",
+        "--nproc_x 2 --nproc_y 2 --nproc_z 2 --nblock_z 3"
+                                                " --is_block_z_tapered 1" );
+
+    compare_runs_helper( env, ntest, ntest_passed, string_common_5,
+        "--nproc_x 2 --nproc_y 2 --nproc_z 2 --nblock_z 2 --niterations 3",
+        "--nproc_x 2 --nproc_y 2 --nproc_z 2 --nblock_z 2 --niterations 3"
+                                            " --is_iteration_pipelined 1" );
+
+    compare_runs_helper( env, ntest, ntest_passed, string_common_5,
+        "--nproc_x 1 --nproc_y 1 --nproc_z 1 --nblock_z 1",
+        "--nproc_x 2 --nproc_y 2 --nproc_z 2 --nblock_z 2"
+                                           " --nblock_x 2 --nblock_y 2" );
+
+    compare_runs_helper( env, ntest, ntest_passed, string_common_6,
+        "--nproc_x 1 --nproc_y 1",
+        "--nproc_x 2 --nproc_y 4 --nblock_x 3 --nblock_y 2" );
+
+    compare_runs_helper( env, ntest, ntest_passed, string_common_6,
+        "--nproc_x 1 --nproc_y 1",
+        "--nproc_x 4 --nproc_y 2 --nblock_x 1 --nblock_y 4"
+                                                    " --nangle_set 2" );
   }
 }
 
@@ -572,6 +1013,12 @@ static void tester( Env* env )
     printf( "TESTS %i    PASSED %i    FAILED %i\n",
             ntest, ntest_passed, ntest-ntest_passed );
   }
+
+  if( tester_json_ )
+  {
+    fprintf( tester_json_, "\n  ],\n  \"ntest\": %i,\n  \"ntest_passed\": %i",
+             ntest, ntest_passed );
+  }
 }
 
 /*===========================================================================*/
@@ -588,10 +1035,42 @@ int main( int argc, char** argv )
 
   Env_initialize( &env, argc, argv );
 
+  /*---Optionally write results as JSON---*/
+
+  Arguments args = Arguments_null();
+
+  Arguments_create( &args, argc, argv );
+
+  const char* json_file = Arguments_consume_string_or_default( &args,
+                                                            "--json", NULL );
+  Env_set_values( &env, &args );
+
+  Insist( Arguments_are_all_consumed( &args )
+                                          ? "Invalid argument detected." : 0 );
+
+  if( json_file && Env_is_proc_master( &env ) )
+  {
+    tester_json_ = fopen( json_file, "w" );
+    Insist( tester_json_ ? "Unable to open JSON file." : 0 );
+    Results_write_json_begin( tester_json_, "tester", &args );
+    fprintf( tester_json_, ",\n  \"tests\": [" );
+  }
+
   /*---Do testing---*/
 
   tester( &env );
 
+  if( tester_json_ )
+  {
+    Results_write_json_end( tester_json_ );
+    fclose( tester_json_ );
+    tester_json_ = NULL;
+  }
+
+  /*---Deallocations---*/
+
+  Arguments_destroy( &args );
+
   /*---Finalize execution---*/
 
   Env_finalize( &env );